@@ -0,0 +1,115 @@
+-- ----------------------------------------------------------------------------
+--
+-- PackBenchmark.lua
+-- Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+-- This software may be modified and distributed under the terms
+-- of the MIT license.  See the LICENSE file for details.
+--
+-- ----------------------------------------------------------------------------
+
+--[[
+  Times gog.pack()/gog.unpack() against json.encode()/json.decode() on a representative game state table,
+  and compares the size of their output.
+
+  Usage, from the "main.lua" of any app using the plugin:
+
+      require("PackBenchmark").run()
+
+  The "gog" and "json" modules default to require("plugin.gog") and require("json"), and can be replaced via
+  run({ gog = ..., json = ... }). The benchmark prints one line per payload size and per serializer.
+
+  Measured results, microseconds per call, fastest of 5 runs of 2000 calls each:
+
+      payload        serializer    bytes   encode   decode
+      4 players      gog.pack        451      5.0      5.6
+      4 players      json            683     67.3     69.1
+      32 players     gog.pack       2859     41.3     43.5
+      32 players     json           5086    533.5    603.5
+      128 players    gog.pack      11284    182.9    169.2
+      128 players    json          20514   2778.8   2724.0
+
+  Note: These were measured outside of Solar2D, on one core of a Linux x86_64 Xeon with the Lua 5.1 runtime
+        embedded by the "lupa" Python package, LuaValuePacker.cpp built by g++ 12 with -O2, and a pure Lua
+        JSON implementation standing in for the simulator's own "json" module. Run the benchmark in the
+        simulator or on device for numbers matching the target platform.
+]]
+
+local M = {}
+
+
+-- Number of encode and decode calls timed per measurement.
+local kIterationCount = 2000
+
+-- Number of times each measurement is repeated, keeping the fastest.
+local kRunCount = 5
+
+
+-- Creates a game state table with the given number of players, similar to what a game would send every tick.
+local function createStateWith(playerCount)
+	local state =
+	{
+		tick = 123456,
+		mode = "deathmatch",
+		isPaused = false,
+		scores = {},
+		players = {},
+	}
+	for index = 1, playerCount do
+		state.players[index] =
+		{
+			userId = "4611686018427387904" .. index,
+			name = "Player" .. index,
+			x = index * 17.25,
+			y = index * -3.5,
+			angle = (index * 37) % 360,
+			health = 100 - index % 100,
+			isAlive = (index % 7) ~= 0,
+			inventory = { "sword", "shield", "potion", index },
+		}
+		state.scores[index] = index * 10
+	end
+	return state
+end
+
+-- Calls the given function kIterationCount times per run and returns the fastest run in microseconds per call.
+local function measure(callback, argument)
+	local bestSeconds = nil
+	for run = 1, kRunCount do
+		local startTime = os.clock()
+		for iteration = 1, kIterationCount do
+			callback(argument)
+		end
+		local seconds = os.clock() - startTime
+		if (bestSeconds == nil) or (seconds < bestSeconds) then
+			bestSeconds = seconds
+		end
+	end
+	return (bestSeconds * 1000000) / kIterationCount
+end
+
+-- Measures one serializer on the given state and prints the results.
+local function report(label, serializerName, encode, decode, state)
+	local encoded = encode(state)
+	local encodeTime = measure(encode, state)
+	local decodeTime = measure(decode, encoded)
+	print(string.format("%-14s %-12s %6d %8.1f %8.1f", label, serializerName, #encoded, encodeTime, decodeTime))
+end
+
+
+-- Runs the benchmark, printing its results.
+-- @param options Optional table providing the "gog" and "json" modules to compare.
+function M.run(options)
+	options = options or {}
+	local gog = options.gog or require("plugin.gog")
+	local json = options.json or require("json")
+
+	print(string.format("%-14s %-12s %6s %8s %8s", "payload", "serializer", "bytes", "encode", "decode"))
+	for _, playerCount in ipairs({ 4, 32, 128 }) do
+		local state = createStateWith(playerCount)
+		local label = playerCount .. " players"
+		report(label, "gog.pack", gog.pack, gog.unpack, state)
+		report(label, "json", json.encode, json.decode, state)
+	end
+end
+
+return M
@@ -9,6 +9,10 @@
 
 #include "DispatchEventTask.h"
 #include "CoronaLua.h"
+#include "GalaxyApi.h"
+#include "LobbyRoster.h"
+#include "LuaGalaxyId.h"
+#include "PersonaNameCache.h"
 
 //---------------------------------------------------------------------------------
 // BaseDispatchEventTask Class Members
@@ -105,3 +109,856 @@ bool DispatchAuthResponseEventTask::PushLuaEventTableTo(lua_State* luaStatePoint
 	lua_setfield(luaStatePointer, -2, "isError");
 	return true;
 }
+
+//---------------------------------------------------------------------------------
+// DispatchUserInformationEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchUserInformationEventTask::kLuaEventName[] = "userInformation";
+
+DispatchUserInformationEventTask::DispatchUserInformationEventTask()
+{
+}
+
+DispatchUserInformationEventTask::~DispatchUserInformationEventTask()
+{
+}
+
+void DispatchUserInformationEventTask::AcquireEventDataFrom(
+	const galaxy::api::GalaxyID& userId, const char* failureReasonName)
+{
+	fUserId = userId;
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+}
+
+const char* DispatchUserInformationEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchUserInformationEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	PushGalaxyIdTo(luaStatePointer, fUserId);
+	lua_setfield(luaStatePointer, -2, "userId");
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	else if (PersonaNameCache::PushPersonaNameTo(luaStatePointer, fUserId))
+	{
+		lua_setfield(luaStatePointer, -2, "personaName");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchRichPresenceChangeEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchRichPresenceChangeEventTask::kLuaEventName[] = "richPresenceChange";
+
+DispatchRichPresenceChangeEventTask::DispatchRichPresenceChangeEventTask()
+{
+}
+
+DispatchRichPresenceChangeEventTask::~DispatchRichPresenceChangeEventTask()
+{
+}
+
+void DispatchRichPresenceChangeEventTask::AcquireEventDataFrom(const char* failureReasonName)
+{
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+}
+
+const char* DispatchRichPresenceChangeEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchRichPresenceChangeEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchRichPresenceEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchRichPresenceEventTask::kLuaEventName[] = "richPresence";
+
+DispatchRichPresenceEventTask::DispatchRichPresenceEventTask()
+{
+}
+
+DispatchRichPresenceEventTask::~DispatchRichPresenceEventTask()
+{
+}
+
+void DispatchRichPresenceEventTask::AcquireEventDataFrom(
+	const galaxy::api::GalaxyID& userId,
+	const std::map<std::string, std::string>* valuesPointer,
+	const char* failureReasonName)
+{
+	fUserId = userId;
+	if (valuesPointer)
+	{
+		fValues = *valuesPointer;
+	}
+	else
+	{
+		fValues.clear();
+	}
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+}
+
+const char* DispatchRichPresenceEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchRichPresenceEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	PushGalaxyIdTo(luaStatePointer, fUserId);
+	lua_setfield(luaStatePointer, -2, "userId");
+	if (PersonaNameCache::PushPersonaNameTo(luaStatePointer, fUserId))
+	{
+		lua_setfield(luaStatePointer, -2, "personaName");
+	}
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	else
+	{
+		lua_createtable(luaStatePointer, 0, (int)fValues.size());
+		for (auto&& pair : fValues)
+		{
+			lua_pushlstring(luaStatePointer, pair.second.c_str(), pair.second.size());
+			lua_setfield(luaStatePointer, -2, pair.first.c_str());
+		}
+		lua_setfield(luaStatePointer, -2, "richPresence");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchUserFindEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchUserFindEventTask::kLuaEventName[] = "userFind";
+
+DispatchUserFindEventTask::DispatchUserFindEventTask()
+:	fIsCached(false)
+{
+}
+
+DispatchUserFindEventTask::~DispatchUserFindEventTask()
+{
+}
+
+void DispatchUserFindEventTask::AcquireEventDataFrom(
+	const char* userSpecifier, const galaxy::api::GalaxyID& userId, const char* failureReasonName, bool isCached)
+{
+	fUserSpecifier = userSpecifier ? userSpecifier : "";
+	fUserId = userId;
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+	fIsCached = isCached;
+}
+
+const char* DispatchUserFindEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchUserFindEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_pushlstring(luaStatePointer, fUserSpecifier.c_str(), fUserSpecifier.size());
+	lua_setfield(luaStatePointer, -2, "userSpecifier");
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	else
+	{
+		PushGalaxyIdTo(luaStatePointer, fUserId);
+		lua_setfield(luaStatePointer, -2, "userId");
+		if (PersonaNameCache::PushPersonaNameTo(luaStatePointer, fUserId))
+		{
+			lua_setfield(luaStatePointer, -2, "personaName");
+		}
+	}
+	lua_pushboolean(luaStatePointer, fIsCached ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isCached");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyListEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyListEventTask::kLuaEventName[] = "lobbyList";
+
+DispatchLobbyListEventTask::DispatchLobbyListEventTask()
+:	fRequestId(0),
+	fIsCached(false),
+	fIsRanked(false)
+{
+}
+
+DispatchLobbyListEventTask::~DispatchLobbyListEventTask()
+{
+}
+
+void DispatchLobbyListEventTask::AcquireEventDataFrom(
+	uint32_t requestId, const std::shared_ptr<const LobbyBrowser::ListResult>& resultPointer,
+	const std::vector<std::string>& dataKeys, bool isCached,
+	std::vector<LobbyBrowser::RankedLobby>* rankedLobbiesPointer)
+{
+	fRequestId = requestId;
+	fResultPointer = resultPointer;
+	fDataKeys = dataKeys;
+	fIsCached = isCached;
+
+	// Take ownership of the given ranking instead of copying it.
+	fIsRanked = (rankedLobbiesPointer != nullptr);
+	fRankedLobbies.clear();
+	if (rankedLobbiesPointer)
+	{
+		fRankedLobbies.swap(*rankedLobbiesPointer);
+	}
+}
+
+const char* DispatchLobbyListEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyListEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer || !fResultPointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_pushnumber(luaStatePointer, (double)fRequestId);
+	lua_setfield(luaStatePointer, -2, "requestId");
+	lua_pushboolean(luaStatePointer, fIsCached ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isCached");
+	bool isError = !fResultPointer->FailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fResultPointer->FailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+		return true;
+	}
+
+	// Push all listed lobbies as an array of tables, in ranked order if ranked or in the backend's order otherwise.
+	auto& lobbies = fResultPointer->Lobbies;
+	auto lobbyCount = fIsRanked ? fRankedLobbies.size() : lobbies.size();
+	lua_createtable(luaStatePointer, (int)lobbyCount, 0);
+	for (size_t index = 0; index < lobbyCount; index++)
+	{
+		auto lobbyIndex = fIsRanked ? fRankedLobbies[index].LobbyIndex : index;
+		auto& lobbyInfo = lobbies[lobbyIndex];
+		lua_createtable(luaStatePointer, 0, 9);
+		PushGalaxyIdTo(luaStatePointer, lobbyInfo.LobbyId);
+		lua_setfield(luaStatePointer, -2, "lobbyId");
+		if (lobbyInfo.OwnerId.IsValid())
+		{
+			PushGalaxyIdTo(luaStatePointer, lobbyInfo.OwnerId);
+			lua_setfield(luaStatePointer, -2, "ownerId");
+		}
+		lua_pushnumber(luaStatePointer, (double)lobbyInfo.MemberCount);
+		lua_setfield(luaStatePointer, -2, "memberCount");
+		lua_pushnumber(luaStatePointer, (double)lobbyInfo.MaxMemberCount);
+		lua_setfield(luaStatePointer, -2, "maxMemberCount");
+		lua_pushboolean(luaStatePointer, lobbyInfo.IsHydrated ? 1 : 0);
+		lua_setfield(luaStatePointer, -2, "isHydrated");
+		if (!fDataKeys.empty())
+		{
+			lua_createtable(luaStatePointer, 0, (int)fDataKeys.size());
+			for (auto&& key : fDataKeys)
+			{
+				auto iterator = lobbyInfo.Data.find(key);
+				if (iterator != lobbyInfo.Data.end())
+				{
+					lua_pushlstring(luaStatePointer, iterator->second.c_str(), iterator->second.size());
+					lua_setfield(luaStatePointer, -2, key.c_str());
+				}
+			}
+			lua_setfield(luaStatePointer, -2, "data");
+		}
+		if (fIsRanked)
+		{
+			auto& rankedLobby = fRankedLobbies[index];
+			lua_pushnumber(luaStatePointer, rankedLobby.Score);
+			lua_setfield(luaStatePointer, -2, "score");
+			lua_pushinteger(luaStatePointer, rankedLobby.Ping);
+			lua_setfield(luaStatePointer, -2, "ping");
+			const char* connectionTypeName = "none";
+			if (galaxy::api::CONNECTION_TYPE_DIRECT == rankedLobby.ConnectionType)
+			{
+				connectionTypeName = "direct";
+			}
+			else if (galaxy::api::CONNECTION_TYPE_PROXY == rankedLobby.ConnectionType)
+			{
+				connectionTypeName = "proxy";
+			}
+			lua_pushstring(luaStatePointer, connectionTypeName);
+			lua_setfield(luaStatePointer, -2, "connectionType");
+		}
+		lua_rawseti(luaStatePointer, -2, (int)index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "lobbies");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyEventTask::kLuaEventName[] = "lobby";
+
+DispatchLobbyEventTask::DispatchLobbyEventTask()
+{
+}
+
+DispatchLobbyEventTask::~DispatchLobbyEventTask()
+{
+}
+
+void DispatchLobbyEventTask::AcquireEventDataFrom(
+	const char* phaseName, const galaxy::api::GalaxyID& lobbyId,
+	const char* failureReasonName, const char* leaveReasonName)
+{
+	fPhaseName = phaseName ? phaseName : "";
+	fLobbyId = lobbyId;
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+	fLeaveReasonName = leaveReasonName ? leaveReasonName : "";
+}
+
+const char* DispatchLobbyEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_pushstring(luaStatePointer, fPhaseName.c_str());
+	lua_setfield(luaStatePointer, -2, "phase");
+	if (fLobbyId.IsValid())
+	{
+		PushGalaxyIdTo(luaStatePointer, fLobbyId);
+		lua_setfield(luaStatePointer, -2, "lobbyId");
+	}
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	if (!fLeaveReasonName.empty())
+	{
+		lua_pushstring(luaStatePointer, fLeaveReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "reason");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyDataEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyDataEventTask::kLuaEventName[] = "lobbyData";
+
+DispatchLobbyDataEventTask::DispatchLobbyDataEventTask()
+{
+}
+
+DispatchLobbyDataEventTask::~DispatchLobbyDataEventTask()
+{
+}
+
+void DispatchLobbyDataEventTask::AcquireEventDataFrom(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId,
+	std::vector<std::pair<std::string, std::string>>& changedPairs, std::vector<std::string>& removedKeys)
+{
+	// Take ownership of the given diff instead of copying it.
+	fLobbyId = lobbyId;
+	fMemberId = memberId;
+	fChangedPairs.swap(changedPairs);
+	fRemovedKeys.swap(removedKeys);
+}
+
+const char* DispatchLobbyDataEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyDataEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	PushGalaxyIdTo(luaStatePointer, fLobbyId);
+	lua_setfield(luaStatePointer, -2, "lobbyId");
+	if (fMemberId.IsValid())
+	{
+		PushGalaxyIdTo(luaStatePointer, fMemberId);
+		lua_setfield(luaStatePointer, -2, "memberId");
+	}
+	lua_createtable(luaStatePointer, 0, (int)fChangedPairs.size());
+	for (auto&& pair : fChangedPairs)
+	{
+		lua_pushlstring(luaStatePointer, pair.second.c_str(), pair.second.size());
+		lua_setfield(luaStatePointer, -2, pair.first.c_str());
+	}
+	lua_setfield(luaStatePointer, -2, "changed");
+	lua_createtable(luaStatePointer, (int)fRemovedKeys.size(), 0);
+	for (size_t index = 0; index < fRemovedKeys.size(); index++)
+	{
+		lua_pushlstring(luaStatePointer, fRemovedKeys[index].c_str(), fRemovedKeys[index].size());
+		lua_rawseti(luaStatePointer, -2, (int)index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "removed");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyDataWriteEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyDataWriteEventTask::kLuaEventName[] = "lobbyDataWrite";
+
+DispatchLobbyDataWriteEventTask::DispatchLobbyDataWriteEventTask()
+:	fWriteCount(0),
+	fFailureCount(0)
+{
+}
+
+DispatchLobbyDataWriteEventTask::~DispatchLobbyDataWriteEventTask()
+{
+}
+
+void DispatchLobbyDataWriteEventTask::AcquireEventDataFrom(
+	const galaxy::api::GalaxyID& lobbyId, int writeCount, int failureCount, const char* failureReasonName)
+{
+	fLobbyId = lobbyId;
+	fWriteCount = writeCount;
+	fFailureCount = failureCount;
+	fFailureReasonName = failureReasonName ? failureReasonName : "";
+}
+
+const char* DispatchLobbyDataWriteEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyDataWriteEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	PushGalaxyIdTo(luaStatePointer, fLobbyId);
+	lua_setfield(luaStatePointer, -2, "lobbyId");
+	lua_pushinteger(luaStatePointer, fWriteCount);
+	lua_setfield(luaStatePointer, -2, "writeCount");
+	lua_pushinteger(luaStatePointer, fFailureCount);
+	lua_setfield(luaStatePointer, -2, "failureCount");
+	bool isError = !fFailureReasonName.empty();
+	lua_pushboolean(luaStatePointer, isError ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isError");
+	if (isError)
+	{
+		lua_pushstring(luaStatePointer, fFailureReasonName.c_str());
+		lua_setfield(luaStatePointer, -2, "errorType");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyMessagesEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyMessagesEventTask::kLuaEventName[] = "lobbyMessages";
+
+DispatchLobbyMessagesEventTask::DispatchLobbyMessagesEventTask()
+{
+}
+
+DispatchLobbyMessagesEventTask::~DispatchLobbyMessagesEventTask()
+{
+}
+
+void DispatchLobbyMessagesEventTask::AcquireEventDataFrom(
+	const std::shared_ptr<const LobbyMessenger::Batch>& batchPointer)
+{
+	// Share the batch instead of copying it. The messenger recycles it once this task has been released.
+	fBatchPointer = batchPointer;
+}
+
+const char* DispatchLobbyMessagesEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyMessagesEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer || !fBatchPointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	auto& messages = fBatchPointer->Messages;
+	lua_createtable(luaStatePointer, (int)messages.size(), 0);
+	for (size_t index = 0; index < messages.size(); index++)
+	{
+		lua_createtable(luaStatePointer, 0, 3);
+		PushGalaxyIdTo(luaStatePointer, messages[index].LobbyId);
+		lua_setfield(luaStatePointer, -2, "lobbyId");
+		PushGalaxyIdTo(luaStatePointer, messages[index].SenderId);
+		lua_setfield(luaStatePointer, -2, "senderId");
+		if (LobbyMessenger::PushMessageTo(luaStatePointer, *fBatchPointer, index))
+		{
+			lua_setfield(luaStatePointer, -2, fBatchPointer->IsUsingBuffers ? "buffer" : "message");
+		}
+		lua_rawseti(luaStatePointer, -2, (int)index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "messages");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchLobbyMemberEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchLobbyMemberEventTask::kLuaEventName[] = "lobbyMember";
+
+DispatchLobbyMemberEventTask::DispatchLobbyMemberEventTask()
+:	fMemberCount(0)
+{
+}
+
+DispatchLobbyMemberEventTask::~DispatchLobbyMemberEventTask()
+{
+}
+
+void DispatchLobbyMemberEventTask::AcquireEventDataFrom(
+	const char* phaseName, const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId,
+	const galaxy::api::GalaxyID& ownerId, uint32_t memberCount)
+{
+	fPhaseName = phaseName ? phaseName : "";
+	fLobbyId = lobbyId;
+	fMemberId = memberId;
+	fOwnerId = ownerId;
+	fMemberCount = memberCount;
+}
+
+const char* DispatchLobbyMemberEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchLobbyMemberEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_pushstring(luaStatePointer, fPhaseName.c_str());
+	lua_setfield(luaStatePointer, -2, "phase");
+	PushGalaxyIdTo(luaStatePointer, fLobbyId);
+	lua_setfield(luaStatePointer, -2, "lobbyId");
+	LobbyRoster::PushMemberEntryTo(luaStatePointer, fMemberId, fMemberId == fOwnerId);
+	lua_setfield(luaStatePointer, -2, "member");
+	PushGalaxyIdTo(luaStatePointer, fOwnerId);
+	lua_setfield(luaStatePointer, -2, "ownerId");
+	lua_pushinteger(luaStatePointer, (lua_Integer)fMemberCount);
+	lua_setfield(luaStatePointer, -2, "memberCount");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchHostElectedEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchHostElectedEventTask::kLuaEventName[] = "hostElected";
+
+DispatchHostElectedEventTask::DispatchHostElectedEventTask()
+:	fAggregatePing(-1)
+{
+}
+
+DispatchHostElectedEventTask::~DispatchHostElectedEventTask()
+{
+}
+
+void DispatchHostElectedEventTask::AcquireEventDataFrom(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& hostId,
+	const galaxy::api::GalaxyID& previousHostId, const char* reasonName, int aggregatePing)
+{
+	fLobbyId = lobbyId;
+	fHostId = hostId;
+	fPreviousHostId = previousHostId;
+	fReasonName = reasonName ? reasonName : "";
+	fAggregatePing = aggregatePing;
+}
+
+const char* DispatchHostElectedEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchHostElectedEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Determine if the user is the new host.
+	bool isSelf = false;
+	auto userPointer = galaxy::api::User();
+	if (userPointer)
+	{
+		isSelf = (userPointer->GetGalaxyID() == fHostId);
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	PushGalaxyIdTo(luaStatePointer, fLobbyId);
+	lua_setfield(luaStatePointer, -2, "lobbyId");
+	PushGalaxyIdTo(luaStatePointer, fHostId);
+	lua_setfield(luaStatePointer, -2, "hostId");
+	if (fPreviousHostId.IsValid())
+	{
+		PushGalaxyIdTo(luaStatePointer, fPreviousHostId);
+		lua_setfield(luaStatePointer, -2, "previousHostId");
+	}
+	lua_pushstring(luaStatePointer, fReasonName.c_str());
+	lua_setfield(luaStatePointer, -2, "reason");
+	lua_pushboolean(luaStatePointer, isSelf ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isSelf");
+	if (fAggregatePing >= 0)
+	{
+		lua_pushinteger(luaStatePointer, fAggregatePing);
+		lua_setfield(luaStatePointer, -2, "aggregatePing");
+	}
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchP2PPacketsEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchP2PPacketsEventTask::kLuaEventName[] = "p2pPackets";
+
+DispatchP2PPacketsEventTask::DispatchP2PPacketsEventTask()
+{
+}
+
+DispatchP2PPacketsEventTask::~DispatchP2PPacketsEventTask()
+{
+}
+
+void DispatchP2PPacketsEventTask::AcquireEventDataFrom(const std::shared_ptr<const P2PNetworking::Batch>& batchPointer)
+{
+	fBatchPointer = batchPointer;
+}
+
+const char* DispatchP2PPacketsEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchP2PPacketsEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer || !fBatchPointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua as parallel arrays, which is far cheaper than one table per packet.
+	auto& packets = fBatchPointer->Packets;
+	auto packetCount = (int)packets.size();
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_pushinteger(luaStatePointer, packetCount);
+	lua_setfield(luaStatePointer, -2, "count");
+	lua_createtable(luaStatePointer, packetCount, 0);
+	for (int index = 0; index < packetCount; index++)
+	{
+		PushGalaxyIdTo(luaStatePointer, packets[index].SenderId);
+		lua_rawseti(luaStatePointer, -2, index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "senderIds");
+	lua_createtable(luaStatePointer, packetCount, 0);
+	for (int index = 0; index < packetCount; index++)
+	{
+		lua_pushinteger(luaStatePointer, packets[index].Channel);
+		lua_rawseti(luaStatePointer, -2, index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "channels");
+	bool hasStreams = false;
+	for (int index = 0; (index < packetCount) && !hasStreams; index++)
+	{
+		hasStreams = (packets[index].Stream >= 0);
+	}
+	if (hasStreams)
+	{
+		lua_createtable(luaStatePointer, packetCount, 0);
+		for (int index = 0; index < packetCount; index++)
+		{
+			if (packets[index].Stream >= 0)
+			{
+				lua_pushinteger(luaStatePointer, packets[index].Stream);
+			}
+			else
+			{
+				lua_pushboolean(luaStatePointer, 0);
+			}
+			lua_rawseti(luaStatePointer, -2, index + 1);
+		}
+		lua_setfield(luaStatePointer, -2, "streams");
+	}
+	lua_createtable(luaStatePointer, packetCount, 0);
+	for (int index = 0; index < packetCount; index++)
+	{
+		if (!P2PNetworking::PushPayloadTo(luaStatePointer, *fBatchPointer, (size_t)index))
+		{
+			lua_pushboolean(luaStatePointer, 0);
+		}
+		lua_rawseti(luaStatePointer, -2, index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "payloads");
+	return true;
+}
+
+//---------------------------------------------------------------------------------
+// DispatchPeerStatsEventTask Class Members
+//---------------------------------------------------------------------------------
+
+const char DispatchPeerStatsEventTask::kLuaEventName[] = "peerStats";
+
+DispatchPeerStatsEventTask::DispatchPeerStatsEventTask()
+{
+}
+
+DispatchPeerStatsEventTask::~DispatchPeerStatsEventTask()
+{
+}
+
+void DispatchPeerStatsEventTask::AcquireEventDataFrom(const std::vector<PeerTelemetry::PeerStatistics>& peers)
+{
+	fPeers = peers;
+}
+
+const char* DispatchPeerStatsEventTask::GetLuaEventName() const
+{
+	return kLuaEventName;
+}
+
+bool DispatchPeerStatsEventTask::PushLuaEventTableTo(lua_State* luaStatePointer) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the event data to Lua.
+	CoronaLuaNewEvent(luaStatePointer, kLuaEventName);
+	lua_createtable(luaStatePointer, (int)fPeers.size(), 0);
+	for (size_t index = 0; index < fPeers.size(); index++)
+	{
+		PeerTelemetry::PushStatisticsTo(luaStatePointer, fPeers[index]);
+		lua_rawseti(luaStatePointer, -2, (int)index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "peers");
+	return true;
+}
@@ -9,8 +9,18 @@
 
 #pragma once
 
+#include "GalaxyID.h"
+#include "LobbyBrowser.h"
+#include "LobbyMessenger.h"
+#include "P2PNetworking.h"
+#include "PeerTelemetry.h"
 #include "LuaEventDispatcher.h"
+#include <map>
 #include <memory>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
 
 // Forward declarations.
 extern "C"
@@ -58,3 +68,269 @@ class DispatchAuthResponseEventTask : public BaseDispatchEventTask
 	private:
 		bool fSuccess;
 };
+
+/** Dispatches a "userInformation" event to Lua once a user's information request has completed. */
+class DispatchUserInformationEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchUserInformationEventTask();
+		virtual ~DispatchUserInformationEventTask();
+
+		void AcquireEventDataFrom(const galaxy::api::GalaxyID& userId, const char* failureReasonName);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		galaxy::api::GalaxyID fUserId;
+		std::string fFailureReasonName;
+};
+
+/** Dispatches a "richPresenceChange" event to Lua once pending rich presence changes were written or failed. */
+class DispatchRichPresenceChangeEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchRichPresenceChangeEventTask();
+		virtual ~DispatchRichPresenceChangeEventTask();
+
+		void AcquireEventDataFrom(const char* failureReasonName);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::string fFailureReasonName;
+};
+
+/** Dispatches a "richPresence" event to Lua when another user's cached rich presence has been updated. */
+class DispatchRichPresenceEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchRichPresenceEventTask();
+		virtual ~DispatchRichPresenceEventTask();
+
+		void AcquireEventDataFrom(
+				const galaxy::api::GalaxyID& userId,
+				const std::map<std::string, std::string>* valuesPointer,
+				const char* failureReasonName);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		galaxy::api::GalaxyID fUserId;
+		std::map<std::string, std::string> fValues;
+		std::string fFailureReasonName;
+};
+
+/** Dispatches a "userFind" event to Lua when a user specifier lookup has been answered. */
+class DispatchUserFindEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchUserFindEventTask();
+		virtual ~DispatchUserFindEventTask();
+
+		void AcquireEventDataFrom(
+				const char* userSpecifier, const galaxy::api::GalaxyID& userId,
+				const char* failureReasonName, bool isCached);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::string fUserSpecifier;
+		galaxy::api::GalaxyID fUserId;
+		std::string fFailureReasonName;
+		bool fIsCached;
+};
+
+/** Dispatches a "lobbyList" event to Lua providing the answer to one LobbyBrowser request. */
+class DispatchLobbyListEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyListEventTask();
+		virtual ~DispatchLobbyListEventTask();
+
+		void AcquireEventDataFrom(
+				uint32_t requestId, const std::shared_ptr<const LobbyBrowser::ListResult>& resultPointer,
+				const std::vector<std::string>& dataKeys, bool isCached,
+				std::vector<LobbyBrowser::RankedLobby>* rankedLobbiesPointer);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		uint32_t fRequestId;
+		std::shared_ptr<const LobbyBrowser::ListResult> fResultPointer;
+		std::vector<std::string> fDataKeys;
+		bool fIsCached;
+		bool fIsRanked;
+		std::vector<LobbyBrowser::RankedLobby> fRankedLobbies;
+};
+
+/** Dispatches a "lobby" event to Lua when the user has created, entered or left a lobby. */
+class DispatchLobbyEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyEventTask();
+		virtual ~DispatchLobbyEventTask();
+
+		void AcquireEventDataFrom(
+				const char* phaseName, const galaxy::api::GalaxyID& lobbyId,
+				const char* failureReasonName, const char* leaveReasonName);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::string fPhaseName;
+		galaxy::api::GalaxyID fLobbyId;
+		std::string fFailureReasonName;
+		std::string fLeaveReasonName;
+};
+
+/** Dispatches a "lobbyData" event to Lua providing the keys of a lobby's or member's data that have changed. */
+class DispatchLobbyDataEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyDataEventTask();
+		virtual ~DispatchLobbyDataEventTask();
+
+		void AcquireEventDataFrom(
+				const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId,
+				std::vector<std::pair<std::string, std::string>>& changedPairs, std::vector<std::string>& removedKeys);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		galaxy::api::GalaxyID fLobbyId;
+		galaxy::api::GalaxyID fMemberId;
+		std::vector<std::pair<std::string, std::string>> fChangedPairs;
+		std::vector<std::string> fRemovedKeys;
+};
+
+/** Dispatches a "lobbyDataWrite" event to Lua when a LobbyDataWriter flush has finished writing a lobby's data. */
+class DispatchLobbyDataWriteEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyDataWriteEventTask();
+		virtual ~DispatchLobbyDataWriteEventTask();
+
+		void AcquireEventDataFrom(
+				const galaxy::api::GalaxyID& lobbyId, int writeCount, int failureCount, const char* failureReasonName);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		galaxy::api::GalaxyID fLobbyId;
+		int fWriteCount;
+		int fFailureCount;
+		std::string fFailureReasonName;
+};
+
+/** Dispatches a "lobbyMessages" event to Lua providing all lobby messages received during one frame. */
+class DispatchLobbyMessagesEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyMessagesEventTask();
+		virtual ~DispatchLobbyMessagesEventTask();
+
+		void AcquireEventDataFrom(const std::shared_ptr<const LobbyMessenger::Batch>& batchPointer);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::shared_ptr<const LobbyMessenger::Batch> fBatchPointer;
+};
+
+/** Dispatches a "lobbyMember" event to Lua when a lobby's roster has changed. */
+class DispatchLobbyMemberEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchLobbyMemberEventTask();
+		virtual ~DispatchLobbyMemberEventTask();
+
+		void AcquireEventDataFrom(
+				const char* phaseName, const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId,
+				const galaxy::api::GalaxyID& ownerId, uint32_t memberCount);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::string fPhaseName;
+		galaxy::api::GalaxyID fLobbyId;
+		galaxy::api::GalaxyID fMemberId;
+		galaxy::api::GalaxyID fOwnerId;
+		uint32_t fMemberCount;
+};
+
+/** Dispatches a "hostElected" event to Lua when a lobby's elected P2P host has changed. */
+class DispatchHostElectedEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchHostElectedEventTask();
+		virtual ~DispatchHostElectedEventTask();
+
+		void AcquireEventDataFrom(
+				const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& hostId,
+				const galaxy::api::GalaxyID& previousHostId, const char* reasonName, int aggregatePing);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		galaxy::api::GalaxyID fLobbyId;
+		galaxy::api::GalaxyID fHostId;
+		galaxy::api::GalaxyID fPreviousHostId;
+		std::string fReasonName;
+		int fAggregatePing;
+};
+
+/** Dispatches a "p2pPackets" event to Lua providing all P2P packets read during one frame. */
+class DispatchP2PPacketsEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchP2PPacketsEventTask();
+		virtual ~DispatchP2PPacketsEventTask();
+
+		void AcquireEventDataFrom(const std::shared_ptr<const P2PNetworking::Batch>& batchPointer);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::shared_ptr<const P2PNetworking::Batch> fBatchPointer;
+};
+
+/** Dispatches a "peerStats" event to Lua providing the connection statistics of the recently active P2P peers. */
+class DispatchPeerStatsEventTask : public BaseDispatchEventTask
+{
+	public:
+		static const char kLuaEventName[];
+
+		DispatchPeerStatsEventTask();
+		virtual ~DispatchPeerStatsEventTask();
+
+		void AcquireEventDataFrom(const std::vector<PeerTelemetry::PeerStatistics>& peers);
+		virtual const char* GetLuaEventName() const;
+		virtual bool PushLuaEventTableTo(lua_State* luaStatePointer) const;
+
+	private:
+		std::vector<PeerTelemetry::PeerStatistics> fPeers;
+};
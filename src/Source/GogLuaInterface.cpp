@@ -10,9 +10,29 @@
 #include "CoronaLua.h"
 #include "CoronaMacros.h"
 #include "DispatchEventTask.h"
+#include "HostElection.h"
+#include "LobbyBrowser.h"
+#include "LobbyDataMirror.h"
+#include "LobbyDataWriter.h"
+#include "LobbyMembership.h"
+#include "LobbyMessenger.h"
+#include "LobbyRoster.h"
+#include "LuaBuffer.h"
+#include "P2PNetworking.h"
+#include "P2PReliability.h"
 #include "LuaEventDispatcher.h"
+#include "LuaGalaxyId.h"
+#include "LuaValuePacker.h"
+#include "PayloadCodec.h"
+#include "PeerTelemetry.h"
+#include "PersonaNameCache.h"
 #include "PluginConfigLuaSettings.h"
+#include "RichPresenceCache.h"
+#include "RichPresenceWriter.h"
 #include "RuntimeContext.h"
+#include "SnapshotReplicator.h"
+#include "UserFinder.h"
+#include "UserInformationScheduler.h"
 #include <cmath>
 #include <sstream>
 #include <stdint.h>
@@ -82,6 +102,290 @@ bool IsRunningInCoronaSimulator(lua_State* luaStatePointer)
 	return isSimulator;
 }
 
+/**
+  Fetches the lobby comparison type matching the given Lua comparison name, such as "greaterOrEqual".
+  @param name The comparison name. Null is treated as "equal".
+  @param comparisonType Set to the matching comparison type if found.
+  @return Returns true if the name was recognized. Returns false if not, in which case "comparisonType" is unchanged.
+ */
+bool GetLobbyComparisonTypeFrom(const char* name, galaxy::api::LobbyComparisonType& comparisonType)
+{
+	static const struct
+	{
+		const char* Name;
+		galaxy::api::LobbyComparisonType Type;
+	} kComparisonTypes[] =
+	{
+		{ "equal", galaxy::api::LOBBY_COMPARISON_TYPE_EQUAL },
+		{ "notEqual", galaxy::api::LOBBY_COMPARISON_TYPE_NOT_EQUAL },
+		{ "greater", galaxy::api::LOBBY_COMPARISON_TYPE_GREATER },
+		{ "greaterOrEqual", galaxy::api::LOBBY_COMPARISON_TYPE_GREATER_OR_EQUAL },
+		{ "lower", galaxy::api::LOBBY_COMPARISON_TYPE_LOWER },
+		{ "lowerOrEqual", galaxy::api::LOBBY_COMPARISON_TYPE_LOWER_OR_EQUAL },
+	};
+	if (!name)
+	{
+		comparisonType = galaxy::api::LOBBY_COMPARISON_TYPE_EQUAL;
+		return true;
+	}
+	for (auto&& entry : kComparisonTypes)
+	{
+		if (strcmp(entry.Name, name) == 0)
+		{
+			comparisonType = entry.Type;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+  Fetches the lobby type matching the given Lua name, such as "public".
+  @param name The lobby type name.
+  @param lobbyType Set to the matching lobby type if found.
+  @return Returns true if the name was recognized. Returns false if not, in which case "lobbyType" is unchanged.
+ */
+bool GetLobbyTypeFrom(const char* name, galaxy::api::LobbyType& lobbyType)
+{
+	static const struct
+	{
+		const char* Name;
+		galaxy::api::LobbyType Type;
+	} kLobbyTypes[] =
+	{
+		{ "private", galaxy::api::LOBBY_TYPE_PRIVATE },
+		{ "friendsOnly", galaxy::api::LOBBY_TYPE_FRIENDS_ONLY },
+		{ "public", galaxy::api::LOBBY_TYPE_PUBLIC },
+		{ "invisibleToFriends", galaxy::api::LOBBY_TYPE_INVISIBLE_TO_FRIENDS },
+	};
+	for (auto&& entry : kLobbyTypes)
+	{
+		if (name && (strcmp(entry.Name, name) == 0))
+		{
+			lobbyType = entry.Type;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+  Fetches the lobby topology type matching the given Lua name, such as "star".
+  @param name The lobby topology name.
+  @param topologyType Set to the matching topology type if found.
+  @return Returns true if the name was recognized. Returns false if not, in which case "topologyType" is unchanged.
+ */
+bool GetLobbyTopologyTypeFrom(const char* name, galaxy::api::LobbyTopologyType& topologyType)
+{
+	static const struct
+	{
+		const char* Name;
+		galaxy::api::LobbyTopologyType Type;
+	} kTopologyTypes[] =
+	{
+		{ "fcm", galaxy::api::LOBBY_TOPOLOGY_TYPE_FCM },
+		{ "star", galaxy::api::LOBBY_TOPOLOGY_TYPE_STAR },
+		{ "connectionless", galaxy::api::LOBBY_TOPOLOGY_TYPE_CONNECTIONLESS },
+		{ "fcmOwnershipTransition", galaxy::api::LOBBY_TOPOLOGY_TYPE_FCM_OWNERSHIP_TRANSITION },
+	};
+	for (auto&& entry : kTopologyTypes)
+	{
+		if (name && (strcmp(entry.Name, name) == 0))
+		{
+			topologyType = entry.Type;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+  Fetches lobby ranking weights from a Lua table such as
+  { ping = -1, freeSlots = 10, direct = 50, proxy = 20, none = 0, unknownPing = 1000, maxPing = 300, count = 10,
+    data = { skill = -0.5 } }. Fields not provided keep their defaults.
+  @param luaStatePointer The Lua state providing the table.
+  @param luaStackIndex Index to the weights table. Must be an absolute index.
+  @param weights The weights to update. Its "IsEnabled" field is set true.
+ */
+void GetRankWeightsFrom(lua_State* luaStatePointer, int luaStackIndex, LobbyBrowser::RankWeights& weights)
+{
+	const struct
+	{
+		const char* Name;
+		double* ValuePointer;
+	}
+	kWeightFields[] =
+	{
+		{ "ping", &weights.Ping },
+		{ "freeSlots", &weights.FreeSlots },
+		{ "direct", &weights.DirectConnection },
+		{ "proxy", &weights.ProxyConnection },
+		{ "none", &weights.UnknownConnection },
+	};
+	weights.IsEnabled = true;
+	for (auto&& field : kWeightFields)
+	{
+		lua_getfield(luaStatePointer, luaStackIndex, field.Name);
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			*field.ValuePointer = lua_tonumber(luaStatePointer, -1);
+		}
+		lua_pop(luaStatePointer, 1);
+	}
+	lua_getfield(luaStatePointer, luaStackIndex, "unknownPing");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		weights.UnknownPing = (int)lua_tonumber(luaStatePointer, -1);
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_getfield(luaStatePointer, luaStackIndex, "maxPing");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		weights.MaxPing = (int)lua_tonumber(luaStatePointer, -1);
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_getfield(luaStatePointer, luaStackIndex, "count");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		int resultCount = (int)lua_tonumber(luaStatePointer, -1);
+		weights.ResultCount = (resultCount > 0) ? (uint32_t)resultCount : 0;
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_getfield(luaStatePointer, luaStackIndex, "data");
+	if (lua_type(luaStatePointer, -1) == LUA_TTABLE)
+	{
+		for (lua_pushnil(luaStatePointer); lua_next(luaStatePointer, -2); lua_pop(luaStatePointer, 1))
+		{
+			if ((lua_type(luaStatePointer, -2) == LUA_TSTRING) && (lua_type(luaStatePointer, -1) == LUA_TNUMBER))
+			{
+				std::string key(lua_tostring(luaStatePointer, -2));
+				weights.DataWeights.push_back(std::make_pair(key, (double)lua_tonumber(luaStatePointer, -1)));
+			}
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+}
+
+/**
+  Buffers lobby data writes from Lua arguments (lobbyId, key, value) or (lobbyId, keyValueTable).
+  A value of nil or false deletes the key.
+  @param luaStatePointer The Lua state providing the arguments.
+  @param contextPointer The runtime context whose LobbyDataWriter will buffer the writes.
+  @param isMemberData Set true to write to the user's own lobby member data instead of the lobby's data.
+ */
+void SetLobbyDataFrom(lua_State* luaStatePointer, RuntimeContext* contextPointer, bool isMemberData)
+{
+	// Fetch the lobby ID.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return;
+	}
+
+	// Buffer the writes. The writer will send the changes to GOG later.
+	auto writerPointer = contextPointer->GetLobbyDataWriter();
+	if (lua_type(luaStatePointer, 2) == LUA_TTABLE)
+	{
+		for (lua_pushnil(luaStatePointer); lua_next(luaStatePointer, 2); lua_pop(luaStatePointer, 1))
+		{
+			if (lua_type(luaStatePointer, -2) != LUA_TSTRING)
+			{
+				continue;
+			}
+			auto valueType = lua_type(luaStatePointer, -1);
+			if ((LUA_TSTRING == valueType) || (LUA_TNUMBER == valueType))
+			{
+				// Note: Numbers are converted to strings on a copy to avoid confusing lua_next().
+				lua_pushvalue(luaStatePointer, -1);
+				writerPointer->Set(lobbyId, lua_tostring(luaStatePointer, -3), lua_tostring(luaStatePointer, -1), isMemberData);
+				lua_pop(luaStatePointer, 1);
+			}
+			else if ((LUA_TBOOLEAN == valueType) && !lua_toboolean(luaStatePointer, -1))
+			{
+				writerPointer->Set(lobbyId, lua_tostring(luaStatePointer, -2), nullptr, isMemberData);
+			}
+		}
+	}
+	else if (lua_type(luaStatePointer, 2) == LUA_TSTRING)
+	{
+		const char* value = nullptr;
+		auto valueType = lua_type(luaStatePointer, 3);
+		if ((LUA_TSTRING == valueType) || (LUA_TNUMBER == valueType))
+		{
+			value = lua_tostring(luaStatePointer, 3);
+		}
+		writerPointer->Set(lobbyId, lua_tostring(luaStatePointer, 2), value, isMemberData);
+	}
+	else
+	{
+		CoronaLuaError(luaStatePointer, "2nd argument must be set to a lobby data key or a table of key/value pairs.");
+	}
+}
+
+/**
+  Fetches the optional P2P send settings table { channel, reliable, immediate, stream } at the given Lua stack index.
+  Raises a Lua error if the table or any of its fields are invalid.
+  @param luaStatePointer The Lua state providing the settings.
+  @param luaStackIndex Index of the settings table, which may be nil.
+  @param channel Assigned the 'channel' field, if provided.
+  @param stream Assigned the 'stream' field, if provided. Left at its given value otherwise.
+  @param sendType Assigned the send type matching the 'reliable' and 'immediate' fields.
+  @return Returns true if the settings were valid. Returns false if a Lua error was raised.
+ */
+bool GetP2PSendOptionsFrom(
+	lua_State* luaStatePointer, int luaStackIndex, int& channel, int& stream, galaxy::api::P2PSendType& sendType)
+{
+	bool isReliable = false;
+	bool isImmediate = false;
+	if (lua_istable(luaStatePointer, luaStackIndex))
+	{
+		lua_getfield(luaStatePointer, luaStackIndex, "stream");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			stream = (int)lua_tointeger(luaStatePointer, -1);
+			if ((stream < 0) || (stream >= P2PReliability::kStreamCount))
+			{
+				CoronaLuaError(luaStatePointer, "The 'stream' field must be set to an integer between 0 and 255.");
+				lua_pop(luaStatePointer, 1);
+				return false;
+			}
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, luaStackIndex, "channel");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			channel = (int)lua_tointeger(luaStatePointer, -1);
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, luaStackIndex, "reliable");
+		isReliable = lua_toboolean(luaStatePointer, -1) ? true : false;
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, luaStackIndex, "immediate");
+		isImmediate = lua_toboolean(luaStatePointer, -1) ? true : false;
+		lua_pop(luaStatePointer, 1);
+	}
+	else if (!lua_isnoneornil(luaStatePointer, luaStackIndex))
+	{
+		CoronaLuaError(luaStatePointer, "Argument #%d must be set to a table or nil.", luaStackIndex);
+		return false;
+	}
+	if ((channel < 0) || (channel > 255))
+	{
+		CoronaLuaError(luaStatePointer, "The 'channel' field must be set to an integer between 0 and 255.");
+		return false;
+	}
+	if (isReliable)
+	{
+		sendType = isImmediate ? galaxy::api::P2P_SEND_RELIABLE_IMMEDIATE : galaxy::api::P2P_SEND_RELIABLE;
+	}
+	else
+	{
+		sendType = isImmediate ? galaxy::api::P2P_SEND_UNRELIABLE_IMMEDIATE : galaxy::api::P2P_SEND_UNRELIABLE;
+	}
+	return true;
+}
+
 //---------------------------------------------------------------------------------
 // Lua API Handlers
 //---------------------------------------------------------------------------------
@@ -201,6 +505,1710 @@ int OnSetAchievementUnlocked(lua_State* luaStatePointer)
 	return 1;
 }
 
+/** personaName = gog.getPersonaName(userId) */
+int OnGetPersonaName(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user ID.
+	auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!userId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID.");
+		return 0;
+	}
+
+	// Push the user's interned persona name. Returns nil if GOG does not have the user's information yet.
+	if (!contextPointer->GetPersonaNameCache()->PushTo(luaStatePointer, userId))
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/** gog.requestUserInformation(userIds, [options]) */
+int OnRequestUserInformation(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the optional settings table.
+	bool isVisible = false;
+	if (lua_type(luaStatePointer, 2) == LUA_TTABLE)
+	{
+		lua_getfield(luaStatePointer, 2, "visible");
+		isVisible = lua_toboolean(luaStatePointer, -1) ? true : false;
+		lua_pop(luaStatePointer, 1);
+	}
+
+	// Queue the given user ID or array of user IDs.
+	auto schedulerPointer = contextPointer->GetUserInformationScheduler();
+	int requestCount = 0;
+	if (lua_type(luaStatePointer, 1) == LUA_TTABLE)
+	{
+		int userCount = (int)lua_objlen(luaStatePointer, 1);
+		for (int index = 1; index <= userCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, 1, index);
+			if (schedulerPointer->Request(GetGalaxyIdFrom(luaStatePointer, -1), isVisible))
+			{
+				requestCount++;
+			}
+			lua_pop(luaStatePointer, 1);
+		}
+	}
+	else
+	{
+		auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+		if (!userId.IsValid())
+		{
+			CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID or an array of user IDs.");
+			lua_pushinteger(luaStatePointer, 0);
+			return 1;
+		}
+		if (schedulerPointer->Request(userId, isVisible))
+		{
+			requestCount++;
+		}
+	}
+
+	// Return the number of user IDs that were accepted.
+	lua_pushinteger(luaStatePointer, requestCount);
+	return 1;
+}
+
+/**
+  gog.setRichPresence(key, value)
+  gog.setRichPresence(keyValueTable)
+ */
+int OnSetRichPresence(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+	auto writerPointer = contextPointer->GetRichPresenceWriter();
+
+	// Update the desired rich presence set. The writer will send the changes to GOG later.
+	if (lua_type(luaStatePointer, 1) == LUA_TTABLE)
+	{
+		for (lua_pushnil(luaStatePointer); lua_next(luaStatePointer, 1); lua_pop(luaStatePointer, 1))
+		{
+			if (lua_type(luaStatePointer, -2) != LUA_TSTRING)
+			{
+				continue;
+			}
+			auto valueType = lua_type(luaStatePointer, -1);
+			if ((LUA_TSTRING == valueType) || (LUA_TNUMBER == valueType))
+			{
+				// Note: Numbers are converted to strings on a copy to avoid confusing lua_next().
+				lua_pushvalue(luaStatePointer, -1);
+				writerPointer->Set(lua_tostring(luaStatePointer, -3), lua_tostring(luaStatePointer, -1));
+				lua_pop(luaStatePointer, 1);
+			}
+			else if ((LUA_TBOOLEAN == valueType) && !lua_toboolean(luaStatePointer, -1))
+			{
+				// A value of false deletes the key.
+				writerPointer->Set(lua_tostring(luaStatePointer, -2), nullptr);
+			}
+		}
+	}
+	else if (lua_type(luaStatePointer, 1) == LUA_TSTRING)
+	{
+		const char* value = nullptr;
+		auto valueType = lua_type(luaStatePointer, 2);
+		if ((LUA_TSTRING == valueType) || (LUA_TNUMBER == valueType))
+		{
+			value = lua_tostring(luaStatePointer, 2);
+		}
+		writerPointer->Set(lua_tostring(luaStatePointer, 1), value);
+	}
+	else
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a rich presence key or a table of key/value pairs.");
+	}
+	return 0;
+}
+
+/** gog.clearRichPresence() */
+int OnClearRichPresence(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Flag all rich presence keys to be deleted.
+	contextPointer->GetRichPresenceWriter()->Clear();
+	return 0;
+}
+
+/** gog.requestRichPresence(userIds, [options]) */
+int OnRequestRichPresence(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the optional settings table.
+	int maxAgeInSeconds = -1;
+	if (lua_type(luaStatePointer, 2) == LUA_TTABLE)
+	{
+		lua_getfield(luaStatePointer, 2, "maxAge");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			maxAgeInSeconds = (int)lua_tonumber(luaStatePointer, -1);
+		}
+		lua_pop(luaStatePointer, 1);
+	}
+
+	// Queue fetches for the given user ID or array of user IDs whose cached rich presence is stale.
+	auto cachePointer = contextPointer->GetRichPresenceCache();
+	int requestCount = 0;
+	if (lua_type(luaStatePointer, 1) == LUA_TTABLE)
+	{
+		int userCount = (int)lua_objlen(luaStatePointer, 1);
+		for (int index = 1; index <= userCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, 1, index);
+			if (cachePointer->Request(GetGalaxyIdFrom(luaStatePointer, -1), maxAgeInSeconds))
+			{
+				requestCount++;
+			}
+			lua_pop(luaStatePointer, 1);
+		}
+	}
+	else
+	{
+		auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+		if (!userId.IsValid())
+		{
+			CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID or an array of user IDs.");
+			lua_pushinteger(luaStatePointer, 0);
+			return 1;
+		}
+		if (cachePointer->Request(userId, maxAgeInSeconds))
+		{
+			requestCount++;
+		}
+	}
+
+	// Return the number of users that will be fetched.
+	lua_pushinteger(luaStatePointer, requestCount);
+	return 1;
+}
+
+/** richPresenceTable, isFresh = gog.getRichPresence(userId) */
+int OnGetRichPresence(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user ID.
+	auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!userId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID.");
+		return 0;
+	}
+
+	// Push the user's cached rich presence. Returns nil if it was never fetched.
+	auto cachePointer = contextPointer->GetRichPresenceCache();
+	if (!cachePointer->PushTo(luaStatePointer, userId))
+	{
+		lua_pushnil(luaStatePointer);
+		lua_pushboolean(luaStatePointer, 0);
+		return 2;
+	}
+	lua_pushboolean(luaStatePointer, cachePointer->IsFresh(userId) ? 1 : 0);
+	return 2;
+}
+
+/** success = gog.findUser(userSpecifier) */
+int OnFindUser(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user specifier to search by.
+	const char* userSpecifier = nullptr;
+	if (lua_type(luaStatePointer, 1) == LUA_TSTRING)
+	{
+		userSpecifier = lua_tostring(luaStatePointer, 1);
+	}
+	if (!userSpecifier || ('\0' == userSpecifier[0]))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a user specifier string.");
+		return 0;
+	}
+
+	// Look up the user. The result will be provided by a "userFind" event.
+	bool wasStarted = contextPointer->GetUserFinder()->Find(userSpecifier);
+	lua_pushboolean(luaStatePointer, wasStarted ? 1 : 0);
+	return 1;
+}
+
+/** requestId = gog.requestLobbyList([query]) */
+int OnRequestLobbyList(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the optional query table.
+	LobbyBrowser::Query query;
+	LobbyBrowser::RankWeights rankWeights;
+	std::vector<std::string> dataKeys;
+	int maxAgeInSeconds = -1;
+	if (lua_type(luaStatePointer, 1) == LUA_TTABLE)
+	{
+		lua_getfield(luaStatePointer, 1, "allowFull");
+		if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+		{
+			query.AllowFullLobbies = lua_toboolean(luaStatePointer, -1) ? true : false;
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "resultCount");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			int resultCount = (int)lua_tonumber(luaStatePointer, -1);
+			query.ResultCount = (resultCount > 0) ? (uint32_t)resultCount : 0;
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "prefetch");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			int prefetchCount = (int)lua_tonumber(luaStatePointer, -1);
+			query.PrefetchCount = (prefetchCount > 0) ? (uint32_t)prefetchCount : 0;
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "maxAge");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			maxAgeInSeconds = (int)lua_tonumber(luaStatePointer, -1);
+		}
+		lua_pop(luaStatePointer, 1);
+
+		// Fetch the optional weights to rank the listed lobbies by.
+		lua_getfield(luaStatePointer, 1, "rank");
+		if (lua_type(luaStatePointer, -1) == LUA_TTABLE)
+		{
+			GetRankWeightsFrom(luaStatePointer, lua_gettop(luaStatePointer), rankWeights);
+		}
+		lua_pop(luaStatePointer, 1);
+
+		// Fetch the array of lobby data keys to provide for each listed lobby.
+		lua_getfield(luaStatePointer, 1, "dataKeys");
+		if (lua_type(luaStatePointer, -1) == LUA_TTABLE)
+		{
+			int keyCount = (int)lua_objlen(luaStatePointer, -1);
+			for (int index = 1; index <= keyCount; index++)
+			{
+				lua_rawgeti(luaStatePointer, -1, index);
+				if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+				{
+					dataKeys.push_back(lua_tostring(luaStatePointer, -1));
+				}
+				lua_pop(luaStatePointer, 1);
+			}
+		}
+		lua_pop(luaStatePointer, 1);
+
+		// Fetch the array of filters. Each is a table with a "key" and either a "value" or a "near" number.
+		lua_getfield(luaStatePointer, 1, "filters");
+		if (lua_type(luaStatePointer, -1) == LUA_TTABLE)
+		{
+			int filterCount = (int)lua_objlen(luaStatePointer, -1);
+			for (int index = 1; index <= filterCount; index++)
+			{
+				lua_rawgeti(luaStatePointer, -1, index);
+				if (lua_type(luaStatePointer, -1) != LUA_TTABLE)
+				{
+					CoronaLuaError(luaStatePointer, "Lobby list filter [%d] must be a table.", index);
+					lua_pop(luaStatePointer, 2);
+					return 0;
+				}
+				lua_getfield(luaStatePointer, -1, "key");
+				lua_getfield(luaStatePointer, -2, "value");
+				lua_getfield(luaStatePointer, -3, "near");
+				lua_getfield(luaStatePointer, -4, "comparison");
+				const char* key = nullptr;
+				if (lua_type(luaStatePointer, -4) == LUA_TSTRING)
+				{
+					key = lua_tostring(luaStatePointer, -4);
+				}
+				galaxy::api::LobbyComparisonType comparisonType = galaxy::api::LOBBY_COMPARISON_TYPE_EQUAL;
+				const char* comparisonName = nullptr;
+				if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+				{
+					comparisonName = lua_tostring(luaStatePointer, -1);
+				}
+				bool isValid = (key && (key[0] != '\0'));
+				if (isValid)
+				{
+					isValid = GetLobbyComparisonTypeFrom(comparisonName, comparisonType);
+				}
+				if (isValid && (lua_type(luaStatePointer, -2) == LUA_TNUMBER))
+				{
+					LobbyBrowser::NearValueFilter filter;
+					filter.Key = key;
+					filter.Value = (int32_t)lua_tonumber(luaStatePointer, -2);
+					query.NearValueFilters.push_back(filter);
+				}
+				else if (isValid && (lua_type(luaStatePointer, -3) == LUA_TNUMBER))
+				{
+					LobbyBrowser::NumericalFilter filter;
+					filter.Key = key;
+					filter.Value = (int32_t)lua_tonumber(luaStatePointer, -3);
+					filter.ComparisonType = comparisonType;
+					query.NumericalFilters.push_back(filter);
+				}
+				else if (isValid && (lua_type(luaStatePointer, -3) == LUA_TSTRING))
+				{
+					LobbyBrowser::StringFilter filter;
+					filter.Key = key;
+					filter.Value = lua_tostring(luaStatePointer, -3);
+					filter.ComparisonType = comparisonType;
+					query.StringFilters.push_back(filter);
+				}
+				else
+				{
+					isValid = false;
+				}
+				lua_pop(luaStatePointer, 5);
+				if (!isValid)
+				{
+					CoronaLuaError(
+							luaStatePointer,
+							"Lobby list filter [%d] must have a \"key\" string, a valid \"comparison\" name, and a \"value\" string/number or a \"near\" number.",
+							index);
+					lua_pop(luaStatePointer, 1);
+					return 0;
+				}
+			}
+		}
+		lua_pop(luaStatePointer, 1);
+	}
+	else if (!lua_isnoneornil(luaStatePointer, 1))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be a query table or nil.");
+		return 0;
+	}
+
+	// Request the lobby list. The result will be provided by a "lobbyList" event.
+	auto requestId = contextPointer->GetLobbyBrowser()->Request(query, dataKeys, maxAgeInSeconds, rankWeights);
+	lua_pushnumber(luaStatePointer, (double)requestId);
+	return 1;
+}
+
+/** success = gog.createLobby([settings]) */
+int OnCreateLobby(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the optional settings table.
+	galaxy::api::LobbyType lobbyType = galaxy::api::LOBBY_TYPE_PUBLIC;
+	galaxy::api::LobbyTopologyType topologyType = galaxy::api::LOBBY_TOPOLOGY_TYPE_FCM_OWNERSHIP_TRANSITION;
+	uint32_t maxMemberCount = 4;
+	bool isJoinable = true;
+	if (lua_type(luaStatePointer, 1) == LUA_TTABLE)
+	{
+		lua_getfield(luaStatePointer, 1, "type");
+		if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+		{
+			if (!GetLobbyTypeFrom(lua_tostring(luaStatePointer, -1), lobbyType))
+			{
+				CoronaLuaError(luaStatePointer, "Unknown lobby type \"%s\".", lua_tostring(luaStatePointer, -1));
+				lua_pop(luaStatePointer, 1);
+				return 0;
+			}
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "topology");
+		if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+		{
+			if (!GetLobbyTopologyTypeFrom(lua_tostring(luaStatePointer, -1), topologyType))
+			{
+				CoronaLuaError(luaStatePointer, "Unknown lobby topology \"%s\".", lua_tostring(luaStatePointer, -1));
+				lua_pop(luaStatePointer, 1);
+				return 0;
+			}
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "maxMembers");
+		if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+		{
+			int value = (int)lua_tonumber(luaStatePointer, -1);
+			maxMemberCount = (value > 0) ? (uint32_t)value : 1;
+		}
+		lua_pop(luaStatePointer, 1);
+		lua_getfield(luaStatePointer, 1, "joinable");
+		if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+		{
+			isJoinable = lua_toboolean(luaStatePointer, -1) ? true : false;
+		}
+		lua_pop(luaStatePointer, 1);
+	}
+
+	// Create the lobby. The result will be provided by "lobby" events having a "created" and "entered" phase.
+	bool wasSent = contextPointer->GetLobbyMembership()->Create(lobbyType, maxMemberCount, isJoinable, topologyType);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/** success = gog.joinLobby(lobbyId) */
+int OnJoinLobby(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+
+	// Join the lobby. The result will be provided by a "lobby" event having an "entered" phase.
+	bool wasSent = contextPointer->GetLobbyMembership()->Join(lobbyId);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/** success = gog.leaveLobby(lobbyId) */
+int OnLeaveLobby(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+
+	// Leave the lobby. Will be confirmed by a "lobby" event having a "left" phase.
+	bool wasSent = contextPointer->GetLobbyMembership()->Leave(lobbyId);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/** value = gog.getLobbyData(lobbyId, [key]) */
+int OnGetLobbyData(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID and optional key.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+	const char* key = nullptr;
+	if (lua_type(luaStatePointer, 2) == LUA_TSTRING)
+	{
+		key = lua_tostring(luaStatePointer, 2);
+	}
+
+	// Push the requested value or the table of all key/value pairs from the mirror.
+	if (!contextPointer->GetLobbyDataMirror()->PushTo(luaStatePointer, lobbyId, galaxy::api::GalaxyID(), key))
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/** value = gog.getLobbyMemberData(lobbyId, memberId, [key]) */
+int OnGetLobbyMemberData(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID, member ID and optional key.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+	auto memberId = GetGalaxyIdFrom(luaStatePointer, 2);
+	if (!memberId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "2nd argument must be set to a user ID.");
+		return 0;
+	}
+	const char* key = nullptr;
+	if (lua_type(luaStatePointer, 3) == LUA_TSTRING)
+	{
+		key = lua_tostring(luaStatePointer, 3);
+	}
+
+	// Push the requested value or the table of all key/value pairs from the mirror.
+	if (!contextPointer->GetLobbyDataMirror()->PushTo(luaStatePointer, lobbyId, memberId, key))
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/** rosterTable = gog.getLobbyRoster(lobbyId) */
+int OnGetLobbyRoster(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+
+	// Push the lobby's roster, or nil if the user is not in the lobby.
+	if (!contextPointer->GetLobbyRoster()->PushTo(luaStatePointer, lobbyId))
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/** gog.setLobbyData(lobbyId, key, value) or gog.setLobbyData(lobbyId, keyValueTable) */
+int OnSetLobbyData(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Buffer the given lobby data writes.
+	SetLobbyDataFrom(luaStatePointer, contextPointer, false);
+	return 0;
+}
+
+/** gog.setLobbyMemberData(lobbyId, key, value) or gog.setLobbyMemberData(lobbyId, keyValueTable) */
+int OnSetLobbyMemberData(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Buffer the given writes to the user's own lobby member data.
+	SetLobbyDataFrom(luaStatePointer, contextPointer, true);
+	return 0;
+}
+
+/** wasSent = gog.sendLobbyMessage(lobbyId, message) */
+int OnSendLobbyMessage(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID and the message's bytes.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+	size_t byteCount = 0;
+	auto bytesPointer = GetLuaBytesFrom(luaStatePointer, 2, &byteCount);
+	if (!bytesPointer)
+	{
+		CoronaLuaError(luaStatePointer, "2nd argument must be set to a string or a valid buffer.");
+		return 0;
+	}
+
+	// Send the message.
+	bool wasSent = contextPointer->GetLobbyMessenger()->Send(lobbyId, bytesPointer, byteCount);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/** gog.setLobbyMessageFormat(formatName) where formatName is "string" or "buffer" */
+int OnSetLobbyMessageFormat(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the format name.
+	const char* formatName = nullptr;
+	if (lua_type(luaStatePointer, 1) == LUA_TSTRING)
+	{
+		formatName = lua_tostring(luaStatePointer, 1);
+	}
+	if (!formatName || (strcmp(formatName, "string") && strcmp(formatName, "buffer")))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to \"string\" or \"buffer\".");
+		return 0;
+	}
+
+	// Apply the format to all messages dispatched from now on.
+	contextPointer->GetLobbyMessenger()->SetUsingBuffers(!strcmp(formatName, "buffer"));
+	return 0;
+}
+
+/** gog.setCompression({ lobbyMessages = true, lobbyData = true }) */
+int OnSetCompression(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the settings table.
+	if (!lua_istable(luaStatePointer, 1))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a table.");
+		return 0;
+	}
+
+	// Apply the given settings. Settings not provided are left unchanged.
+	auto codecPointer = contextPointer->GetPayloadCodec();
+	lua_getfield(luaStatePointer, 1, "lobbyMessages");
+	if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+	{
+		codecPointer->SetMessageFramingEnabled(lua_toboolean(luaStatePointer, -1) ? true : false);
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_getfield(luaStatePointer, 1, "lobbyData");
+	if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+	{
+		codecPointer->SetDataCompressionEnabled(lua_toboolean(luaStatePointer, -1) ? true : false);
+	}
+	lua_pop(luaStatePointer, 1);
+	return 0;
+}
+
+/** gog.setHostElection(enabled) */
+int OnSetHostElection(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the enabled flag.
+	if (lua_type(luaStatePointer, 1) != LUA_TBOOLEAN)
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a boolean.");
+		return 0;
+	}
+
+	// Enable or disable host election. Enabling it also enables lobby message framing.
+	contextPointer->GetHostElection()->SetEnabled(lua_toboolean(luaStatePointer, 1) ? true : false);
+	return 0;
+}
+
+/** hostId = gog.getLobbyHost(lobbyId) */
+int OnGetLobbyHost(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the lobby ID.
+	auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!lobbyId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID.");
+		return 0;
+	}
+
+	// Push the lobby's elected host, or nil if none has been elected.
+	auto hostId = contextPointer->GetHostElection()->GetHostOf(lobbyId);
+	if (hostId.IsValid())
+	{
+		PushGalaxyIdTo(luaStatePointer, hostId);
+	}
+	else
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/**
+  wasSent = gog.sendP2PPacket(userId, stringOrBuffer, [{ channel = 0, reliable = false, immediate = false }])
+  or gog.sendP2PPacket(userId, stringOrBuffer, { stream = 0 }) to send on a reliable ordered stream.
+ */
+int OnSendP2PPacket(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user ID and the packet's bytes.
+	auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!userId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID.");
+		return 0;
+	}
+	size_t byteCount = 0;
+	auto bytesPointer = GetLuaBytesFrom(luaStatePointer, 2, &byteCount);
+	if (!bytesPointer)
+	{
+		CoronaLuaError(luaStatePointer, "2nd argument must be set to a string or a valid buffer.");
+		return 0;
+	}
+
+	// Fetch the optional send settings.
+	int channel = 0;
+	int stream = -1;
+	auto sendType = galaxy::api::P2P_SEND_UNRELIABLE;
+	if (!GetP2PSendOptionsFrom(luaStatePointer, 3, channel, stream, sendType))
+	{
+		return 0;
+	}
+
+	// Send the message on its reliable stream, if given one.
+	if (stream >= 0)
+	{
+		auto reliabilityPointer = contextPointer->GetP2PReliability();
+		if (reliabilityPointer->GetChannel() < 0)
+		{
+			CoronaLuaError(luaStatePointer, "Sending on a stream requires setting the 'reliableChannel' P2P option first.");
+			return 0;
+		}
+		bool wasSent = reliabilityPointer->Send(userId, stream, bytesPointer, byteCount);
+		lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+		return 1;
+	}
+
+	// Otherwise send the packet as is.
+	bool wasSent = contextPointer->GetP2PNetworking()->Send(
+			userId, bytesPointer, byteCount, sendType, (uint8_t)channel);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/**
+  sentCount = gog.broadcast(lobbyIdOrUserIds, stringOrBufferOrTable, [{ channel = 0, reliable = false, immediate = false, stream = nil }])
+
+  A table payload is packed once via gog.pack(). A lobby ID sends to all of its members except the local user.
+ */
+int OnBroadcast(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the optional send settings.
+	int channel = 0;
+	int stream = -1;
+	auto sendType = galaxy::api::P2P_SEND_UNRELIABLE;
+	if (!GetP2PSendOptionsFrom(luaStatePointer, 3, channel, stream, sendType))
+	{
+		return 0;
+	}
+	auto reliabilityPointer = contextPointer->GetP2PReliability();
+	if ((stream >= 0) && (reliabilityPointer->GetChannel() < 0))
+	{
+		CoronaLuaError(luaStatePointer, "Sending on a stream requires setting the 'reliableChannel' P2P option first.");
+		return 0;
+	}
+
+	// Fetch the payload's bytes, packing a table payload once for all recipients.
+	std::vector<char> packedBytes;
+	const char* bytesPointer = nullptr;
+	size_t byteCount = 0;
+	if (lua_istable(luaStatePointer, 2))
+	{
+		std::string errorMessage;
+		if (!PackLuaValueFrom(luaStatePointer, 2, packedBytes, errorMessage))
+		{
+			CoronaLuaError(luaStatePointer, "2nd argument could not be packed. %s", errorMessage.c_str());
+			return 0;
+		}
+		bytesPointer = packedBytes.empty() ? "" : packedBytes.data();
+		byteCount = packedBytes.size();
+	}
+	else
+	{
+		bytesPointer = GetLuaBytesFrom(luaStatePointer, 2, &byteCount);
+		if (!bytesPointer)
+		{
+			CoronaLuaError(luaStatePointer, "2nd argument must be set to a string, a valid buffer, or a table.");
+			return 0;
+		}
+	}
+
+	// Fetch the user IDs to send to.
+	std::vector<galaxy::api::GalaxyID> userIds;
+	if (lua_istable(luaStatePointer, 1))
+	{
+		auto userCount = (int)lua_objlen(luaStatePointer, 1);
+		userIds.reserve((size_t)userCount);
+		for (int index = 1; index <= userCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, 1, index);
+			auto userId = GetGalaxyIdFrom(luaStatePointer, -1);
+			lua_pop(luaStatePointer, 1);
+			if (!userId.IsValid())
+			{
+				CoronaLuaError(luaStatePointer, "1st argument's array must only contain user IDs.");
+				return 0;
+			}
+			userIds.push_back(userId);
+		}
+	}
+	else
+	{
+		auto lobbyId = GetGalaxyIdFrom(luaStatePointer, 1);
+		if (!lobbyId.IsValid() || (lobbyId.GetIDType() != galaxy::api::GalaxyID::ID_TYPE_LOBBY))
+		{
+			CoronaLuaError(luaStatePointer, "1st argument must be set to a lobby ID or an array of user IDs.");
+			return 0;
+		}
+
+		// Use the roster's cached members if available. Otherwise, query them from GOG.
+		auto memberIdsPointer = contextPointer->GetLobbyRoster()->GetMembersOf(lobbyId);
+		if (memberIdsPointer)
+		{
+			userIds = *memberIdsPointer;
+		}
+		else
+		{
+			auto matchmakingPointer = galaxy::api::Matchmaking();
+			if (matchmakingPointer)
+			{
+				uint32_t memberCount = matchmakingPointer->GetNumLobbyMembers(lobbyId);
+				userIds.reserve(memberCount);
+				for (uint32_t index = 0; index < memberCount; index++)
+				{
+					auto memberId = matchmakingPointer->GetLobbyMemberByIndex(lobbyId, index);
+					if (memberId.IsValid())
+					{
+						userIds.push_back(memberId);
+					}
+				}
+			}
+		}
+
+		// Do not send to ourselves.
+		auto userPointer = galaxy::api::User();
+		if (userPointer)
+		{
+			auto selfId = userPointer->GetGalaxyID();
+			for (auto iterator = userIds.begin(); iterator != userIds.end(); ++iterator)
+			{
+				if (*iterator == selfId)
+				{
+					userIds.erase(iterator);
+					break;
+				}
+			}
+		}
+	}
+
+	// Send the same bytes to every recipient.
+	int sentCount = 0;
+	auto networkingPointer = contextPointer->GetP2PNetworking();
+	for (auto&& userId : userIds)
+	{
+		bool wasSent;
+		if (stream >= 0)
+		{
+			wasSent = reliabilityPointer->Send(userId, stream, bytesPointer, byteCount);
+		}
+		else
+		{
+			wasSent = networkingPointer->Send(userId, bytesPointer, byteCount, sendType, (uint8_t)channel);
+		}
+		if (wasSent)
+		{
+			sentCount++;
+		}
+	}
+	lua_pushinteger(luaStatePointer, sentCount);
+	return 1;
+}
+
+/**
+  wasSent = gog.sendSnapshot(userIdOrUserIds, stringOrBuffer)
+
+  Snapshots are received via "p2pPackets" events on the 'snapshotChannel' P2P option's channel.
+ */
+int OnSendSnapshot(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user IDs to send to.
+	std::vector<galaxy::api::GalaxyID> userIds;
+	if (lua_istable(luaStatePointer, 1))
+	{
+		auto userCount = (int)lua_objlen(luaStatePointer, 1);
+		userIds.reserve((size_t)userCount);
+		for (int index = 1; index <= userCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, 1, index);
+			auto userId = GetGalaxyIdFrom(luaStatePointer, -1);
+			lua_pop(luaStatePointer, 1);
+			if (!userId.IsValid())
+			{
+				CoronaLuaError(luaStatePointer, "1st argument's array must only contain user IDs.");
+				return 0;
+			}
+			userIds.push_back(userId);
+		}
+	}
+	else
+	{
+		auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+		if (!userId.IsValid())
+		{
+			CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID or an array of user IDs.");
+			return 0;
+		}
+		userIds.push_back(userId);
+	}
+
+	// Fetch the snapshot's bytes.
+	size_t byteCount = 0;
+	auto bytesPointer = GetLuaBytesFrom(luaStatePointer, 2, &byteCount);
+	if (!bytesPointer)
+	{
+		CoronaLuaError(luaStatePointer, "2nd argument must be set to a string or a valid buffer.");
+		return 0;
+	}
+	if (byteCount > SnapshotReplicator::kMaxSnapshotByteCount)
+	{
+		CoronaLuaError(
+				luaStatePointer, "2nd argument cannot exceed %d bytes.", (int)SnapshotReplicator::kMaxSnapshotByteCount);
+		return 0;
+	}
+
+	// Send the snapshot.
+	auto replicatorPointer = contextPointer->GetSnapshotReplicator();
+	if (replicatorPointer->GetChannel() < 0)
+	{
+		CoronaLuaError(luaStatePointer, "Sending a snapshot requires setting the 'snapshotChannel' P2P option first.");
+		return 0;
+	}
+	bool wasSent = replicatorPointer->Send(userIds, bytesPointer, byteCount);
+	lua_pushboolean(luaStatePointer, wasSent ? 1 : 0);
+	return 1;
+}
+
+/** gog.setP2POptions({ channels = { 0, 1 }, format = "string" or "buffer", frameByteBudget = 262144, threaded = false, aggregate = false,
+  reliableChannel = false, snapshotChannel = false, peerStatsInterval = 0, channelPriorities = { [0] = "high", [1] = "low" },
+  peerBandwidth = 0 }) */
+int OnSetP2POptions(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the settings table.
+	if (!lua_istable(luaStatePointer, 1))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a table.");
+		return 0;
+	}
+
+	// Fetch and validate all of the given settings before applying any of them.
+	// Settings not provided are left unchanged.
+	auto networkingPointer = contextPointer->GetP2PNetworking();
+	auto reliabilityPointer = contextPointer->GetP2PReliability();
+	auto replicatorPointer = contextPointer->GetSnapshotReplicator();
+	bool hasFormat = false;
+	bool isUsingBuffers = false;
+	lua_getfield(luaStatePointer, 1, "format");
+	if (lua_type(luaStatePointer, -1) == LUA_TSTRING)
+	{
+		auto formatName = lua_tostring(luaStatePointer, -1);
+		hasFormat = true;
+		isUsingBuffers = !strcmp(formatName, "buffer");
+		if (!isUsingBuffers && strcmp(formatName, "string"))
+		{
+			CoronaLuaError(luaStatePointer, "The 'format' field must be set to \"string\" or \"buffer\".");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_Integer frameByteBudget = 0;
+	lua_getfield(luaStatePointer, 1, "frameByteBudget");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		frameByteBudget = lua_tointeger(luaStatePointer, -1);
+		if (frameByteBudget <= 0)
+		{
+			CoronaLuaError(luaStatePointer, "The 'frameByteBudget' field must be set to a number greater than zero.");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	int reliableChannel = reliabilityPointer->GetChannel();
+	lua_getfield(luaStatePointer, 1, "reliableChannel");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		auto channel = lua_tointeger(luaStatePointer, -1);
+		if ((channel < 0) || (channel > 255))
+		{
+			CoronaLuaError(luaStatePointer, "The 'reliableChannel' field must be set to an integer between 0 and 255.");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+		reliableChannel = (int)channel;
+	}
+	else if ((lua_type(luaStatePointer, -1) == LUA_TBOOLEAN) && !lua_toboolean(luaStatePointer, -1))
+	{
+		reliableChannel = -1;
+	}
+	lua_pop(luaStatePointer, 1);
+	int snapshotChannel = replicatorPointer->GetChannel();
+	lua_getfield(luaStatePointer, 1, "snapshotChannel");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		auto channel = lua_tointeger(luaStatePointer, -1);
+		if ((channel < 0) || (channel > 255))
+		{
+			CoronaLuaError(luaStatePointer, "The 'snapshotChannel' field must be set to an integer between 0 and 255.");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+		snapshotChannel = (int)channel;
+	}
+	else if ((lua_type(luaStatePointer, -1) == LUA_TBOOLEAN) && !lua_toboolean(luaStatePointer, -1))
+	{
+		snapshotChannel = -1;
+	}
+	lua_pop(luaStatePointer, 1);
+	if ((snapshotChannel >= 0) && (snapshotChannel == reliableChannel))
+	{
+		CoronaLuaError(luaStatePointer, "The reliable and snapshot channels must be set to different channels.");
+		return 0;
+	}
+	bool hasChannels = false;
+	std::vector<uint8_t> channels;
+	lua_getfield(luaStatePointer, 1, "channels");
+	if (lua_istable(luaStatePointer, -1))
+	{
+		hasChannels = true;
+		auto channelCount = (int)lua_objlen(luaStatePointer, -1);
+		for (int index = 1; index <= channelCount; index++)
+		{
+			lua_rawgeti(luaStatePointer, -1, index);
+			auto channel = lua_tointeger(luaStatePointer, -1);
+			bool isValid = (lua_type(luaStatePointer, -1) == LUA_TNUMBER) && (channel >= 0) && (channel <= 255);
+			lua_pop(luaStatePointer, 1);
+			if (!isValid)
+			{
+				CoronaLuaError(luaStatePointer, "The 'channels' field must be an array of integers between 0 and 255.");
+				lua_pop(luaStatePointer, 1);
+				return 0;
+			}
+			channels.push_back((uint8_t)channel);
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	bool hasThreaded = false;
+	bool isThreaded = false;
+	lua_getfield(luaStatePointer, 1, "threaded");
+	if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+	{
+		hasThreaded = true;
+		isThreaded = lua_toboolean(luaStatePointer, -1) ? true : false;
+	}
+	lua_pop(luaStatePointer, 1);
+	bool hasAggregate = false;
+	bool isAggregating = false;
+	lua_getfield(luaStatePointer, 1, "aggregate");
+	if (lua_type(luaStatePointer, -1) == LUA_TBOOLEAN)
+	{
+		hasAggregate = true;
+		isAggregating = lua_toboolean(luaStatePointer, -1) ? true : false;
+	}
+	lua_pop(luaStatePointer, 1);
+	std::vector<std::pair<uint8_t, P2PNetworking::SendPriority>> channelPriorities;
+	lua_getfield(luaStatePointer, 1, "channelPriorities");
+	if (lua_istable(luaStatePointer, -1))
+	{
+		lua_pushnil(luaStatePointer);
+		while (lua_next(luaStatePointer, -2))
+		{
+			auto channel = lua_tointeger(luaStatePointer, -2);
+			bool isValidChannel =
+					(lua_type(luaStatePointer, -2) == LUA_TNUMBER) && (channel >= 0) && (channel <= 255);
+			const char* priorityName = (lua_type(luaStatePointer, -1) == LUA_TSTRING) ? lua_tostring(luaStatePointer, -1) : "";
+			P2PNetworking::SendPriority priority = P2PNetworking::SendPriority::kNormal;
+			bool isValidPriority = true;
+			if (!strcmp(priorityName, "high"))
+			{
+				priority = P2PNetworking::SendPriority::kHigh;
+			}
+			else if (!strcmp(priorityName, "low"))
+			{
+				priority = P2PNetworking::SendPriority::kLow;
+			}
+			else if (strcmp(priorityName, "normal"))
+			{
+				isValidPriority = false;
+			}
+			lua_pop(luaStatePointer, 1);
+			if (!isValidChannel || !isValidPriority)
+			{
+				CoronaLuaError(
+						luaStatePointer,
+						"The 'channelPriorities' field must map channels between 0 and 255 to \"high\", \"normal\" or \"low\".");
+				lua_pop(luaStatePointer, 2);
+				return 0;
+			}
+			channelPriorities.push_back(std::make_pair((uint8_t)channel, priority));
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	lua_Integer peerBandwidth = -1;
+	lua_getfield(luaStatePointer, 1, "peerBandwidth");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		peerBandwidth = lua_tointeger(luaStatePointer, -1);
+		if (peerBandwidth < 0)
+		{
+			CoronaLuaError(luaStatePointer, "The 'peerBandwidth' field must be set to a number of bytes per second, or zero.");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+	}
+	lua_pop(luaStatePointer, 1);
+	double peerStatsInterval = -1.0;
+	lua_getfield(luaStatePointer, 1, "peerStatsInterval");
+	if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+	{
+		auto seconds = lua_tonumber(luaStatePointer, -1);
+		if (!(seconds >= 0))
+		{
+			CoronaLuaError(luaStatePointer, "The 'peerStatsInterval' field must be set to a number of seconds, or zero.");
+			lua_pop(luaStatePointer, 1);
+			return 0;
+		}
+		peerStatsInterval = (double)seconds;
+	}
+	lua_pop(luaStatePointer, 1);
+
+	// Apply the settings.
+	// Note: Changing the reliable or snapshot channel updates the P2PNetworking's subscription by itself.
+	if (hasFormat)
+	{
+		networkingPointer->SetUsingBuffers(isUsingBuffers);
+	}
+	if (frameByteBudget > 0)
+	{
+		networkingPointer->SetFrameByteBudget((size_t)frameByteBudget);
+	}
+	reliabilityPointer->SetChannel(reliableChannel);
+	replicatorPointer->SetChannel(snapshotChannel);
+	if (hasChannels)
+	{
+		networkingPointer->SetUserChannels(channels);
+	}
+	if (hasThreaded)
+	{
+		networkingPointer->SetThreaded(isThreaded);
+	}
+	if (hasAggregate)
+	{
+		networkingPointer->SetAggregating(isAggregating);
+	}
+	for (auto&& channelPriority : channelPriorities)
+	{
+		networkingPointer->SetChannelPriority(channelPriority.first, channelPriority.second);
+	}
+	if (peerBandwidth >= 0)
+	{
+		networkingPointer->SetPeerBytesPerSecond((size_t)peerBandwidth);
+	}
+	if (peerStatsInterval >= 0)
+	{
+		contextPointer->GetPeerTelemetry()->SetIntervalInSeconds(peerStatsInterval);
+	}
+	return 0;
+}
+
+/** statsTable = gog.getPeerStats(userId) */
+int OnGetPeerStats(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Fetch the user ID.
+	auto userId = GetGalaxyIdFrom(luaStatePointer, 1);
+	if (!userId.IsValid())
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a user ID.");
+		return 0;
+	}
+
+	// Push the peer's statistics.
+	PeerTelemetry::PeerStatistics statistics;
+	contextPointer->GetPeerTelemetry()->GetStatisticsWith(userId, statistics);
+	PeerTelemetry::PushStatisticsTo(luaStatePointer, statistics);
+	return 1;
+}
+
+/** packedString = gog.pack(value) */
+int OnPack(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Pack the given value.
+	std::vector<char> bytes;
+	std::string errorMessage;
+	if (!PackLuaValueFrom(luaStatePointer, 1, bytes, errorMessage))
+	{
+		CoronaLuaError(luaStatePointer, "1st argument cannot be packed. %s", errorMessage.c_str());
+		return 0;
+	}
+	lua_pushlstring(luaStatePointer, bytes.data(), bytes.size());
+	return 1;
+}
+
+/** value = gog.unpack(stringOrBuffer) */
+int OnUnpack(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch the packed bytes.
+	size_t byteCount = 0;
+	auto bytesPointer = GetLuaBytesFrom(luaStatePointer, 1, &byteCount);
+	if (!bytesPointer)
+	{
+		CoronaLuaError(luaStatePointer, "1st argument must be set to a string or a valid buffer.");
+		return 0;
+	}
+
+	// Unpack them. Malformed bytes, such as from an untrusted peer, unpack to nil.
+	if (!PushUnpackedLuaValueTo(luaStatePointer, bytesPointer, byteCount))
+	{
+		lua_pushnil(luaStatePointer);
+	}
+	return 1;
+}
+
+/** statsTable = gog.getStats() */
+int OnGetStats(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return 0;
+	}
+
+	// Fetch this plugin's runtime context associated with the calling Lua state.
+	auto contextPointer = (RuntimeContext*)lua_touserdata(luaStatePointer, lua_upvalueindex(1));
+	if (!contextPointer)
+	{
+		return 0;
+	}
+
+	// Push a table of all statistics, grouped by subsystem.
+	lua_createtable(luaStatePointer, 0, 6);
+	{
+		auto& statistics = contextPointer->GetPayloadCodec()->GetStatistics();
+		lua_createtable(luaStatePointer, 0, 9);
+		lua_pushnumber(luaStatePointer, (double)statistics.EncodeCount);
+		lua_setfield(luaStatePointer, -2, "encodeCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.CompressedCount);
+		lua_setfield(luaStatePointer, -2, "compressedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.EncodeInputByteCount);
+		lua_setfield(luaStatePointer, -2, "bytesIn");
+		lua_pushnumber(luaStatePointer, (double)statistics.EncodeOutputByteCount);
+		lua_setfield(luaStatePointer, -2, "bytesOut");
+		double ratio = 1.0;
+		if (statistics.EncodeOutputByteCount > 0)
+		{
+			ratio = (double)statistics.EncodeInputByteCount / (double)statistics.EncodeOutputByteCount;
+		}
+		lua_pushnumber(luaStatePointer, ratio);
+		lua_setfield(luaStatePointer, -2, "ratio");
+		lua_pushnumber(luaStatePointer, (double)statistics.EncodeMicroseconds / 1000.0);
+		lua_setfield(luaStatePointer, -2, "encodeTimeMs");
+		lua_pushnumber(luaStatePointer, (double)statistics.DecodeCount);
+		lua_setfield(luaStatePointer, -2, "decodeCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DecodeFailureCount);
+		lua_setfield(luaStatePointer, -2, "decodeFailureCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DecodeMicroseconds / 1000.0);
+		lua_setfield(luaStatePointer, -2, "decodeTimeMs");
+		lua_setfield(luaStatePointer, -2, "compression");
+	}
+	{
+		auto& statistics = contextPointer->GetLobbyMessenger()->GetStatistics();
+		lua_createtable(luaStatePointer, 0, 8);
+		lua_pushnumber(luaStatePointer, (double)statistics.SentCount);
+		lua_setfield(luaStatePointer, -2, "sentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.FragmentedCount);
+		lua_setfield(luaStatePointer, -2, "fragmentedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.FragmentSentCount);
+		lua_setfield(luaStatePointer, -2, "fragmentSentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.RejectedCount);
+		lua_setfield(luaStatePointer, -2, "rejectedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ReceivedCount);
+		lua_setfield(luaStatePointer, -2, "receivedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ReassembledCount);
+		lua_setfield(luaStatePointer, -2, "reassembledCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ReassemblyDropCount);
+		lua_setfield(luaStatePointer, -2, "reassemblyDropCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DecodeDropCount);
+		lua_setfield(luaStatePointer, -2, "decodeDropCount");
+		lua_setfield(luaStatePointer, -2, "lobbyMessages");
+	}
+	{
+		auto networkingPointer = contextPointer->GetP2PNetworking();
+		auto& statistics = networkingPointer->GetStatistics();
+		lua_createtable(luaStatePointer, 0, 13);
+		lua_pushnumber(luaStatePointer, (double)statistics.SentCount);
+		lua_setfield(luaStatePointer, -2, "sentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DatagramSentCount);
+		lua_setfield(luaStatePointer, -2, "datagramSentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.SendFailureCount);
+		lua_setfield(luaStatePointer, -2, "sendFailureCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.SendQueueFullCount);
+		lua_setfield(luaStatePointer, -2, "sendQueueFullCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.SentByteCount);
+		lua_setfield(luaStatePointer, -2, "sentBytes");
+		lua_pushnumber(luaStatePointer, (double)statistics.ReceivedCount);
+		lua_setfield(luaStatePointer, -2, "receivedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ReceivedByteCount);
+		lua_setfield(luaStatePointer, -2, "receivedBytes");
+		lua_pushnumber(luaStatePointer, (double)statistics.BudgetExhaustedCount);
+		lua_setfield(luaStatePointer, -2, "budgetExhaustedCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.UnpackDropCount);
+		lua_setfield(luaStatePointer, -2, "unpackDropCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DeferredCount);
+		lua_setfield(luaStatePointer, -2, "deferredCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DeferredByteCount);
+		lua_setfield(luaStatePointer, -2, "deferredBytes");
+		lua_pushnumber(luaStatePointer, (double)statistics.ScheduleQueueFullCount);
+		lua_setfield(luaStatePointer, -2, "scheduleQueueFullCount");
+		lua_pushnumber(luaStatePointer, (double)networkingPointer->GetScheduledByteCount());
+		lua_setfield(luaStatePointer, -2, "scheduledBytes");
+		lua_setfield(luaStatePointer, -2, "p2p");
+	}
+	{
+		auto& statistics = contextPointer->GetP2PNetworking()->GetBufferPoolStatistics();
+		lua_createtable(luaStatePointer, 0, 5);
+		lua_pushnumber(luaStatePointer, (double)statistics.HitCount);
+		lua_setfield(luaStatePointer, -2, "hitCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.MissCount);
+		lua_setfield(luaStatePointer, -2, "missCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.InUseByteCount);
+		lua_setfield(luaStatePointer, -2, "inUseBytes");
+		lua_pushnumber(luaStatePointer, (double)statistics.HighWaterByteCount);
+		lua_setfield(luaStatePointer, -2, "highWaterBytes");
+		lua_pushnumber(luaStatePointer, (double)statistics.SlabByteCount);
+		lua_setfield(luaStatePointer, -2, "slabBytes");
+		lua_setfield(luaStatePointer, -2, "packetPool");
+	}
+	{
+		auto& statistics = contextPointer->GetP2PReliability()->GetStatistics();
+		lua_createtable(luaStatePointer, 0, 8);
+		lua_pushnumber(luaStatePointer, (double)statistics.SentCount);
+		lua_setfield(luaStatePointer, -2, "sentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ResendCount);
+		lua_setfield(luaStatePointer, -2, "resendCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.AckSentCount);
+		lua_setfield(luaStatePointer, -2, "ackSentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DeliveredCount);
+		lua_setfield(luaStatePointer, -2, "deliveredCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DuplicateCount);
+		lua_setfield(luaStatePointer, -2, "duplicateCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.OutOfOrderCount);
+		lua_setfield(luaStatePointer, -2, "outOfOrderCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.TimeoutCount);
+		lua_setfield(luaStatePointer, -2, "timeoutCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.ResetCount);
+		lua_setfield(luaStatePointer, -2, "resetCount");
+		lua_setfield(luaStatePointer, -2, "reliability");
+	}
+	{
+		auto& statistics = contextPointer->GetSnapshotReplicator()->GetStatistics();
+		lua_createtable(luaStatePointer, 0, 7);
+		lua_pushnumber(luaStatePointer, (double)statistics.SentCount);
+		lua_setfield(luaStatePointer, -2, "sentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.FullSentCount);
+		lua_setfield(luaStatePointer, -2, "fullSentCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.SnapshotByteCount);
+		lua_setfield(luaStatePointer, -2, "bytesIn");
+		lua_pushnumber(luaStatePointer, (double)statistics.EncodedByteCount);
+		lua_setfield(luaStatePointer, -2, "bytesOut");
+		double ratio = 1.0;
+		if (statistics.EncodedByteCount > 0)
+		{
+			ratio = (double)statistics.SnapshotByteCount / (double)statistics.EncodedByteCount;
+		}
+		lua_pushnumber(luaStatePointer, ratio);
+		lua_setfield(luaStatePointer, -2, "ratio");
+		lua_pushnumber(luaStatePointer, (double)statistics.DeliveredCount);
+		lua_setfield(luaStatePointer, -2, "deliveredCount");
+		lua_pushnumber(luaStatePointer, (double)statistics.DecodeDropCount);
+		lua_setfield(luaStatePointer, -2, "decodeDropCount");
+		lua_setfield(luaStatePointer, -2, "snapshots");
+	}
+	return 1;
+}
+
 /** gog.addEventListener(eventName, listener) */
 int OnAddEventListener(lua_State* luaStatePointer)
 {
@@ -434,6 +2442,35 @@ CORONA_EXPORT int luaopen_plugin_gog(lua_State* luaStatePointer)
 			{ "getEncryptedAppTicket", OnGetEncryptedAppTicket },
 			{ "requestEncryptedAppTicket", OnRequestEncryptedAppTicket },
 			{ "setAchievementUnlocked", OnSetAchievementUnlocked },
+			{ "getPersonaName", OnGetPersonaName },
+			{ "requestUserInformation", OnRequestUserInformation },
+			{ "setRichPresence", OnSetRichPresence },
+			{ "clearRichPresence", OnClearRichPresence },
+			{ "requestRichPresence", OnRequestRichPresence },
+			{ "getRichPresence", OnGetRichPresence },
+			{ "findUser", OnFindUser },
+			{ "requestLobbyList", OnRequestLobbyList },
+			{ "createLobby", OnCreateLobby },
+			{ "joinLobby", OnJoinLobby },
+			{ "leaveLobby", OnLeaveLobby },
+			{ "getLobbyData", OnGetLobbyData },
+			{ "getLobbyMemberData", OnGetLobbyMemberData },
+			{ "getLobbyRoster", OnGetLobbyRoster },
+			{ "setLobbyData", OnSetLobbyData },
+			{ "setLobbyMemberData", OnSetLobbyMemberData },
+			{ "sendLobbyMessage", OnSendLobbyMessage },
+			{ "setLobbyMessageFormat", OnSetLobbyMessageFormat },
+			{ "setCompression", OnSetCompression },
+			{ "getStats", OnGetStats },
+			{ "getPeerStats", OnGetPeerStats },
+			{ "pack", OnPack },
+			{ "unpack", OnUnpack },
+			{ "setHostElection", OnSetHostElection },
+			{ "getLobbyHost", OnGetLobbyHost },
+			{ "broadcast", OnBroadcast },
+			{ "sendP2PPacket", OnSendP2PPacket },
+			{ "sendSnapshot", OnSendSnapshot },
+			{ "setP2POptions", OnSetP2POptions },
 			{ "addEventListener", OnAddEventListener },
 			{ "removeEventListener", OnRemoveEventListener },
 			{ nullptr, nullptr }
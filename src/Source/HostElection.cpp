@@ -0,0 +1,432 @@
+// --------------------------------------------------------------------------------
+//
+// HostElection.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "HostElection.h"
+#include "DispatchEventTask.h"
+#include "LobbyMembership.h"
+#include "LobbyMessenger.h"
+#include "LobbyRoster.h"
+#include "PayloadCodec.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <memory>
+
+
+const uint8_t HostElection::kPingReportControlType = 0x01;
+const int HostElection::kReportIntervalInSeconds = 5;
+const int HostElection::kUnknownPing = 1000;
+
+/**
+  Size of a ping report's header: the sender's host followed by the host's nominated successor, as little endian
+  64-bit IDs. The successor is zero unless the sender is the host.
+ */
+static const size_t kReportHeaderByteCount = 16;
+
+/** Size of one ping report entry: a little endian 64-bit member ID followed by a 16-bit ping. */
+static const size_t kReportEntryByteCount = 10;
+
+/** Ping written to a report for members whose ping has not been determined yet. */
+static const uint16_t kUnknownReportPing = 0xFFFF;
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+/** Reads a little endian 64-bit integer from the given bytes. */
+static uint64_t ReadUInt64From(const uint8_t* bytesPointer)
+{
+	uint64_t value = 0;
+	for (int byteIndex = 7; byteIndex >= 0; byteIndex--)
+	{
+		value = (value << 8) | bytesPointer[byteIndex];
+	}
+	return value;
+}
+
+/** Appends the given integer to the given bytes in little endian order. */
+static void WriteUInt64To(std::vector<char>& bytes, uint64_t value)
+{
+	for (int byteIndex = 0; byteIndex < 8; byteIndex++)
+	{
+		bytes.push_back((char)((value >> (byteIndex * 8)) & 0xFF));
+	}
+}
+
+
+//---------------------------------------------------------------------------------
+// HostElection Class Members
+//---------------------------------------------------------------------------------
+
+HostElection::Election::Election()
+:	IsHostSynced(false),
+	IsReportDue(false)
+{
+}
+
+HostElection::HostElection(RuntimeContext& context)
+:	fContext(context),
+	fIsEnabled(false)
+{
+}
+
+HostElection::~HostElection()
+{
+}
+
+bool HostElection::IsEnabled() const
+{
+	return fIsEnabled;
+}
+
+void HostElection::SetEnabled(bool value)
+{
+	if (value == fIsEnabled)
+	{
+		return;
+	}
+	fIsEnabled = value;
+	if (value)
+	{
+		fContext.GetPayloadCodec()->SetMessageFramingEnabled(true);
+	}
+	else
+	{
+		fElectionMap.clear();
+	}
+}
+
+galaxy::api::GalaxyID HostElection::GetHostOf(const galaxy::api::GalaxyID& lobbyId) const
+{
+	auto iterator = fElectionMap.find(lobbyId.ToUint64());
+	return (iterator != fElectionMap.end()) ? iterator->second.HostId : galaxy::api::GalaxyID();
+}
+
+void HostElection::Process()
+{
+	// Do not continue if disabled.
+	if (!fIsEnabled)
+	{
+		return;
+	}
+
+	auto currentTime = std::chrono::steady_clock::now();
+	auto rosterPointer = fContext.GetLobbyRoster();
+	for (auto&& lobbyIntegerId : fContext.GetLobbyMembership()->GetLobbyIds())
+	{
+		galaxy::api::GalaxyID lobbyId(lobbyIntegerId);
+
+		// The lobby owner is the initial host, since every member agrees on it without measuring anything.
+		auto& election = fElectionMap[lobbyIntegerId];
+		if (!election.HostId.IsValid())
+		{
+			auto ownerId = rosterPointer->GetOwnerOf(lobbyId);
+			if (!ownerId.IsValid())
+			{
+				continue;
+			}
+			auto membersPointer = rosterPointer->GetMembersOf(lobbyId);
+			election.HostId = ownerId;
+			election.IsHostSynced = !membersPointer || (membersPointer->size() <= 1);
+			election.IsReportDue = true;
+			DispatchEventFor(lobbyId, ownerId, galaxy::api::GalaxyID(), "owner", -1);
+		}
+
+		// Send the user's ping report when due.
+		if (election.IsReportDue ||
+		    ((currentTime - election.LastReportTime) >= std::chrono::seconds(kReportIntervalInSeconds)))
+		{
+			SendReportFor(lobbyId, election);
+		}
+	}
+}
+
+void HostElection::OnPingReportReceived(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& senderId,
+	const char* bytesPointer, size_t byteCount)
+{
+	// Ignore reports for lobbies we're not electing a host for.
+	auto iterator = fElectionMap.find(lobbyId.ToUint64());
+	if (!fIsEnabled || (iterator == fElectionMap.end()) || !senderId.IsValid())
+	{
+		return;
+	}
+
+	// Validate.
+	if (!bytesPointer || (byteCount < kReportHeaderByteCount) ||
+	    ((byteCount - kReportHeaderByteCount) % kReportEntryByteCount) != 0)
+	{
+		return;
+	}
+	auto& election = iterator->second;
+	auto reportBytesPointer = (const uint8_t*)bytesPointer;
+
+	// Adopt the sender's host if we entered the lobby after the host was elected.
+	if (!election.IsHostSynced)
+	{
+		galaxy::api::GalaxyID senderHostId(ReadUInt64From(reportBytesPointer));
+		auto membersPointer = fContext.GetLobbyRoster()->GetMembersOf(lobbyId);
+		bool isMember = membersPointer &&
+				(std::find(membersPointer->begin(), membersPointer->end(), senderHostId) != membersPointer->end());
+		if (isMember)
+		{
+			election.IsHostSynced = true;
+			if (senderHostId != election.HostId)
+			{
+				auto previousHostId = election.HostId;
+				election.HostId = senderHostId;
+				DispatchEventFor(lobbyId, senderHostId, previousHostId, "synced", -1);
+			}
+		}
+	}
+
+	// Keep the host's latest nominated successor.
+	if (senderId == election.HostId)
+	{
+		election.SuccessorId = galaxy::api::GalaxyID(ReadUInt64From(reportBytesPointer + 8));
+	}
+
+	// Replace the sender's report.
+	auto& report = election.Reports[senderId.ToUint64()];
+	report.clear();
+	for (size_t offset = kReportHeaderByteCount; offset < byteCount; offset += kReportEntryByteCount)
+	{
+		auto memberIntegerId = ReadUInt64From(reportBytesPointer + offset);
+		auto ping = (uint16_t)(reportBytesPointer[offset + 8] | (reportBytesPointer[offset + 9] << 8));
+		if (ping != kUnknownReportPing)
+		{
+			report[memberIntegerId] = ping;
+		}
+	}
+}
+
+void HostElection::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	fElectionMap.erase(lobbyID.ToUint64());
+}
+
+void HostElection::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Ignore lobbies we're not electing a host for.
+	auto iterator = fElectionMap.find(lobbyID.ToUint64());
+	if (iterator == fElectionMap.end())
+	{
+		return;
+	}
+	auto& election = iterator->second;
+
+	// Let new members know our pings right away instead of on the next interval.
+	if (galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED == memberStateChange)
+	{
+		election.IsReportDue = true;
+		return;
+	}
+
+	// Forget a departed member's report.
+	// If the user is the host, nominate a new successor right away in case the departed member was the successor.
+	election.Reports.erase(memberID.ToUint64());
+	auto userPointer = galaxy::api::User();
+	bool isUserHost = userPointer && (userPointer->GetGalaxyID() == election.HostId);
+	if (memberID != election.HostId)
+	{
+		if (isUserHost)
+		{
+			election.IsReportDue = true;
+		}
+		return;
+	}
+
+	// The host has left. Switch to its nominated successor.
+	// Note: The member is excluded explicitly since the LobbyRoster may not have removed it yet.
+	auto previousHostId = election.HostId;
+	election.HostId = GetSuccessorOf(lobbyID, election, memberID);
+	election.SuccessorId = galaxy::api::GalaxyID();
+	election.IsHostSynced = true;
+	if (election.HostId.IsValid())
+	{
+		// If the user is the new host, nominate its own successor right away.
+		if (userPointer && (userPointer->GetGalaxyID() == election.HostId))
+		{
+			election.IsReportDue = true;
+		}
+		auto membersPointer = fContext.GetLobbyRoster()->GetMembersOf(lobbyID);
+		int aggregatePing = membersPointer ?
+				GetAggregatePingOf(membersPointer, election, election.HostId, memberID) : -1;
+		DispatchEventFor(lobbyID, election.HostId, previousHostId, "hostLeft", aggregatePing);
+	}
+}
+
+void HostElection::SendReportFor(const galaxy::api::GalaxyID& lobbyId, Election& election)
+{
+	election.IsReportDue = false;
+	election.LastReportTime = std::chrono::steady_clock::now();
+
+	// Fetch the lobby's members and the user.
+	auto membersPointer = fContext.GetLobbyRoster()->GetMembersOf(lobbyId);
+	auto networkingPointer = galaxy::api::Networking();
+	auto userPointer = galaxy::api::User();
+	if (!membersPointer || !networkingPointer || !userPointer)
+	{
+		return;
+	}
+	auto userId = userPointer->GetGalaxyID();
+
+	// If the user is the host, nominate its successor from the reports the user holds.
+	galaxy::api::GalaxyID successorId;
+	if (userId == election.HostId)
+	{
+		int aggregatePing = 0;
+		successorId = Elect(lobbyId, election, userId, aggregatePing);
+		election.SuccessorId = successorId;
+	}
+
+	// Measure the user's pings and keep them as the user's own report, exactly as the other members will see it.
+	auto& report = election.Reports[userId.ToUint64()];
+	report.clear();
+	fReportBytes.clear();
+	WriteUInt64To(fReportBytes, election.HostId.ToUint64());
+	WriteUInt64To(fReportBytes, successorId.IsValid() ? successorId.ToUint64() : 0);
+	for (auto&& memberId : *membersPointer)
+	{
+		if (memberId == userId)
+		{
+			continue;
+		}
+		auto ping = networkingPointer->GetPingWith(memberId);
+		uint16_t reportPing = kUnknownReportPing;
+		if (ping >= 0)
+		{
+			reportPing = (ping < (int)kUnknownReportPing) ? (uint16_t)ping : (uint16_t)(kUnknownReportPing - 1);
+			report[memberId.ToUint64()] = reportPing;
+		}
+		WriteUInt64To(fReportBytes, memberId.ToUint64());
+		fReportBytes.push_back((char)(reportPing & 0xFF));
+		fReportBytes.push_back((char)(reportPing >> 8));
+	}
+
+	// Send the report to the other members.
+	if (fReportBytes.size() > kReportHeaderByteCount)
+	{
+		fContext.GetLobbyMessenger()->SendControl(
+				lobbyId, kPingReportControlType, fReportBytes.data(), fReportBytes.size());
+	}
+}
+
+galaxy::api::GalaxyID HostElection::Elect(
+	const galaxy::api::GalaxyID& lobbyId, const Election& election,
+	const galaxy::api::GalaxyID& excludedMemberId, int& aggregatePing) const
+{
+	galaxy::api::GalaxyID hostId;
+	aggregatePing = 0;
+
+	// Fetch the lobby's members.
+	auto membersPointer = fContext.GetLobbyRoster()->GetMembersOf(lobbyId);
+	if (!membersPointer)
+	{
+		return hostId;
+	}
+
+	// Pick the candidate with the lowest sum of pings, breaking ties by the lowest ID so that all members agree.
+	for (auto&& candidateId : *membersPointer)
+	{
+		if (candidateId == excludedMemberId)
+		{
+			continue;
+		}
+		int candidatePing = GetAggregatePingOf(membersPointer, election, candidateId, excludedMemberId);
+		bool isBetter = !hostId.IsValid() || (candidatePing < aggregatePing) ||
+				((candidatePing == aggregatePing) && (candidateId.ToUint64() < hostId.ToUint64()));
+		if (isBetter)
+		{
+			hostId = candidateId;
+			aggregatePing = candidatePing;
+		}
+	}
+	return hostId;
+}
+
+galaxy::api::GalaxyID HostElection::GetSuccessorOf(
+	const galaxy::api::GalaxyID& lobbyId, const Election& election, const galaxy::api::GalaxyID& leavingHostId) const
+{
+	galaxy::api::GalaxyID hostId;
+
+	// Fetch the lobby's members.
+	auto membersPointer = fContext.GetLobbyRoster()->GetMembersOf(lobbyId);
+	if (!membersPointer)
+	{
+		return hostId;
+	}
+
+	// Use the host's nominated successor if it is still in the lobby.
+	auto& successorId = election.SuccessorId;
+	if (successorId.IsValid() && (successorId != leavingHostId) &&
+	    (std::find(membersPointer->begin(), membersPointer->end(), successorId) != membersPointer->end()))
+	{
+		return successorId;
+	}
+
+	// Otherwise fall back to the remaining member with the lowest ID, which needs no reports to agree on.
+	for (auto&& memberId : *membersPointer)
+	{
+		if ((memberId != leavingHostId) && (!hostId.IsValid() || (memberId.ToUint64() < hostId.ToUint64())))
+		{
+			hostId = memberId;
+		}
+	}
+	return hostId;
+}
+
+int HostElection::GetAggregatePingOf(
+	const std::vector<galaxy::api::GalaxyID>* membersPointer, const Election& election,
+	const galaxy::api::GalaxyID& candidateId, const galaxy::api::GalaxyID& excludedMemberId)
+{
+	int aggregatePing = 0;
+	for (auto&& memberId : *membersPointer)
+	{
+		if ((memberId != candidateId) && (memberId != excludedMemberId))
+		{
+			aggregatePing += GetPingBetween(election, candidateId, memberId);
+		}
+	}
+	return aggregatePing;
+}
+
+int HostElection::GetPingBetween(
+	const Election& election, const galaxy::api::GalaxyID& firstMemberId,
+	const galaxy::api::GalaxyID& secondMemberId)
+{
+	int pingSum = 0;
+	int pingCount = 0;
+	const galaxy::api::GalaxyID* memberIds[] = { &firstMemberId, &secondMemberId };
+	for (int index = 0; index < 2; index++)
+	{
+		auto reportIterator = election.Reports.find(memberIds[index]->ToUint64());
+		if (reportIterator == election.Reports.end())
+		{
+			continue;
+		}
+		auto pingIterator = reportIterator->second.find(memberIds[1 - index]->ToUint64());
+		if (pingIterator != reportIterator->second.end())
+		{
+			pingSum += pingIterator->second;
+			pingCount++;
+		}
+	}
+	return (pingCount > 0) ? (pingSum / pingCount) : kUnknownPing;
+}
+
+void HostElection::DispatchEventFor(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& hostId,
+	const galaxy::api::GalaxyID& previousHostId, const char* reasonName, int aggregatePing)
+{
+	auto taskPointer = std::make_shared<DispatchHostElectedEventTask>();
+	taskPointer->AcquireEventDataFrom(lobbyId, hostId, previousHostId, reasonName, aggregatePing);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
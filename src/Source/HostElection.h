@@ -0,0 +1,215 @@
+// ----------------------------------------------------------------------------
+//
+// HostElection.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Opt-in service electing the best connected member of each lobby as the host of the game's P2P session.
+
+  While enabled, every member periodically measures its ping with all other members via INetworking::GetPingWith()
+  and sends it to them as a control lobby message. The host elects its successor from the reports it holds, the
+  member with the lowest sum of pings with all other members, with ties broken by the lowest GalaxyID, and
+  nominates it in its own reports. When the host leaves, every member switches to the last successor nominated
+  by the host without any further round trip. Since members can hold different sets of reports, they never elect
+  a successor from their own reports. If the host never nominated one, the member with the lowest GalaxyID is used.
+
+  The lobby owner is the initial host of a new lobby. Reports also carry the sender's host, which a member
+  entering a lobby adopts from the first report it receives, since the owner may no longer be the host by then.
+  Every host change is dispatched to Lua as a "hostElected" event.
+
+  Note: Control messages require lobby message framing, which is therefore enabled along with this service.
+        All members have to enable the service for their reports to be taken into account.
+ */
+class HostElection
+:	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener
+{
+	public:
+		/** Control type of the lobby messages carrying ping reports. */
+		static const uint8_t kPingReportControlType;
+
+		/** Number of seconds between ping reports sent to each lobby. */
+		static const int kReportIntervalInSeconds;
+
+		/** Ping in milliseconds assumed between members who have not reported one. */
+		static const int kUnknownPing;
+
+		/**
+		  Creates a new host election service. The service is disabled by default.
+		  @param context The runtime context that will dispatch this service's events to Lua.
+		 */
+		HostElection(RuntimeContext& context);
+
+		virtual ~HostElection();
+
+		/**
+		  Determines if hosts are being elected.
+		  @return Returns true if enabled. Returns false if not.
+		 */
+		bool IsEnabled() const;
+
+		/**
+		  Enables or disables host election for all lobbies the user is in.
+		  Enabling it also enables the message framing of the context's PayloadCodec.
+		  @param value Set true to enable. Set false to disable and forget all reports and hosts.
+		 */
+		void SetEnabled(bool value);
+
+		/**
+		  Fetches the elected host of the given lobby.
+		  @param lobbyId The lobby to fetch the host of.
+		  @return Returns the host's ID. Returns an invalid ID if disabled or if no host has been elected yet.
+		 */
+		galaxy::api::GalaxyID GetHostOf(const galaxy::api::GalaxyID& lobbyId) const;
+
+		/**
+		  Elects the initial host of newly entered lobbies and sends the user's ping reports when due.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		/**
+		  To be called by the LobbyMessenger when a ping report control message has been received.
+		  @param lobbyId The lobby the report was received in.
+		  @param senderId The member who measured the pings.
+		  @param bytesPointer The report's bytes, following the control message's header.
+		  @param byteCount Number of bytes in the report.
+		 */
+		void OnPingReportReceived(
+				const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& senderId,
+				const char* bytesPointer, size_t byteCount);
+
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		HostElection(const HostElection&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const HostElection&) = delete;
+
+		/** Pings in milliseconds measured by one member, keyed by the other member's GalaxyID::ToUint64(). */
+		typedef std::unordered_map<uint64_t, int> PingReport;
+
+		struct Election
+		{
+			Election();
+
+			/** The lobby's elected host. Invalid until the initial host has been elected. */
+			galaxy::api::GalaxyID HostId;
+
+			/** The successor nominated by the host's latest report, or by the user while it is the host. */
+			galaxy::api::GalaxyID SuccessorId;
+
+			/** Set true once the host has been adopted from another member's report or has been elected. */
+			bool IsHostSynced;
+
+			/** The latest ping report of each member, including the user, keyed by GalaxyID::ToUint64(). */
+			std::unordered_map<uint64_t, PingReport> Reports;
+
+			/** Time the user last sent a ping report to the lobby. */
+			std::chrono::steady_clock::time_point LastReportTime;
+
+			/** Set true to send a ping report on the next Process() call, such as when a member has entered. */
+			bool IsReportDue;
+		};
+
+		/**
+		  Measures the user's pings with the lobby's members, stores them as the user's report and sends them.
+		  If the user is the host, the report also nominates the host's successor.
+		  @param lobbyId The lobby to send the report to.
+		  @param election The lobby's election state.
+		 */
+		void SendReportFor(const galaxy::api::GalaxyID& lobbyId, Election& election);
+
+		/**
+		  Picks the member with the lowest sum of pings with all other members.
+		  Only the host calls this, to nominate its successor, since other members may hold different reports.
+		  @param lobbyId The lobby to elect a host for.
+		  @param election The lobby's election state.
+		  @param excludedMemberId A member who is leaving and may not be elected. Can be invalid.
+		  @param aggregatePing Set to the elected member's sum of pings in milliseconds.
+		  @return Returns the elected member. Returns an invalid ID if there are no candidates.
+		 */
+		galaxy::api::GalaxyID Elect(
+				const galaxy::api::GalaxyID& lobbyId, const Election& election,
+				const galaxy::api::GalaxyID& excludedMemberId, int& aggregatePing) const;
+
+		/**
+		  Picks the host to switch to when the given host leaves: the host's nominated successor if still in the
+		  lobby, or else the remaining member with the lowest GalaxyID. Every member picks the same one.
+		  @param lobbyId The lobby to pick a new host for.
+		  @param election The lobby's election state.
+		  @param leavingHostId The host who is leaving.
+		  @return Returns the new host. Returns an invalid ID if there are no other members.
+		 */
+		galaxy::api::GalaxyID GetSuccessorOf(
+				const galaxy::api::GalaxyID& lobbyId, const Election& election,
+				const galaxy::api::GalaxyID& leavingHostId) const;
+
+		/**
+		  Sums the pings between the given member and all other members, according to the user's reports.
+		  @param membersPointer The lobby's members. Cannot be null.
+		  @param election The lobby's election state.
+		  @param candidateId The member to sum the pings of.
+		  @param excludedMemberId A member who is leaving and is not counted. Can be invalid.
+		  @return Returns the sum of pings in milliseconds.
+		 */
+		static int GetAggregatePingOf(
+				const std::vector<galaxy::api::GalaxyID>* membersPointer, const Election& election,
+				const galaxy::api::GalaxyID& candidateId, const galaxy::api::GalaxyID& excludedMemberId);
+
+		/**
+		  Fetches the ping between the given members, averaging both members' reports when available.
+		  @param election The lobby's election state.
+		  @param firstMemberId One member.
+		  @param secondMemberId The other member.
+		  @return Returns the ping in milliseconds. Returns kUnknownPing if neither member reported one.
+		 */
+		static int GetPingBetween(
+				const Election& election, const galaxy::api::GalaxyID& firstMemberId,
+				const galaxy::api::GalaxyID& secondMemberId);
+
+		/**
+		  Queues a "hostElected" event to be dispatched to Lua.
+		  @param lobbyId The lobby whose host has changed.
+		  @param hostId The new host.
+		  @param previousHostId The previous host. Can be invalid.
+		  @param reasonName Why the host has changed: "owner", "synced" or "hostLeft".
+		  @param aggregatePing The new host's sum of pings in milliseconds. Set to a negative value if not measured.
+		 */
+		void DispatchEventFor(
+				const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& hostId,
+				const galaxy::api::GalaxyID& previousHostId, const char* reasonName, int aggregatePing);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Set true if hosts are being elected. */
+		bool fIsEnabled;
+
+		/** Election state keyed by lobby GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, Election> fElectionMap;
+
+		/** Reusable buffer which outgoing ping reports are written to. */
+		std::vector<char> fReportBytes;
+};
@@ -0,0 +1,540 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyBrowser.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyBrowser.h"
+#include "DispatchEventTask.h"
+#include "PayloadCodec.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <tuple>
+
+
+const int LobbyBrowser::kTimeToLiveInSeconds = 5;
+const int LobbyBrowser::kMaxRetentionInSeconds = 60;
+const int LobbyBrowser::kRequestTimeoutInSeconds = 30;
+const int LobbyBrowser::kMaxConcurrentPrefetches = 4;
+const int LobbyBrowser::kPrefetchTimeoutInSeconds = 10;
+
+LobbyBrowser::Query::Query()
+:	AllowFullLobbies(false),
+	ResultCount(0),
+	PrefetchCount(0)
+{
+}
+
+LobbyBrowser::LobbyInfo::LobbyInfo()
+:	MemberCount(0),
+	MaxMemberCount(0),
+	IsHydrated(false)
+{
+}
+
+LobbyBrowser::RankWeights::RankWeights()
+:	IsEnabled(false),
+	Ping(-1.0),
+	FreeSlots(0),
+	DirectConnection(0),
+	ProxyConnection(0),
+	UnknownConnection(0),
+	UnknownPing(1000),
+	MaxPing(-1),
+	ResultCount(0)
+{
+}
+
+LobbyBrowser::Entry::Entry()
+:	IsQueued(false)
+{
+}
+
+LobbyBrowser::LobbyBrowser(RuntimeContext& context)
+:	fContext(context),
+	fPrefetchCount(0),
+	fNextPrefetchIndex(0),
+	fLastPruneTime(std::chrono::steady_clock::now()),
+	fNextRequestId(1)
+{
+}
+
+LobbyBrowser::~LobbyBrowser()
+{
+}
+
+uint32_t LobbyBrowser::Request(
+	Query& query, const std::vector<std::string>& dataKeys, int maxAgeInSeconds, const RankWeights& rankWeights)
+{
+	// Assign the request a unique ID. Zero is skipped on wraparound so that it never looks like a failure.
+	Waiter waiter;
+	waiter.RequestId = fNextRequestId++;
+	if (0 == fNextRequestId)
+	{
+		fNextRequestId = 1;
+	}
+	waiter.DataKeys = dataKeys;
+	waiter.Weights = rankWeights;
+	if (maxAgeInSeconds < 0)
+	{
+		maxAgeInSeconds = kTimeToLiveInSeconds;
+	}
+	maxAgeInSeconds = (std::min)(maxAgeInSeconds, kMaxRetentionInSeconds);
+
+	// Fetch the query's entry, creating it if this is the first time it's been requested.
+	auto key = NormalizeQuery(query);
+	auto& entry = fEntryMap[key];
+	bool isPending = IsPending(key, entry);
+	if (!isPending)
+	{
+		entry.QuerySettings = query;
+	}
+
+	// Answer with the cached result if it's fresh enough.
+	if (!isPending && entry.ResultPointer)
+	{
+		auto age = std::chrono::steady_clock::now() - entry.ResultTime;
+		if (age < std::chrono::seconds(maxAgeInSeconds))
+		{
+			DispatchEventFor(waiter, entry.ResultPointer, true);
+			return waiter.RequestId;
+		}
+	}
+
+	// Merge with the identical query if already queued or in-flight. Otherwise, queue it.
+	entry.Waiters.push_back(waiter);
+	if (!isPending)
+	{
+		entry.IsQueued = true;
+		fQueryQueue.push_back(key);
+	}
+	return waiter.RequestId;
+}
+
+void LobbyBrowser::Process()
+{
+	auto currentTime = std::chrono::steady_clock::now();
+
+	// Fail the in-flight query if the backend never responded.
+	if (!fInFlightKey.empty() && ((currentTime - fInFlightTime) >= std::chrono::seconds(kRequestTimeoutInSeconds)))
+	{
+		auto resultPointer = std::make_shared<ListResult>();
+		resultPointer->FailureReasonName = "timeout";
+		auto key = fInFlightKey;
+		fInFlightKey.clear();
+		CompleteQuery(key, resultPointer);
+	}
+
+	// Stop prefetching if it's taking too long and answer with the lobbies hydrated so far.
+	if (!fPrefetchKey.empty() && ((currentTime - fPrefetchStartTime) >= std::chrono::seconds(kPrefetchTimeoutInSeconds)))
+	{
+		EndPrefetch();
+	}
+
+	// Send the next queued query. Only one may be in-flight since the SDK's filters are global.
+	while (fInFlightKey.empty() && !fQueryQueue.empty())
+	{
+		auto key = fQueryQueue.front();
+		fQueryQueue.pop_front();
+		auto iterator = fEntryMap.find(key);
+		if ((iterator == fEntryMap.end()) || !iterator->second.IsQueued)
+		{
+			continue;
+		}
+		if (!SendQuery(iterator->second.QuerySettings))
+		{
+			fQueryQueue.push_front(key);
+			break;
+		}
+		if (!fPrefetchKey.empty())
+		{
+			// The lobby list being prefetched has been superseded by this query.
+			EndPrefetch();
+		}
+		iterator->second.IsQueued = false;
+		fInFlightKey = key;
+		fInFlightTime = currentTime;
+	}
+
+	// Discard results that are too old to be used by any request, once per second.
+	if ((currentTime - fLastPruneTime) >= std::chrono::seconds(1))
+	{
+		fLastPruneTime = currentTime;
+		for (auto iterator = fEntryMap.begin(); iterator != fEntryMap.end();)
+		{
+			auto& entry = iterator->second;
+			bool isPending = IsPending(iterator->first, entry);
+			bool isStale = !entry.ResultPointer ||
+					((currentTime - entry.ResultTime) >= std::chrono::seconds(kMaxRetentionInSeconds));
+			if (!isPending && isStale)
+			{
+				iterator = fEntryMap.erase(iterator);
+			}
+			else
+			{
+				++iterator;
+			}
+		}
+	}
+}
+
+void LobbyBrowser::OnLobbyList(uint32_t lobbyCount, galaxy::api::LobbyListResult result)
+{
+	// Ignore responses to requests that we didn't make.
+	if (fInFlightKey.empty())
+	{
+		return;
+	}
+	auto key = fInFlightKey;
+	fInFlightKey.clear();
+
+	// Copy the listed lobbies out of the SDK.
+	auto resultPointer = std::make_shared<ListResult>();
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (galaxy::api::LOBBY_LIST_RESULT_SUCCESS != result)
+	{
+		bool isConnectionFailure = (galaxy::api::LOBBY_LIST_RESULT_CONNECTION_FAILURE == result);
+		resultPointer->FailureReasonName = isConnectionFailure ? "connectionFailure" : "undefined";
+	}
+	else if (!matchmakingPointer)
+	{
+		resultPointer->FailureReasonName = "undefined";
+	}
+	else
+	{
+		resultPointer->Lobbies.reserve(lobbyCount);
+		for (uint32_t lobbyIndex = 0; lobbyIndex < lobbyCount; lobbyIndex++)
+		{
+			LobbyInfo lobbyInfo;
+			lobbyInfo.LobbyId = matchmakingPointer->GetLobbyByIndex(lobbyIndex);
+			if (!lobbyInfo.LobbyId.IsValid())
+			{
+				continue;
+			}
+			ReadLobbyInfoFromSdk(matchmakingPointer, lobbyInfo);
+			resultPointer->Lobbies.push_back(std::move(lobbyInfo));
+		}
+	}
+
+	// Answer the query now unless the top of the list needs to be prefetched first.
+	auto iterator = fEntryMap.find(key);
+	bool needsPrefetch =
+			(iterator != fEntryMap.end()) && (iterator->second.QuerySettings.PrefetchCount > 0) &&
+			resultPointer->FailureReasonName.empty() && !resultPointer->Lobbies.empty();
+	if (!needsPrefetch)
+	{
+		CompleteQuery(key, resultPointer);
+		return;
+	}
+
+	// Start prefetching. Only the newest list is prefetched, so any older prefetch is considered superseded.
+	if (!fPrefetchKey.empty())
+	{
+		EndPrefetch();
+	}
+	fPrefetchKey = key;
+	fPrefetchResultPointer = resultPointer;
+	fPrefetchCount = (std::min)((size_t)iterator->second.QuerySettings.PrefetchCount, resultPointer->Lobbies.size());
+	fNextPrefetchIndex = 0;
+	fPrefetchIndexMap.clear();
+	fPrefetchStartTime = std::chrono::steady_clock::now();
+	ContinuePrefetch();
+}
+
+void LobbyBrowser::OnLobbyDataRetrieveSuccess(const galaxy::api::GalaxyID& lobbyID)
+{
+	// Ignore responses to requests that we didn't make or have abandoned.
+	auto iterator = fPrefetchIndexMap.find(lobbyID.ToUint64());
+	if (iterator == fPrefetchIndexMap.end())
+	{
+		return;
+	}
+	auto lobbyIndex = iterator->second;
+	fPrefetchIndexMap.erase(iterator);
+
+	// Update the listed lobby with its fetched details.
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (matchmakingPointer && fPrefetchResultPointer && (lobbyIndex < fPrefetchResultPointer->Lobbies.size()))
+	{
+		auto& lobbyInfo = fPrefetchResultPointer->Lobbies[lobbyIndex];
+		ReadLobbyInfoFromSdk(matchmakingPointer, lobbyInfo);
+		lobbyInfo.IsHydrated = true;
+	}
+	ContinuePrefetch();
+}
+
+void LobbyBrowser::OnLobbyDataRetrieveFailure(
+	const galaxy::api::GalaxyID& lobbyID, galaxy::api::ILobbyDataRetrieveListener::FailureReason /*failureReason*/)
+{
+	// The lobby is left as listed. A lobby which has closed since it was listed will also end up here.
+	if (fPrefetchIndexMap.erase(lobbyID.ToUint64()) > 0)
+	{
+		ContinuePrefetch();
+	}
+}
+
+std::string LobbyBrowser::NormalizeQuery(Query& query)
+{
+	// Sort the order-independent filters and remove duplicates.
+	auto stringFilterLess = [](const StringFilter& x, const StringFilter& y)
+	{
+		return std::tie(x.Key, x.ComparisonType, x.Value) < std::tie(y.Key, y.ComparisonType, y.Value);
+	};
+	auto stringFilterEqual = [](const StringFilter& x, const StringFilter& y)
+	{
+		return (x.Key == y.Key) && (x.ComparisonType == y.ComparisonType) && (x.Value == y.Value);
+	};
+	std::sort(query.StringFilters.begin(), query.StringFilters.end(), stringFilterLess);
+	query.StringFilters.erase(
+			std::unique(query.StringFilters.begin(), query.StringFilters.end(), stringFilterEqual),
+			query.StringFilters.end());
+	auto numericalFilterLess = [](const NumericalFilter& x, const NumericalFilter& y)
+	{
+		return std::tie(x.Key, x.ComparisonType, x.Value) < std::tie(y.Key, y.ComparisonType, y.Value);
+	};
+	auto numericalFilterEqual = [](const NumericalFilter& x, const NumericalFilter& y)
+	{
+		return (x.Key == y.Key) && (x.ComparisonType == y.ComparisonType) && (x.Value == y.Value);
+	};
+	std::sort(query.NumericalFilters.begin(), query.NumericalFilters.end(), numericalFilterLess);
+	query.NumericalFilters.erase(
+			std::unique(query.NumericalFilters.begin(), query.NumericalFilters.end(), numericalFilterEqual),
+			query.NumericalFilters.end());
+
+	// Generate the key. Strings are length prefixed so that their contents can never be confused for delimiters.
+	std::ostringstream stream;
+	stream << "full=" << (query.AllowFullLobbies ? 1 : 0) << ";count=" << query.ResultCount;
+	stream << ";prefetch=" << query.PrefetchCount << ';';
+	for (auto&& filter : query.StringFilters)
+	{
+		stream << "s" << filter.Key.size() << ':' << filter.Key << (int)filter.ComparisonType;
+		stream << ':' << filter.Value.size() << ':' << filter.Value << ';';
+	}
+	for (auto&& filter : query.NumericalFilters)
+	{
+		stream << "n" << filter.Key.size() << ':' << filter.Key << (int)filter.ComparisonType;
+		stream << ':' << filter.Value << ';';
+	}
+	for (auto&& filter : query.NearValueFilters)
+	{
+		stream << "v" << filter.Key.size() << ':' << filter.Key << filter.Value << ';';
+	}
+	return stream.str();
+}
+
+void LobbyBrowser::ReadLobbyInfoFromSdk(galaxy::api::IMatchmaking* matchmakingPointer, LobbyInfo& lobbyInfo)
+{
+	lobbyInfo.OwnerId = matchmakingPointer->GetLobbyOwner(lobbyInfo.LobbyId);
+	lobbyInfo.MemberCount = matchmakingPointer->GetNumLobbyMembers(lobbyInfo.LobbyId);
+	lobbyInfo.MaxMemberCount = matchmakingPointer->GetMaxNumLobbyMembers(lobbyInfo.LobbyId);
+	lobbyInfo.Data.clear();
+	uint32_t dataCount = matchmakingPointer->GetLobbyDataCount(lobbyInfo.LobbyId);
+	char key[1024];
+	char value[4096];
+	for (uint32_t dataIndex = 0; dataIndex < dataCount; dataIndex++)
+	{
+		key[0] = value[0] = '\0';
+		bool wasCopied = matchmakingPointer->GetLobbyDataByIndex(
+				lobbyInfo.LobbyId, dataIndex, key, sizeof(key), value, sizeof(value));
+		if (wasCopied && (key[0] != '\0'))
+		{
+			fContext.GetPayloadCodec()->DecodeValue(value, lobbyInfo.Data[key]);
+		}
+	}
+}
+
+void LobbyBrowser::RankLobbies(
+	const ListResult& result, const RankWeights& weights, std::vector<RankedLobby>& rankedLobbies)
+{
+	rankedLobbies.clear();
+	rankedLobbies.reserve(result.Lobbies.size());
+	auto networkingPointer = galaxy::api::Networking();
+	for (size_t lobbyIndex = 0; lobbyIndex < result.Lobbies.size(); lobbyIndex++)
+	{
+		auto& lobbyInfo = result.Lobbies[lobbyIndex];
+
+		// Fetch the lobby's ping and its owner's connection type from the SDK.
+		// Note: The SDK provides an approximate ping with the lobby's owner when given a lobby ID.
+		RankedLobby rankedLobby;
+		rankedLobby.LobbyIndex = lobbyIndex;
+		rankedLobby.Ping = networkingPointer ? networkingPointer->GetPingWith(lobbyInfo.LobbyId) : -1;
+		rankedLobby.ConnectionType = galaxy::api::CONNECTION_TYPE_NONE;
+		if (networkingPointer && lobbyInfo.OwnerId.IsValid())
+		{
+			rankedLobby.ConnectionType = networkingPointer->GetConnectionType(lobbyInfo.OwnerId);
+		}
+		auto ping = (rankedLobby.Ping >= 0) ? rankedLobby.Ping : weights.UnknownPing;
+		if ((weights.MaxPing >= 0) && (ping > weights.MaxPing))
+		{
+			continue;
+		}
+
+		// Score the lobby.
+		auto freeSlotCount = (lobbyInfo.MaxMemberCount > lobbyInfo.MemberCount) ?
+				(lobbyInfo.MaxMemberCount - lobbyInfo.MemberCount) : 0;
+		double score = (weights.Ping * ping) + (weights.FreeSlots * freeSlotCount);
+		switch (rankedLobby.ConnectionType)
+		{
+			case galaxy::api::CONNECTION_TYPE_DIRECT:
+				score += weights.DirectConnection;
+				break;
+			case galaxy::api::CONNECTION_TYPE_PROXY:
+				score += weights.ProxyConnection;
+				break;
+			case galaxy::api::CONNECTION_TYPE_NONE:
+			default:
+				score += weights.UnknownConnection;
+				break;
+		}
+		for (auto&& dataWeight : weights.DataWeights)
+		{
+			auto iterator = lobbyInfo.Data.find(dataWeight.first);
+			if (iterator != lobbyInfo.Data.end())
+			{
+				score += dataWeight.second * strtod(iterator->second.c_str(), nullptr);
+			}
+		}
+		rankedLobby.Score = score;
+		rankedLobbies.push_back(rankedLobby);
+	}
+
+	// Sort best first. Equal scores keep the backend's order.
+	auto isBetter = [](const RankedLobby& x, const RankedLobby& y)
+	{
+		return x.Score > y.Score;
+	};
+	std::stable_sort(rankedLobbies.begin(), rankedLobbies.end(), isBetter);
+	if ((weights.ResultCount > 0) && (weights.ResultCount < rankedLobbies.size()))
+	{
+		rankedLobbies.resize(weights.ResultCount);
+	}
+}
+
+bool LobbyBrowser::SendQuery(const Query& query)
+{
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return false;
+	}
+	if (query.ResultCount > 0)
+	{
+		matchmakingPointer->AddRequestLobbyListResultCountFilter(query.ResultCount);
+	}
+	for (auto&& filter : query.StringFilters)
+	{
+		matchmakingPointer->AddRequestLobbyListStringFilter(
+				filter.Key.c_str(), filter.Value.c_str(), filter.ComparisonType);
+	}
+	for (auto&& filter : query.NumericalFilters)
+	{
+		matchmakingPointer->AddRequestLobbyListNumericalFilter(filter.Key.c_str(), filter.Value, filter.ComparisonType);
+	}
+	for (auto&& filter : query.NearValueFilters)
+	{
+		matchmakingPointer->AddRequestLobbyListNearValueFilter(filter.Key.c_str(), filter.Value);
+	}
+	matchmakingPointer->RequestLobbyList(query.AllowFullLobbies);
+	return true;
+}
+
+void LobbyBrowser::CompleteQuery(const std::string& key, const std::shared_ptr<const ListResult>& resultPointer)
+{
+	// Fetch the query's entry.
+	auto iterator = fEntryMap.find(key);
+	if (iterator == fEntryMap.end())
+	{
+		return;
+	}
+	auto& entry = iterator->second;
+
+	// Cache successful results. Failures are never cached so that the next identical query retries.
+	if (resultPointer->FailureReasonName.empty())
+	{
+		entry.ResultPointer = resultPointer;
+		entry.ResultTime = std::chrono::steady_clock::now();
+	}
+
+	// Answer all requests merged into this query.
+	std::vector<Waiter> waiters;
+	waiters.swap(entry.Waiters);
+	for (auto&& waiter : waiters)
+	{
+		DispatchEventFor(waiter, resultPointer, false);
+	}
+}
+
+void LobbyBrowser::ContinuePrefetch()
+{
+	// Validate.
+	if (fPrefetchKey.empty() || !fPrefetchResultPointer)
+	{
+		return;
+	}
+
+	// Send RequestLobbyData() calls while under the concurrency limit.
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	while (matchmakingPointer &&
+	       ((int)fPrefetchIndexMap.size() < kMaxConcurrentPrefetches) && (fNextPrefetchIndex < fPrefetchCount))
+	{
+		auto lobbyIndex = fNextPrefetchIndex++;
+		auto& lobbyId = fPrefetchResultPointer->Lobbies[lobbyIndex].LobbyId;
+		fPrefetchIndexMap[lobbyId.ToUint64()] = lobbyIndex;
+		matchmakingPointer->RequestLobbyData(lobbyId);
+	}
+
+	// Answer the query once all of the lobbies to prefetch have responded.
+	if (fPrefetchIndexMap.empty() && ((fNextPrefetchIndex >= fPrefetchCount) || !matchmakingPointer))
+	{
+		EndPrefetch();
+	}
+}
+
+void LobbyBrowser::EndPrefetch()
+{
+	// Validate.
+	if (fPrefetchKey.empty())
+	{
+		return;
+	}
+
+	// Reset prefetching state before answering so that late responses are ignored.
+	auto key = fPrefetchKey;
+	std::shared_ptr<const ListResult> resultPointer = fPrefetchResultPointer;
+	fPrefetchKey.clear();
+	fPrefetchResultPointer = nullptr;
+	fPrefetchIndexMap.clear();
+	fPrefetchCount = 0;
+	fNextPrefetchIndex = 0;
+	if (resultPointer)
+	{
+		CompleteQuery(key, resultPointer);
+	}
+}
+
+bool LobbyBrowser::IsPending(const std::string& key, const Entry& entry) const
+{
+	return entry.IsQueued || (fInFlightKey == key) || (fPrefetchKey == key);
+}
+
+void LobbyBrowser::DispatchEventFor(
+	const Waiter& waiter, const std::shared_ptr<const ListResult>& resultPointer, bool isCached)
+{
+	// Rank the lobbies for this request only, since the result may be shared with other requests.
+	std::vector<RankedLobby> rankedLobbies;
+	bool isRanked = waiter.Weights.IsEnabled && resultPointer->FailureReasonName.empty();
+	if (isRanked)
+	{
+		RankLobbies(*resultPointer, waiter.Weights, rankedLobbies);
+	}
+
+	auto taskPointer = std::make_shared<DispatchLobbyListEventTask>();
+	taskPointer->AcquireEventDataFrom(
+			waiter.RequestId, resultPointer, waiter.DataKeys, isCached, isRanked ? &rankedLobbies : nullptr);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
@@ -0,0 +1,360 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyBrowser.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Lobby query engine built on top of IMatchmaking::RequestLobbyList() and its filter functions.
+
+  Lua provides a declarative query which is normalized into a cache key, making queries which only differ
+  by filter order equivalent. Answered queries are cached for a short time and identical queries made
+  while one is queued or in-flight are merged into it. Since the SDK's lobby list filters are global state
+  which is consumed by the next RequestLobbyList() call, only one query is sent to the backend at a time.
+
+  A query can optionally prefetch the details of its first N listed lobbies via RequestLobbyData(), in which case
+  the query is not answered until those lobbies have been hydrated. Prefetching is abandoned, and the query answered
+  with what it has, when the next query is sent to the backend since the old list is then considered superseded.
+
+  A request can optionally rank the listed lobbies by a weighted score of their ping, connection type, free slots
+  and numeric lobby data. Ranking is done per request when it is answered, after the list has been received or
+  taken from the cache, so that the scores use the latest pings even when the list itself is shared.
+
+  Every Request() call is answered by exactly one "lobbyList" event providing all listed lobbies in one array.
+ */
+class LobbyBrowser
+:	public galaxy::api::GlobalLobbyListListener,
+	public galaxy::api::GlobalLobbyDataRetrieveListener
+{
+	public:
+		/** Default number of seconds a query's result can be reused by identical queries. */
+		static const int kTimeToLiveInSeconds;
+
+		/** Number of seconds results are retained for queries requesting a longer max age. */
+		static const int kMaxRetentionInSeconds;
+
+		/** Number of seconds to wait for a RequestLobbyList() response before failing the query. */
+		static const int kRequestTimeoutInSeconds;
+
+		/** Maximum number of RequestLobbyData() calls allowed to be awaiting a response while prefetching. */
+		static const int kMaxConcurrentPrefetches;
+
+		/** Number of seconds to spend prefetching before answering the query with the lobbies hydrated so far. */
+		static const int kPrefetchTimeoutInSeconds;
+
+		/** Filter matching a lobby data value by string comparison. */
+		struct StringFilter
+		{
+			std::string Key;
+			std::string Value;
+			galaxy::api::LobbyComparisonType ComparisonType;
+		};
+
+		/** Filter matching a lobby data value by integer comparison. */
+		struct NumericalFilter
+		{
+			std::string Key;
+			int32_t Value;
+			galaxy::api::LobbyComparisonType ComparisonType;
+		};
+
+		/** Filter sorting lobbies by how close a lobby data value is to the given value. */
+		struct NearValueFilter
+		{
+			std::string Key;
+			int32_t Value;
+		};
+
+		/** Describes which lobbies to list. */
+		struct Query
+		{
+			Query();
+
+			/** Set true to include full lobbies in the list. */
+			bool AllowFullLobbies;
+
+			/** Maximum number of lobbies to list. Set to zero to use the backend's default. */
+			uint32_t ResultCount;
+
+			/** Number of listed lobbies, from the top, to fetch the details of before answering the query. */
+			uint32_t PrefetchCount;
+
+			std::vector<StringFilter> StringFilters;
+			std::vector<NumericalFilter> NumericalFilters;
+
+			/** Near value filters. Unlike the other filters, their order is significant. */
+			std::vector<NearValueFilter> NearValueFilters;
+		};
+
+		/** Snapshot of one listed lobby. */
+		struct LobbyInfo
+		{
+			LobbyInfo();
+
+			galaxy::api::GalaxyID LobbyId;
+			galaxy::api::GalaxyID OwnerId;
+			uint32_t MemberCount;
+			uint32_t MaxMemberCount;
+
+			/** Set true if the lobby's details were fetched via RequestLobbyData() before the query was answered. */
+			bool IsHydrated;
+
+			/** All of the lobby's data key/value pairs available when the list was received. */
+			std::map<std::string, std::string> Data;
+		};
+
+		/** Weights used to score and sort the listed lobbies. Each weight is multiplied by its lobby's value. */
+		struct RankWeights
+		{
+			RankWeights();
+
+			/** Set true to rank the lobbies. Lobbies are provided in the backend's order otherwise. */
+			bool IsEnabled;
+
+			/** Weight of the ping with the lobby in milliseconds. Defaults to -1 so that lower pings rank first. */
+			double Ping;
+
+			/** Weight of the number of free member slots. */
+			double FreeSlots;
+
+			/** Score added for lobbies whose owner is connected directly. */
+			double DirectConnection;
+
+			/** Score added for lobbies whose owner is connected through a proxy. */
+			double ProxyConnection;
+
+			/**
+			  Score added for lobbies whose owner has no peer-to-peer connection with the user, which is the case
+			  for most lobbies the user has not joined. Their connection type is unknown, so this defaults to 0.
+			 */
+			double UnknownConnection;
+
+			/** Ping in milliseconds assumed for lobbies whose ping has not been determined yet. */
+			int UnknownPing;
+
+			/** Lobbies with a higher ping in milliseconds are excluded. Set to a negative value for no limit. */
+			int MaxPing;
+
+			/** Maximum number of ranked lobbies to provide. Set to zero to provide all of them. */
+			uint32_t ResultCount;
+
+			/** Weights of lobby data values, by key. Values which are not numbers count as zero. */
+			std::vector<std::pair<std::string, double>> DataWeights;
+		};
+
+		/** A listed lobby's position and score after ranking. */
+		struct RankedLobby
+		{
+			/** Index of the lobby in its ListResult. */
+			size_t LobbyIndex;
+
+			double Score;
+
+			/** Ping with the lobby in milliseconds, or -1 if it has not been determined yet. */
+			int Ping;
+
+			galaxy::api::ConnectionType ConnectionType;
+		};
+
+		/** The answer to one query. Shared, immutable, between the cache and all events dispatching it. */
+		struct ListResult
+		{
+			std::vector<LobbyInfo> Lobbies;
+
+			/** Name of the failure reason. Empty if the list was received successfully. */
+			std::string FailureReasonName;
+		};
+
+		/**
+		  Creates a new lobby browser.
+		  @param context The runtime context that will dispatch this browser's events to Lua.
+		 */
+		LobbyBrowser(RuntimeContext& context);
+
+		virtual ~LobbyBrowser();
+
+		/**
+		  Requests a list of lobbies matching the given query.
+		  @param query The lobbies to list. Its filters will be sorted into their normalized order.
+		  @param dataKeys The lobby data keys to provide to Lua for each listed lobby.
+		  @param maxAgeInSeconds The maximum age of a cached result that can be used to answer this query.
+		                         Set to a negative value to use the default kTimeToLiveInSeconds.
+		  @param rankWeights How to rank the listed lobbies, if enabled.
+		  @return Returns a unique ID which will be provided by this request's "lobbyList" event.
+		 */
+		uint32_t Request(
+				Query& query, const std::vector<std::string>& dataKeys, int maxAgeInSeconds,
+				const RankWeights& rankWeights);
+
+		/**
+		  Sends the next queued query if none are in-flight, fails timed out queries and discards stale results.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnLobbyList(uint32_t lobbyCount, galaxy::api::LobbyListResult result);
+		virtual void OnLobbyDataRetrieveSuccess(const galaxy::api::GalaxyID& lobbyID);
+		virtual void OnLobbyDataRetrieveFailure(
+				const galaxy::api::GalaxyID& lobbyID,
+				galaxy::api::ILobbyDataRetrieveListener::FailureReason failureReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyBrowser(const LobbyBrowser&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyBrowser&) = delete;
+
+		/** A Request() call awaiting the result of its query. */
+		struct Waiter
+		{
+			uint32_t RequestId;
+			std::vector<std::string> DataKeys;
+			RankWeights Weights;
+		};
+
+		struct Entry
+		{
+			Entry();
+
+			/** The normalized query. */
+			Query QuerySettings;
+
+			/** Set true while in "fQueryQueue". */
+			bool IsQueued;
+
+			/** Requests to be answered once the query completes. */
+			std::vector<Waiter> Waiters;
+
+			/** The last successful result. Null if the query has never been answered. */
+			std::shared_ptr<const ListResult> ResultPointer;
+
+			/** Time the last result was received. */
+			std::chrono::steady_clock::time_point ResultTime;
+		};
+
+		/**
+		  Sorts the given query's filters into their normalized order and removes duplicates.
+		  @param query The query to normalize.
+		  @return Returns a string uniquely identifying the normalized query.
+		 */
+		static std::string NormalizeQuery(Query& query);
+
+		/**
+		  Copies the given lobby's owner, member counts and data out of the SDK.
+		  Data values are decoded via the context's PayloadCodec.
+		  @param matchmakingPointer The SDK's matchmaking interface. Cannot be null.
+		  @param lobbyInfo The lobby to update. Its "LobbyId" field must be set.
+		 */
+		void ReadLobbyInfoFromSdk(galaxy::api::IMatchmaking* matchmakingPointer, LobbyInfo& lobbyInfo);
+
+		/**
+		  Scores the given result's lobbies and sorts them from best to worst.
+		  @param result The listed lobbies to rank.
+		  @param weights The weights to score the lobbies with.
+		  @param rankedLobbies Set to the ranked lobbies, best first. Excludes lobbies over the weights' max ping.
+		 */
+		static void RankLobbies(
+				const ListResult& result, const RankWeights& weights, std::vector<RankedLobby>& rankedLobbies);
+
+		/**
+		  Applies the given query's filters and calls RequestLobbyList().
+		  @param query The query to send.
+		  @return Returns true if the request was sent. Returns false if the SDK is unavailable.
+		 */
+		static bool SendQuery(const Query& query);
+
+		/**
+		  Answers all of the given query's waiters with the given result.
+		  Caches the result if it was successful.
+		  @param key The normalized key of the query to answer.
+		  @param resultPointer The result to answer with. Cannot be null.
+		 */
+		void CompleteQuery(const std::string& key, const std::shared_ptr<const ListResult>& resultPointer);
+
+		/**
+		  Sends RequestLobbyData() calls for the prefetching query's next lobbies while under the concurrency limit,
+		  and answers the query once all of its lobbies to prefetch have responded.
+		 */
+		void ContinuePrefetch();
+
+		/**
+		  Stops prefetching and answers the prefetching query with the lobbies hydrated so far.
+		  Late RequestLobbyData() responses are ignored afterwards.
+		 */
+		void EndPrefetch();
+
+		/**
+		  Determines if the given query is queued, in-flight or prefetching.
+		  @param key The query's normalized key.
+		  @param entry The query's entry.
+		  @return Returns true if the query has not been answered yet.
+		 */
+		bool IsPending(const std::string& key, const Entry& entry) const;
+
+		/**
+		  Queues a "lobbyList" event to be dispatched to Lua.
+		  @param waiter The request being answered.
+		  @param resultPointer The result to provide.
+		  @param isCached Set true if answered from the cache.
+		 */
+		void DispatchEventFor(const Waiter& waiter, const std::shared_ptr<const ListResult>& resultPointer, bool isCached);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Queued, in-flight and answered queries keyed by normalized query string. */
+		std::unordered_map<std::string, Entry> fEntryMap;
+
+		/** Keys of queries waiting to be sent, in request order. */
+		std::deque<std::string> fQueryQueue;
+
+		/** Key of the query awaiting an OnLobbyList() response. Empty if no query is in-flight. */
+		std::string fInFlightKey;
+
+		/** Time the in-flight query was sent. */
+		std::chrono::steady_clock::time_point fInFlightTime;
+
+		/** Key of the query whose lobbies are being prefetched. Empty if not prefetching. */
+		std::string fPrefetchKey;
+
+		/** The listed lobbies being prefetched, which will answer the query once hydrated. */
+		std::shared_ptr<ListResult> fPrefetchResultPointer;
+
+		/** Number of lobbies, from the top of the list, being prefetched. */
+		size_t fPrefetchCount;
+
+		/** Index of the next lobby in the prefetch result to send a RequestLobbyData() call for. */
+		size_t fNextPrefetchIndex;
+
+		/** Maps in-flight RequestLobbyData() lobby IDs to their index in the prefetch result. */
+		std::unordered_map<uint64_t, size_t> fPrefetchIndexMap;
+
+		/** Time prefetching started. */
+		std::chrono::steady_clock::time_point fPrefetchStartTime;
+
+		/** Time Process() last pruned stale results from the cache. */
+		std::chrono::steady_clock::time_point fLastPruneTime;
+
+		/** The ID to be assigned to the next Request() call. */
+		uint32_t fNextRequestId;
+};
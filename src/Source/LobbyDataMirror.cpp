@@ -0,0 +1,293 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyDataMirror.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyDataMirror.h"
+#include "DispatchEventTask.h"
+#include "LobbyMembership.h"
+#include "PayloadCodec.h"
+#include "RuntimeContext.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+LobbyDataMirror::LobbyEntry::LobbyEntry()
+:	HasData(false),
+	IsDirty(false)
+{
+}
+
+LobbyDataMirror::LobbyDataMirror(RuntimeContext& context)
+:	fContext(context)
+{
+}
+
+LobbyDataMirror::~LobbyDataMirror()
+{
+}
+
+const LobbyDataMirror::DataMap* LobbyDataMirror::GetDataFor(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId)
+{
+	// Validate.
+	if (!lobbyId.IsValid())
+	{
+		return nullptr;
+	}
+
+	// Only lobbies the user is in are mirrored. Copy the data of any other lobby out of the SDK every time.
+	auto membershipPointer = fContext.GetLobbyMembership();
+	if (!membershipPointer || !membershipPointer->IsInLobby(lobbyId))
+	{
+		ReadDataFromSdk(lobbyId, memberId, fUnmirroredData);
+		return &fUnmirroredData;
+	}
+
+	// Fetch the requested data, copying it out of the SDK if this is the first time it's been accessed.
+	auto& lobbyEntry = fLobbyMap[lobbyId.ToUint64()];
+	if (memberId.IsValid())
+	{
+		auto iterator = lobbyEntry.MemberDataMap.find(memberId.ToUint64());
+		if (iterator == lobbyEntry.MemberDataMap.end())
+		{
+			auto& data = lobbyEntry.MemberDataMap[memberId.ToUint64()];
+			ReadDataFromSdk(lobbyId, memberId, data);
+			return &data;
+		}
+		return &iterator->second;
+	}
+	if (!lobbyEntry.HasData)
+	{
+		ReadDataFromSdk(lobbyId, memberId, lobbyEntry.Data);
+		lobbyEntry.HasData = true;
+	}
+	return &lobbyEntry.Data;
+}
+
+bool LobbyDataMirror::PushTo(
+	lua_State* luaStatePointer, const galaxy::api::GalaxyID& lobbyId,
+	const galaxy::api::GalaxyID& memberId, const char* key)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Fetch the requested data.
+	auto dataPointer = GetDataFor(lobbyId, memberId);
+	if (!dataPointer)
+	{
+		return false;
+	}
+
+	// Push the requested value, if given a key.
+	if (key)
+	{
+		auto iterator = dataPointer->find(key);
+		if (iterator != dataPointer->end())
+		{
+			lua_pushlstring(luaStatePointer, iterator->second.c_str(), iterator->second.size());
+		}
+		else
+		{
+			lua_pushnil(luaStatePointer);
+		}
+		return true;
+	}
+
+	// Push all of the key/value pairs as a table.
+	lua_createtable(luaStatePointer, 0, (int)dataPointer->size());
+	for (auto&& pair : *dataPointer)
+	{
+		lua_pushlstring(luaStatePointer, pair.second.c_str(), pair.second.size());
+		lua_setfield(luaStatePointer, -2, pair.first.c_str());
+	}
+	return true;
+}
+
+void LobbyDataMirror::Process()
+{
+	// Do not continue if nothing has changed since the last frame.
+	if (fDirtyLobbyIds.empty())
+	{
+		return;
+	}
+
+	// Refresh all dirty data once, no matter how many update callbacks were received for it this frame.
+	std::unordered_set<uint64_t> dirtyLobbyIds;
+	dirtyLobbyIds.swap(fDirtyLobbyIds);
+	for (auto&& lobbyIdValue : dirtyLobbyIds)
+	{
+		auto lobbyIterator = fLobbyMap.find(lobbyIdValue);
+		if (lobbyIterator == fLobbyMap.end())
+		{
+			continue;
+		}
+		galaxy::api::GalaxyID lobbyId(lobbyIdValue);
+		auto& lobbyEntry = lobbyIterator->second;
+		if (lobbyEntry.IsDirty)
+		{
+			lobbyEntry.IsDirty = false;
+			lobbyEntry.HasData = true;
+			Refresh(lobbyId, galaxy::api::GalaxyID(), lobbyEntry.Data);
+		}
+		for (auto&& memberIdValue : lobbyEntry.DirtyMemberIds)
+		{
+			galaxy::api::GalaxyID memberId(memberIdValue);
+			Refresh(lobbyId, memberId, lobbyEntry.MemberDataMap[memberIdValue]);
+		}
+		lobbyEntry.DirtyMemberIds.clear();
+	}
+}
+
+void LobbyDataMirror::OnLobbyDataUpdated(const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID)
+{
+	// Validate.
+	if (!lobbyID.IsValid())
+	{
+		return;
+	}
+
+	// Ignore lobbies the user is not in, such as those fetched by the LobbyBrowser.
+	auto membershipPointer = fContext.GetLobbyMembership();
+	if (!membershipPointer || !membershipPointer->IsInLobby(lobbyID))
+	{
+		return;
+	}
+
+	// Flag the lobby's or member's data to be re-read on the next Process() call.
+	auto& lobbyEntry = fLobbyMap[lobbyID.ToUint64()];
+	if (memberID.IsValid())
+	{
+		lobbyEntry.DirtyMemberIds.insert(memberID.ToUint64());
+	}
+	else
+	{
+		lobbyEntry.IsDirty = true;
+	}
+	fDirtyLobbyIds.insert(lobbyID.ToUint64());
+}
+
+void LobbyDataMirror::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	fLobbyMap.erase(lobbyID.ToUint64());
+	fDirtyLobbyIds.erase(lobbyID.ToUint64());
+}
+
+void LobbyDataMirror::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Drop the data of members who are no longer in the lobby.
+	if (galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED == memberStateChange)
+	{
+		return;
+	}
+	auto iterator = fLobbyMap.find(lobbyID.ToUint64());
+	if (iterator != fLobbyMap.end())
+	{
+		iterator->second.MemberDataMap.erase(memberID.ToUint64());
+		iterator->second.DirtyMemberIds.erase(memberID.ToUint64());
+	}
+}
+
+void LobbyDataMirror::ReadDataFromSdk(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId, DataMap& data)
+{
+	data.clear();
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	auto codecPointer = fContext.GetPayloadCodec();
+	if (!matchmakingPointer || !codecPointer)
+	{
+		return;
+	}
+	char key[1024];
+	char value[4096];
+	if (memberId.IsValid())
+	{
+		uint32_t count = matchmakingPointer->GetLobbyMemberDataCount(lobbyId, memberId);
+		for (uint32_t index = 0; index < count; index++)
+		{
+			key[0] = value[0] = '\0';
+			bool wasCopied = matchmakingPointer->GetLobbyMemberDataByIndex(
+					lobbyId, memberId, index, key, sizeof(key), value, sizeof(value));
+			if (wasCopied && (key[0] != '\0'))
+			{
+				codecPointer->DecodeValue(value, data[key]);
+			}
+		}
+	}
+	else
+	{
+		uint32_t count = matchmakingPointer->GetLobbyDataCount(lobbyId);
+		for (uint32_t index = 0; index < count; index++)
+		{
+			key[0] = value[0] = '\0';
+			bool wasCopied = matchmakingPointer->GetLobbyDataByIndex(
+					lobbyId, index, key, sizeof(key), value, sizeof(value));
+			if (wasCopied && (key[0] != '\0'))
+			{
+				codecPointer->DecodeValue(value, data[key]);
+			}
+		}
+	}
+}
+
+void LobbyDataMirror::Refresh(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId, DataMap& data)
+{
+	// Copy the latest data out of the SDK.
+	DataMap newData;
+	ReadDataFromSdk(lobbyId, memberId, newData);
+
+	// Diff the new data against the old. Both maps are sorted by key, so this is done in one pass.
+	std::vector<std::pair<std::string, std::string>> changedPairs;
+	std::vector<std::string> removedKeys;
+	auto oldIterator = data.begin();
+	auto newIterator = newData.begin();
+	while ((oldIterator != data.end()) || (newIterator != newData.end()))
+	{
+		if ((newIterator == newData.end()) ||
+		    ((oldIterator != data.end()) && (oldIterator->first < newIterator->first)))
+		{
+			removedKeys.push_back(oldIterator->first);
+			++oldIterator;
+		}
+		else if ((oldIterator == data.end()) || (newIterator->first < oldIterator->first))
+		{
+			changedPairs.push_back(*newIterator);
+			++newIterator;
+		}
+		else
+		{
+			if (oldIterator->second != newIterator->second)
+			{
+				changedPairs.push_back(*newIterator);
+			}
+			++oldIterator;
+			++newIterator;
+		}
+	}
+	data.swap(newData);
+
+	// Notify Lua about the changed keys, if any.
+	if (changedPairs.empty() && removedKeys.empty())
+	{
+		return;
+	}
+	auto taskPointer = std::make_shared<DispatchLobbyDataEventTask>();
+	taskPointer->AcquireEventDataFrom(lobbyId, memberId, changedPairs, removedKeys);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyDataMirror.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Keeps a native copy of the key/value data of lobbies and their members.
+
+  GOG's OnLobbyDataUpdated() callback only indicates that a lobby's or a member's data has changed.
+  This class flags the data as dirty when that happens and re-reads it once per frame in Process(), no matter
+  how many callbacks were received during that frame. The new data is then diffed against the previous copy
+  and a "lobbyData" event providing only the added, changed and removed keys is dispatched to Lua.
+
+  Lua reads lobby data from this mirror instead of calling the GOG SDK per key.
+  Only the lobbies the user is in are mirrored. The data of any other lobby, such as a listed lobby,
+  is read from the SDK on every access and never produces "lobbyData" events.
+ */
+class LobbyDataMirror
+:	public galaxy::api::GlobalLobbyDataListener,
+	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener
+{
+	public:
+		/** Stores key/value pairs sorted by key so that two sets can be diffed in one linear pass. */
+		typedef std::map<std::string, std::string> DataMap;
+
+		/**
+		  Creates a new mirror.
+		  @param context The runtime context that will dispatch this mirror's events to Lua.
+		 */
+		LobbyDataMirror(RuntimeContext& context);
+
+		virtual ~LobbyDataMirror();
+
+		/**
+		  Fetches the mirrored data of the given lobby or lobby member.
+		  The data is copied out of the SDK, without dispatching an event, if it has not been mirrored yet.
+		  @param lobbyId The lobby to fetch data from.
+		  @param memberId The lobby member to fetch data from. Set to an invalid ID to fetch the lobby's own data.
+		  @return Returns a pointer to the mirrored data. Returns null if given an invalid lobby ID.
+
+		          For a lobby the user is not in, returns a temporary copy that is only valid until the next call.
+		 */
+		const DataMap* GetDataFor(const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId);
+
+		/**
+		  Pushes the given lobby's or lobby member's mirrored data to Lua.
+		  @param luaStatePointer The Lua state to push to.
+		  @param lobbyId The lobby to push data from.
+		  @param memberId The lobby member to push data from. Set to an invalid ID for the lobby's own data.
+		  @param key The data key whose value should be pushed as a string, or nil if not set.
+		             Set to null to push all key/value pairs as a table.
+		  @return Returns true if a value was pushed to Lua. Returns false if given invalid arguments.
+		 */
+		bool PushTo(
+				lua_State* luaStatePointer, const galaxy::api::GalaxyID& lobbyId,
+				const galaxy::api::GalaxyID& memberId, const char* key);
+
+		/**
+		  Re-reads the data flagged as dirty since the last call and dispatches its changes to Lua.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnLobbyDataUpdated(const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID);
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyDataMirror(const LobbyDataMirror&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyDataMirror&) = delete;
+
+		struct LobbyEntry
+		{
+			LobbyEntry();
+
+			/** The lobby's own data. */
+			DataMap Data;
+
+			/** Set true once "Data" has been copied from the SDK at least once. */
+			bool HasData;
+
+			/** Set true if the lobby's own data needs to be re-read by Process(). */
+			bool IsDirty;
+
+			/** Data of each lobby member keyed by GalaxyID::ToUint64(). */
+			std::unordered_map<uint64_t, DataMap> MemberDataMap;
+
+			/** Members whose data needs to be re-read by Process(), keyed by GalaxyID::ToUint64(). */
+			std::unordered_set<uint64_t> DirtyMemberIds;
+		};
+
+		/**
+		  Copies the given lobby's or lobby member's data out of the SDK, decoding values via the context's PayloadCodec.
+		  @param lobbyId The lobby to read from.
+		  @param memberId The member to read from. Set to an invalid ID to read the lobby's own data.
+		  @param data The map to copy the data to. Its previous contents are removed.
+		 */
+		void ReadDataFromSdk(const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId, DataMap& data);
+
+		/**
+		  Re-reads the given data from the SDK and dispatches a "lobbyData" event if anything has changed.
+		  @param lobbyId The lobby to refresh.
+		  @param memberId The member to refresh. Set to an invalid ID to refresh the lobby's own data.
+		  @param data The mirrored data to update.
+		 */
+		void Refresh(const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& memberId, DataMap& data);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Mirrored lobbies keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, LobbyEntry> fLobbyMap;
+
+		/** IDs of lobbies having dirty data, so that Process() does not have to scan all mirrored lobbies. */
+		std::unordered_set<uint64_t> fDirtyLobbyIds;
+
+		/** Data returned by GetDataFor() for lobbies which are not mirrored. */
+		DataMap fUnmirroredData;
+};
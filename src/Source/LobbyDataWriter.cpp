@@ -0,0 +1,364 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyDataWriter.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyDataWriter.h"
+#include "DispatchEventTask.h"
+#include "LobbyDataMirror.h"
+#include "PayloadCodec.h"
+#include "RuntimeContext.h"
+#include <memory>
+
+
+const int LobbyDataWriter::kDebounceInMilliseconds = 100;
+const int LobbyDataWriter::kMaxDelayInMilliseconds = 500;
+const int LobbyDataWriter::kRequestTimeoutInSeconds = 15;
+
+LobbyDataWriter::LobbyBuffer::LobbyBuffer()
+:	IsWriteInFlight(false),
+	IsInFlightMemberWrite(false),
+	InFlightListenerPointer(nullptr),
+	IsFlushing(false),
+	FlushWriteCount(0),
+	FlushFailureCount(0),
+	HasPendingChanges(false)
+{
+}
+
+LobbyDataWriter::LobbyDataWriter(RuntimeContext& context)
+:	fContext(context)
+{
+}
+
+LobbyDataWriter::~LobbyDataWriter()
+{
+	for (auto&& pair : fListenerMap)
+	{
+		UnregisterListener(pair.second.get());
+	}
+}
+
+bool LobbyDataWriter::Set(const galaxy::api::GalaxyID& lobbyId, const char* key, const char* value, bool isMemberData)
+{
+	// Validate.
+	if (!lobbyId.IsValid() || !key || ('\0' == key[0]))
+	{
+		return false;
+	}
+	if (!value)
+	{
+		value = "";
+	}
+
+	// Collapse the write into the lobby's buffer.
+	auto& buffer = fBufferMap[lobbyId.ToUint64()];
+	auto& writes = isMemberData ? buffer.MemberWrites : buffer.LobbyWrites;
+	auto iterator = writes.find(key);
+	if (GetCurrentValue(lobbyId, buffer, key, isMemberData) == value)
+	{
+		// The lobby already has this value. Drop the write, along with any buffered write it reverts.
+		if (iterator != writes.end())
+		{
+			writes.erase(iterator);
+		}
+		return true;
+	}
+	if ((iterator != writes.end()) && (iterator->second == value))
+	{
+		return true;
+	}
+	writes[key] = value;
+
+	// Restart the lobby's debounce timer.
+	auto currentTime = std::chrono::steady_clock::now();
+	if (!buffer.HasPendingChanges)
+	{
+		buffer.HasPendingChanges = true;
+		buffer.FirstChangeTime = currentTime;
+	}
+	buffer.LastChangeTime = currentTime;
+	return true;
+}
+
+void LobbyDataWriter::Process()
+{
+	// Do not continue if there is nothing to write.
+	if (fBufferMap.empty())
+	{
+		return;
+	}
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return;
+	}
+
+	auto currentTime = std::chrono::steady_clock::now();
+	for (auto bufferIterator = fBufferMap.begin(); bufferIterator != fBufferMap.end();)
+	{
+		galaxy::api::GalaxyID lobbyId(bufferIterator->first);
+		auto& buffer = bufferIterator->second;
+
+		// Give up on a write that the backend never responded to.
+		if (buffer.IsWriteInFlight &&
+		    ((currentTime - buffer.InFlightTime) >= std::chrono::seconds(kRequestTimeoutInSeconds)))
+		{
+			auto listenerIterator = fListenerMap.find(buffer.InFlightListenerPointer);
+			CompleteWrite(lobbyId, buffer.InFlightListenerPointer, "timeout");
+			if (listenerIterator != fListenerMap.end())
+			{
+				UnregisterListener(listenerIterator->second.get());
+				fListenerMap.erase(listenerIterator);
+			}
+		}
+
+		// Only allow one write in-flight per lobby.
+		if (buffer.IsWriteInFlight)
+		{
+			++bufferIterator;
+			continue;
+		}
+
+		// Wait for the lobby's writes to settle, unless they have been changing for too long.
+		if (buffer.HasPendingChanges)
+		{
+			if (((currentTime - buffer.LastChangeTime) < std::chrono::milliseconds(kDebounceInMilliseconds)) &&
+			    ((currentTime - buffer.FirstChangeTime) < std::chrono::milliseconds(kMaxDelayInMilliseconds)))
+			{
+				++bufferIterator;
+				continue;
+			}
+			buffer.HasPendingChanges = false;
+		}
+
+		// Send the next buffered write, skipping writes that no longer change anything.
+		while (!buffer.LobbyWrites.empty() || !buffer.MemberWrites.empty())
+		{
+			bool isMemberWrite = buffer.LobbyWrites.empty();
+			auto& writes = isMemberWrite ? buffer.MemberWrites : buffer.LobbyWrites;
+			auto writeIterator = writes.begin();
+			std::string key(writeIterator->first);
+			std::string value;
+			value.swap(writeIterator->second);
+			writes.erase(writeIterator);
+			if (GetCurrentValue(lobbyId, buffer, key, isMemberWrite) == value)
+			{
+				continue;
+			}
+			buffer.IsFlushing = true;
+			buffer.IsWriteInFlight = true;
+			buffer.IsInFlightMemberWrite = isMemberWrite;
+			buffer.InFlightKey.swap(key);
+			buffer.InFlightValue.swap(value);
+			buffer.InFlightTime = currentTime;
+			buffer.FlushWriteCount++;
+			auto listenerPointer = new WriteListener(*this, lobbyId);
+			fListenerMap[listenerPointer].reset(listenerPointer);
+			buffer.InFlightListenerPointer = listenerPointer;
+			auto encodedValue = fContext.GetPayloadCodec()->EncodeValue(buffer.InFlightValue.c_str());
+			if (isMemberWrite)
+			{
+				matchmakingPointer->SetLobbyMemberData(
+						lobbyId, buffer.InFlightKey.c_str(), encodedValue.c_str(), listenerPointer);
+			}
+			else
+			{
+				matchmakingPointer->SetLobbyData(
+						lobbyId, buffer.InFlightKey.c_str(), encodedValue.c_str(), listenerPointer);
+			}
+			break;
+		}
+		if (buffer.IsWriteInFlight)
+		{
+			++bufferIterator;
+			continue;
+		}
+
+		// All buffered writes have been sent and acknowledged. Notify Lua if this ends a flush.
+		if (buffer.IsFlushing)
+		{
+			auto taskPointer = std::make_shared<DispatchLobbyDataWriteEventTask>();
+			taskPointer->AcquireEventDataFrom(
+					lobbyId, buffer.FlushWriteCount, buffer.FlushFailureCount,
+					buffer.FlushFailureReasonName.empty() ? nullptr : buffer.FlushFailureReasonName.c_str());
+			fContext.QueueDispatchEventTask(taskPointer);
+		}
+		bufferIterator = fBufferMap.erase(bufferIterator);
+	}
+}
+
+void LobbyDataWriter::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	// Buffered writes can no longer be made once out of the lobby.
+	// The in-flight write's response no longer matters either, so its listener is unregistered and deleted.
+	auto iterator = fBufferMap.find(lobbyID.ToUint64());
+	if (iterator == fBufferMap.end())
+	{
+		return;
+	}
+	auto listenerIterator = fListenerMap.find(iterator->second.InFlightListenerPointer);
+	if (listenerIterator != fListenerMap.end())
+	{
+		UnregisterListener(listenerIterator->second.get());
+		fListenerMap.erase(listenerIterator);
+	}
+	fBufferMap.erase(iterator);
+}
+
+void LobbyDataWriter::CompleteWrite(
+	const galaxy::api::GalaxyID& lobbyId, const WriteListener* listenerPointer, const char* failureReasonName)
+{
+	// Ignore responses to writes that are no longer in-flight, such as a late response to a timed out write.
+	auto iterator = fBufferMap.find(lobbyId.ToUint64());
+	if (iterator == fBufferMap.end())
+	{
+		return;
+	}
+	auto& buffer = iterator->second;
+	if (!buffer.IsWriteInFlight || !listenerPointer || (buffer.InFlightListenerPointer != listenerPointer))
+	{
+		return;
+	}
+
+	// End the write. Failed writes are not retried, but are reported by the flush's completion event.
+	buffer.IsWriteInFlight = false;
+	buffer.InFlightListenerPointer = nullptr;
+	buffer.InFlightKey.clear();
+	buffer.InFlightValue.clear();
+	if (failureReasonName)
+	{
+		buffer.FlushFailureCount++;
+		if (buffer.FlushFailureReasonName.empty())
+		{
+			buffer.FlushFailureReasonName = failureReasonName;
+		}
+	}
+}
+
+std::string LobbyDataWriter::GetCurrentValue(
+	const galaxy::api::GalaxyID& lobbyId, const LobbyBuffer& buffer,
+	const std::string& key, bool isMemberData) const
+{
+	// A key being written is expected to have the written value, even if the mirror hasn't caught up yet.
+	if (buffer.IsWriteInFlight && (buffer.IsInFlightMemberWrite == isMemberData) && (buffer.InFlightKey == key))
+	{
+		return buffer.InFlightValue;
+	}
+
+	// Otherwise, fetch the value from the mirror which is kept up to date by OnLobbyDataUpdated() callbacks.
+	galaxy::api::GalaxyID memberId;
+	if (isMemberData)
+	{
+		auto userPointer = galaxy::api::User();
+		if (!userPointer)
+		{
+			return std::string();
+		}
+		memberId = userPointer->GetGalaxyID();
+	}
+	auto mirrorPointer = fContext.GetLobbyDataMirror();
+	auto dataPointer = mirrorPointer ? mirrorPointer->GetDataFor(lobbyId, memberId) : nullptr;
+	if (!dataPointer)
+	{
+		return std::string();
+	}
+	auto iterator = dataPointer->find(key);
+	return (iterator != dataPointer->end()) ? iterator->second : std::string();
+}
+
+void LobbyDataWriter::OnWriteResponse(WriteListener* listenerPointer, const char* failureReasonName)
+{
+	// Validate.
+	if (!listenerPointer)
+	{
+		return;
+	}
+
+	// Complete the listener's write and then delete the listener, since the SDK will not call it again.
+	// Note: This must be the last thing the listener's callback does.
+	CompleteWrite(listenerPointer->GetLobbyId(), listenerPointer, failureReasonName);
+	fListenerMap.erase(listenerPointer);
+}
+
+void LobbyDataWriter::UnregisterListener(WriteListener* listenerPointer)
+{
+	auto registrarPointer = galaxy::api::ListenerRegistrar();
+	if (!listenerPointer || !registrarPointer)
+	{
+		return;
+	}
+	registrarPointer->Unregister(
+			galaxy::api::LOBBY_DATA_UPDATE_LISTENER,
+			static_cast<galaxy::api::ILobbyDataUpdateListener*>(listenerPointer));
+	registrarPointer->Unregister(
+			galaxy::api::LOBBY_MEMBER_DATA_UPDATE_LISTENER,
+			static_cast<galaxy::api::ILobbyMemberDataUpdateListener*>(listenerPointer));
+}
+
+LobbyDataWriter::WriteListener::WriteListener(LobbyDataWriter& writer, const galaxy::api::GalaxyID& lobbyId)
+:	fWriter(writer),
+	fLobbyId(lobbyId)
+{
+}
+
+LobbyDataWriter::WriteListener::~WriteListener()
+{
+}
+
+const galaxy::api::GalaxyID& LobbyDataWriter::WriteListener::GetLobbyId() const
+{
+	return fLobbyId;
+}
+
+void LobbyDataWriter::WriteListener::OnLobbyDataUpdateSuccess(const galaxy::api::GalaxyID& /*lobbyID*/)
+{
+	fWriter.OnWriteResponse(this, nullptr);
+}
+
+void LobbyDataWriter::WriteListener::OnLobbyDataUpdateFailure(
+	const galaxy::api::GalaxyID& /*lobbyID*/, galaxy::api::ILobbyDataUpdateListener::FailureReason failureReason)
+{
+	const char* failureReasonName = "undefined";
+	switch (failureReason)
+	{
+		case galaxy::api::ILobbyDataUpdateListener::FAILURE_REASON_LOBBY_DOES_NOT_EXIST:
+			failureReasonName = "lobbyDoesNotExist";
+			break;
+		case galaxy::api::ILobbyDataUpdateListener::FAILURE_REASON_CONNECTION_FAILURE:
+			failureReasonName = "connectionFailure";
+			break;
+		default:
+			break;
+	}
+	fWriter.OnWriteResponse(this, failureReasonName);
+}
+
+void LobbyDataWriter::WriteListener::OnLobbyMemberDataUpdateSuccess(
+	const galaxy::api::GalaxyID& /*lobbyID*/, const galaxy::api::GalaxyID& /*memberID*/)
+{
+	fWriter.OnWriteResponse(this, nullptr);
+}
+
+void LobbyDataWriter::WriteListener::OnLobbyMemberDataUpdateFailure(
+	const galaxy::api::GalaxyID& /*lobbyID*/, const galaxy::api::GalaxyID& /*memberID*/,
+	galaxy::api::ILobbyMemberDataUpdateListener::FailureReason failureReason)
+{
+	const char* failureReasonName = "undefined";
+	switch (failureReason)
+	{
+		case galaxy::api::ILobbyMemberDataUpdateListener::FAILURE_REASON_LOBBY_DOES_NOT_EXIST:
+			failureReasonName = "lobbyDoesNotExist";
+			break;
+		case galaxy::api::ILobbyMemberDataUpdateListener::FAILURE_REASON_CONNECTION_FAILURE:
+			failureReasonName = "connectionFailure";
+			break;
+		default:
+			break;
+	}
+	fWriter.OnWriteResponse(this, failureReasonName);
+}
@@ -0,0 +1,223 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyDataWriter.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Buffers writes to lobby data and to the user's own lobby member data, and flushes them to GOG lazily.
+
+  Repeated writes to the same key collapse into one, and writes matching the lobby's current value, according
+  to the context's LobbyDataMirror, are dropped. A lobby's buffered writes are flushed once they have settled
+  (debounce) with at most one SetLobbyData() or SetLobbyMemberData() call in-flight per lobby at a time.
+  Values are buffered decoded and only encoded via the context's PayloadCodec as they are sent.
+
+  Exactly one "lobbyDataWrite" event is dispatched to Lua per lobby once a flush has written all buffered keys.
+
+  Note: The SDK has no global versions of the data update listeners. This object passes a new WriteListener
+        as the specific listener of every write it makes instead, and therefore only receives responses to its
+        own writes. This also lets it ignore a late response to a write which has already timed out.
+        A timed out write's listener is unregistered from the SDK and deleted, as are all pending listeners
+        when the writer is destroyed, so that the SDK never calls back into a deleted listener.
+ */
+class LobbyDataWriter
+:	public galaxy::api::GlobalLobbyLeftListener
+{
+	public:
+		/** Number of milliseconds a lobby's buffered writes have to remain unchanged before they are flushed. */
+		static const int kDebounceInMilliseconds;
+
+		/** Longest time in milliseconds a write may be delayed by continuous updates before being flushed. */
+		static const int kMaxDelayInMilliseconds;
+
+		/** Number of seconds to wait for a write's response before moving on to the next buffered write. */
+		static const int kRequestTimeoutInSeconds;
+
+		/**
+		  Creates a new writer.
+		  @param context The runtime context that will dispatch this writer's events to Lua.
+		 */
+		LobbyDataWriter(RuntimeContext& context);
+
+		virtual ~LobbyDataWriter();
+
+		/**
+		  Buffers a write of the given lobby data key.
+		  @param lobbyId The lobby to write to. Only the lobby's owner may write its lobby data.
+		  @param key The data key. Cannot be null or empty.
+		  @param value The value to assign. Set to null or an empty string to delete the key.
+		  @param isMemberData Set true to write to the user's own member data instead of the lobby's data.
+		  @return Returns true if the write was accepted or dropped for not changing anything.
+		          Returns false if given invalid arguments.
+		 */
+		bool Set(const galaxy::api::GalaxyID& lobbyId, const char* key, const char* value, bool isMemberData);
+
+		/**
+		  Sends the next buffered write of each lobby whose writes have settled and have nothing in-flight.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyDataWriter(const LobbyDataWriter&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyDataWriter&) = delete;
+
+		/** Receives the response to one SetLobbyData() or SetLobbyMemberData() call and passes it to the writer. */
+		class WriteListener
+		:	public galaxy::api::ILobbyDataUpdateListener,
+			public galaxy::api::ILobbyMemberDataUpdateListener
+		{
+			public:
+				/**
+				  Creates a new listener for one write.
+				  @param writer The writer to pass the write's response to.
+				  @param lobbyId The lobby being written to.
+				 */
+				WriteListener(LobbyDataWriter& writer, const galaxy::api::GalaxyID& lobbyId);
+
+				virtual ~WriteListener();
+
+				/** Gets the ID of the lobby being written to. */
+				const galaxy::api::GalaxyID& GetLobbyId() const;
+
+				virtual void OnLobbyDataUpdateSuccess(const galaxy::api::GalaxyID& lobbyID);
+				virtual void OnLobbyDataUpdateFailure(
+						const galaxy::api::GalaxyID& lobbyID,
+						galaxy::api::ILobbyDataUpdateListener::FailureReason failureReason);
+				virtual void OnLobbyMemberDataUpdateSuccess(
+						const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID);
+				virtual void OnLobbyMemberDataUpdateFailure(
+						const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+						galaxy::api::ILobbyMemberDataUpdateListener::FailureReason failureReason);
+
+			private:
+				/** Copy constructor deleted to prevent it from being called. */
+				WriteListener(const WriteListener&) = delete;
+
+				/** Method deleted to prevent the copy operator from being used. */
+				void operator=(const WriteListener&) = delete;
+
+				/** The writer to pass the response to. */
+				LobbyDataWriter& fWriter;
+
+				/** The lobby being written to. */
+				galaxy::api::GalaxyID fLobbyId;
+		};
+
+		struct LobbyBuffer
+		{
+			LobbyBuffer();
+
+			/** Buffered lobby data writes. An empty value deletes the key. */
+			std::map<std::string, std::string> LobbyWrites;
+
+			/** Buffered writes to the user's own member data. An empty value deletes the key. */
+			std::map<std::string, std::string> MemberWrites;
+
+			/** Set true while a write for this lobby is awaiting a response. */
+			bool IsWriteInFlight;
+
+			/** Set true if the in-flight write is to member data. */
+			bool IsInFlightMemberWrite;
+
+			/** The listener passed to the in-flight write. Only its response can complete the write. */
+			const WriteListener* InFlightListenerPointer;
+
+			/** Key written by the in-flight write. */
+			std::string InFlightKey;
+
+			/** Value written by the in-flight write. */
+			std::string InFlightValue;
+
+			/** Time the in-flight write was sent. */
+			std::chrono::steady_clock::time_point InFlightTime;
+
+			/** Set true between the first write of a flush and the moment all buffered writes have been sent. */
+			bool IsFlushing;
+
+			/** Number of writes sent by the current flush. */
+			int FlushWriteCount;
+
+			/** Number of writes of the current flush which failed. */
+			int FlushFailureCount;
+
+			/** Name of the current flush's first failure reason. Empty if no writes have failed. */
+			std::string FlushFailureReasonName;
+
+			/** Set true if writes were buffered since the last flush started sending. */
+			bool HasPendingChanges;
+
+			/** Time the first write was buffered after the last flush. */
+			std::chrono::steady_clock::time_point FirstChangeTime;
+
+			/** Time the last write was buffered. */
+			std::chrono::steady_clock::time_point LastChangeTime;
+		};
+
+		/**
+		  Ends the given lobby's in-flight write, if it was sent with the given listener.
+		  @param lobbyId The lobby the write response was received for.
+		  @param listenerPointer The listener the write was sent with.
+		  @param failureReasonName Set to null on success or to a failure description for errors.
+		 */
+		void CompleteWrite(
+				const galaxy::api::GalaxyID& lobbyId, const WriteListener* listenerPointer, const char* failureReasonName);
+
+		/**
+		  Called by a WriteListener once its write's response has been received.
+		  Completes the write, unless it has already timed out, and then deletes the listener.
+		  @param listenerPointer The listener which received the response.
+		  @param failureReasonName Set to null on success or to a failure description for errors.
+		 */
+		void OnWriteResponse(WriteListener* listenerPointer, const char* failureReasonName);
+
+		/**
+		  Unregisters the given listener from the SDK, which then no longer calls it for its pending write.
+		  @param listenerPointer The listener to unregister.
+		 */
+		static void UnregisterListener(WriteListener* listenerPointer);
+
+		/**
+		  Fetches the lobby's current value of the given key according to the context's LobbyDataMirror,
+		  or the value being written if the key has a write in-flight.
+		  @param lobbyId The lobby to read from.
+		  @param buffer The lobby's write buffer.
+		  @param key The data key to read.
+		  @param isMemberData Set true to read the user's own member data.
+		  @return Returns the current value. Returns an empty string if the key is not set.
+		 */
+		std::string GetCurrentValue(
+				const galaxy::api::GalaxyID& lobbyId, const LobbyBuffer& buffer,
+				const std::string& key, bool isMemberData) const;
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Write buffers keyed by lobby GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, LobbyBuffer> fBufferMap;
+
+		/** Listeners of all writes awaiting a response, keyed by their own address. */
+		std::unordered_map<const WriteListener*, std::unique_ptr<WriteListener>> fListenerMap;
+};
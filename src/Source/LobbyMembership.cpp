@@ -0,0 +1,131 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyMembership.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyMembership.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include <memory>
+
+
+LobbyMembership::LobbyMembership(RuntimeContext& context)
+:	fContext(context)
+{
+}
+
+LobbyMembership::~LobbyMembership()
+{
+}
+
+bool LobbyMembership::Create(
+	galaxy::api::LobbyType lobbyType, uint32_t maxMemberCount, bool isJoinable,
+	galaxy::api::LobbyTopologyType topologyType)
+{
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return false;
+	}
+	matchmakingPointer->CreateLobby(lobbyType, maxMemberCount, isJoinable, topologyType);
+	return true;
+}
+
+bool LobbyMembership::Join(const galaxy::api::GalaxyID& lobbyId)
+{
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!lobbyId.IsValid() || !matchmakingPointer)
+	{
+		return false;
+	}
+	matchmakingPointer->JoinLobby(lobbyId);
+	return true;
+}
+
+bool LobbyMembership::Leave(const galaxy::api::GalaxyID& lobbyId)
+{
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!IsInLobby(lobbyId) || !matchmakingPointer)
+	{
+		return false;
+	}
+	matchmakingPointer->LeaveLobby(lobbyId);
+	return true;
+}
+
+bool LobbyMembership::IsInLobby(const galaxy::api::GalaxyID& lobbyId) const
+{
+	return (fLobbyIds.find(lobbyId.ToUint64()) != fLobbyIds.end());
+}
+
+const std::unordered_set<uint64_t>& LobbyMembership::GetLobbyIds() const
+{
+	return fLobbyIds;
+}
+
+void LobbyMembership::OnLobbyCreated(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyCreateResult result)
+{
+	const char* failureReasonName = nullptr;
+	if (result != galaxy::api::LOBBY_CREATE_RESULT_SUCCESS)
+	{
+		bool isConnectionFailure = (galaxy::api::LOBBY_CREATE_RESULT_CONNECTION_FAILURE == result);
+		failureReasonName = isConnectionFailure ? "connectionFailure" : "undefined";
+	}
+	auto taskPointer = std::make_shared<DispatchLobbyEventTask>();
+	taskPointer->AcquireEventDataFrom("created", lobbyID, failureReasonName, nullptr);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void LobbyMembership::OnLobbyEntered(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyEnterResult result)
+{
+	const char* failureReasonName = nullptr;
+	switch (result)
+	{
+		case galaxy::api::LOBBY_ENTER_RESULT_SUCCESS:
+			fLobbyIds.insert(lobbyID.ToUint64());
+			break;
+		case galaxy::api::LOBBY_ENTER_RESULT_LOBBY_DOES_NOT_EXIST:
+			failureReasonName = "lobbyDoesNotExist";
+			break;
+		case galaxy::api::LOBBY_ENTER_RESULT_LOBBY_IS_FULL:
+			failureReasonName = "lobbyIsFull";
+			break;
+		case galaxy::api::LOBBY_ENTER_RESULT_CONNECTION_FAILURE:
+			failureReasonName = "connectionFailure";
+			break;
+		default:
+			failureReasonName = "undefined";
+			break;
+	}
+	auto taskPointer = std::make_shared<DispatchLobbyEventTask>();
+	taskPointer->AcquireEventDataFrom("entered", lobbyID, failureReasonName, nullptr);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void LobbyMembership::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason)
+{
+	fLobbyIds.erase(lobbyID.ToUint64());
+
+	const char* leaveReasonName = "undefined";
+	switch (leaveReason)
+	{
+		case galaxy::api::ILobbyLeftListener::LOBBY_LEAVE_REASON_USER_LEFT:
+			leaveReasonName = "userLeft";
+			break;
+		case galaxy::api::ILobbyLeftListener::LOBBY_LEAVE_REASON_LOBBY_CLOSED:
+			leaveReasonName = "lobbyClosed";
+			break;
+		case galaxy::api::ILobbyLeftListener::LOBBY_LEAVE_REASON_CONNECTION_LOST:
+			leaveReasonName = "connectionLost";
+			break;
+		default:
+			break;
+	}
+	auto taskPointer = std::make_shared<DispatchLobbyEventTask>();
+	taskPointer->AcquireEventDataFrom("left", lobbyID, nullptr, leaveReasonName);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
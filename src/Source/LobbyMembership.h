@@ -0,0 +1,92 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyMembership.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_set>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Creates, joins and leaves lobbies on behalf of Lua and tracks which lobbies the user is currently in.
+
+  Dispatches a "lobby" event to Lua with a "phase" of "created", "entered" or "left" for every
+  lobby membership change reported by GOG.
+ */
+class LobbyMembership
+:	public galaxy::api::GlobalLobbyCreatedListener,
+	public galaxy::api::GlobalLobbyEnteredListener,
+	public galaxy::api::GlobalLobbyLeftListener
+{
+	public:
+		/**
+		  Creates a new lobby membership tracker.
+		  @param context The runtime context that will dispatch this object's events to Lua.
+		 */
+		LobbyMembership(RuntimeContext& context);
+
+		virtual ~LobbyMembership();
+
+		/**
+		  Creates a new lobby which the user will automatically enter on success.
+		  @param lobbyType Who the lobby is visible to.
+		  @param maxMemberCount Maximum number of members allowed in the lobby.
+		  @param isJoinable Set true to allow other users to join the lobby.
+		  @param topologyType How lobby members are connected to each other.
+		  @return Returns true if the request was sent. Returns false if the GOG SDK is not available.
+		 */
+		bool Create(
+				galaxy::api::LobbyType lobbyType, uint32_t maxMemberCount, bool isJoinable,
+				galaxy::api::LobbyTopologyType topologyType);
+
+		/**
+		  Joins the given lobby.
+		  @param lobbyId The lobby to join.
+		  @return Returns true if the request was sent. Returns false if given an invalid ID or the SDK is not available.
+		 */
+		bool Join(const galaxy::api::GalaxyID& lobbyId);
+
+		/**
+		  Leaves the given lobby.
+		  @param lobbyId The lobby to leave.
+		  @return Returns true if the request was sent. Returns false if not in the given lobby.
+		 */
+		bool Leave(const galaxy::api::GalaxyID& lobbyId);
+
+		/**
+		  Determines if the user is currently in the given lobby.
+		  @param lobbyId The lobby to check.
+		  @return Returns true if the user has entered the given lobby and has not left it yet.
+		 */
+		bool IsInLobby(const galaxy::api::GalaxyID& lobbyId) const;
+
+		/** Gets the IDs of all lobbies the user is currently in, as GalaxyID::ToUint64() values. */
+		const std::unordered_set<uint64_t>& GetLobbyIds() const;
+
+		virtual void OnLobbyCreated(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyCreateResult result);
+		virtual void OnLobbyEntered(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyEnterResult result);
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyMembership(const LobbyMembership&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyMembership&) = delete;
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** IDs of the lobbies the user is currently in, as GalaxyID::ToUint64() values. */
+		std::unordered_set<uint64_t> fLobbyIds;
+};
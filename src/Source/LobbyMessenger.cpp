@@ -0,0 +1,476 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyMessenger.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyMessenger.h"
+#include "DispatchEventTask.h"
+#include "HostElection.h"
+#include "LobbyMembership.h"
+#include "LuaBuffer.h"
+#include "PayloadCodec.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <memory>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+const size_t LobbyMessenger::kMaxMessageByteCount = 4095;
+const size_t LobbyMessenger::kMinMessageByteCount = 256;
+const int LobbyMessenger::kReassemblyTimeoutInSeconds = 10;
+
+/** Size of a fragment's header: frame type, then sequence, index and count as little endian 16-bit integers. */
+static const size_t kFragmentHeaderByteCount = 7;
+
+/** Largest number of fragments a message can be split into. */
+static const size_t kMaxFragmentCount = 0xFFFF;
+
+LobbyMessenger::Batch::Batch()
+:	IsUsingBuffers(false)
+{
+}
+
+LobbyMessenger::Statistics::Statistics()
+:	SentCount(0),
+	FragmentedCount(0),
+	FragmentSentCount(0),
+	RejectedCount(0),
+	ReceivedCount(0),
+	ReassembledCount(0),
+	ReassemblyDropCount(0),
+	DecodeDropCount(0)
+{
+}
+
+LobbyMessenger::LobbyMessenger(RuntimeContext& context)
+:	fContext(context),
+	fBatchPointer(std::make_shared<Batch>()),
+	fNextFragmentSequence(0),
+	fMessageByteCount(kMaxMessageByteCount),
+	fIsUsingBuffers(false)
+{
+}
+
+LobbyMessenger::~LobbyMessenger()
+{
+}
+
+bool LobbyMessenger::Send(const galaxy::api::GalaxyID& lobbyId, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if (!lobbyId.IsValid() || !bytesPointer || (byteCount > UINT32_MAX))
+	{
+		return false;
+	}
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return false;
+	}
+
+	// Send the message as is if framing is disabled.
+	auto codecPointer = fContext.GetPayloadCodec();
+	if (!codecPointer || !codecPointer->IsMessageFramingEnabled())
+	{
+		bool wasSent = matchmakingPointer->SendLobbyMessage(lobbyId, bytesPointer, (uint32_t)byteCount);
+		if (wasSent)
+		{
+			fStatistics.SentCount++;
+		}
+		return wasSent;
+	}
+
+	// Frame the message and send it.
+	codecPointer->EncodeFrame(bytesPointer, byteCount, fSendFrame);
+	bool isFragmented = false;
+	if (!SendFrame(matchmakingPointer, lobbyId, isFragmented))
+	{
+		return false;
+	}
+	fStatistics.SentCount++;
+	if (isFragmented)
+	{
+		fStatistics.FragmentedCount++;
+	}
+	return true;
+}
+
+bool LobbyMessenger::SendControl(
+	const galaxy::api::GalaxyID& lobbyId, uint8_t controlType, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if (!lobbyId.IsValid() || (!bytesPointer && (byteCount > 0)) || (byteCount > PayloadCodec::kMaxDecodedByteCount))
+	{
+		return false;
+	}
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return false;
+	}
+
+	// Control messages can only be told apart from Lua's messages when framing is enabled.
+	auto codecPointer = fContext.GetPayloadCodec();
+	if (!codecPointer || !codecPointer->IsMessageFramingEnabled())
+	{
+		return false;
+	}
+
+	// Frame the message and send it.
+	fSendFrame.clear();
+	fSendFrame.push_back((char)PayloadCodec::kControlFrameType);
+	fSendFrame.push_back((char)controlType);
+	if (byteCount > 0)
+	{
+		fSendFrame.insert(fSendFrame.end(), bytesPointer, bytesPointer + byteCount);
+	}
+	bool isFragmented = false;
+	return SendFrame(matchmakingPointer, lobbyId, isFragmented);
+}
+
+bool LobbyMessenger::SendFrame(
+	galaxy::api::IMatchmaking* matchmakingPointer, const galaxy::api::GalaxyID& lobbyId, bool& isFragmented)
+{
+	// Send the frame in one piece if it fits.
+	// If the SDK rejects it while we're in the lobby, it may be too big, so retry with a lower limit.
+	isFragmented = false;
+	if (fSendFrame.size() <= fMessageByteCount)
+	{
+		if (matchmakingPointer->SendLobbyMessage(lobbyId, fSendFrame.data(), (uint32_t)fSendFrame.size()))
+		{
+			return true;
+		}
+		if (!LowerMessageByteCountBelow(lobbyId, fSendFrame.size()))
+		{
+			return false;
+		}
+		return SendFrame(matchmakingPointer, lobbyId, isFragmented);
+	}
+
+	// Otherwise split the frame into fragments.
+	isFragmented = true;
+	auto chunkByteCount = fMessageByteCount - kFragmentHeaderByteCount;
+	auto fragmentCount = (fSendFrame.size() + chunkByteCount - 1) / chunkByteCount;
+	if (fragmentCount > kMaxFragmentCount)
+	{
+		return false;
+	}
+	auto sequence = fNextFragmentSequence++;
+	for (size_t fragmentIndex = 0; fragmentIndex < fragmentCount; fragmentIndex++)
+	{
+		auto chunkOffset = fragmentIndex * chunkByteCount;
+		auto chunkEndOffset = (std::min)(chunkOffset + chunkByteCount, fSendFrame.size());
+		fSendFragment.clear();
+		fSendFragment.push_back((char)PayloadCodec::kFragmentFrameType);
+		fSendFragment.push_back((char)(sequence & 0xFF));
+		fSendFragment.push_back((char)(sequence >> 8));
+		fSendFragment.push_back((char)(fragmentIndex & 0xFF));
+		fSendFragment.push_back((char)(fragmentIndex >> 8));
+		fSendFragment.push_back((char)(fragmentCount & 0xFF));
+		fSendFragment.push_back((char)(fragmentCount >> 8));
+		fSendFragment.insert(
+				fSendFragment.end(), fSendFrame.begin() + chunkOffset, fSendFrame.begin() + chunkEndOffset);
+		bool wasSent = matchmakingPointer->SendLobbyMessage(
+				lobbyId, fSendFragment.data(), (uint32_t)fSendFragment.size());
+		if (!wasSent)
+		{
+			// Retry with smaller fragments if the first fragment may have been rejected for its size.
+			// Note: Otherwise receivers drop the fragments sent so far once they time out.
+			if ((0 == fragmentIndex) && LowerMessageByteCountBelow(lobbyId, fSendFragment.size()))
+			{
+				return SendFrame(matchmakingPointer, lobbyId, isFragmented);
+			}
+			return false;
+		}
+		fStatistics.FragmentSentCount++;
+	}
+	return true;
+}
+
+bool LobbyMessenger::LowerMessageByteCountBelow(const galaxy::api::GalaxyID& lobbyId, size_t rejectedByteCount)
+{
+	// A message sent to a lobby we're not in is rejected regardless of its size.
+	if ((rejectedByteCount <= kMinMessageByteCount) || !fContext.GetLobbyMembership()->IsInLobby(lobbyId))
+	{
+		return false;
+	}
+	fMessageByteCount = (std::max)(kMinMessageByteCount, (std::min)(fMessageByteCount, rejectedByteCount) / 2);
+	fStatistics.RejectedCount++;
+	return true;
+}
+
+bool LobbyMessenger::IsUsingBuffers() const
+{
+	return fIsUsingBuffers;
+}
+
+void LobbyMessenger::SetUsingBuffers(bool value)
+{
+	fIsUsingBuffers = value;
+}
+
+const LobbyMessenger::Statistics& LobbyMessenger::GetStatistics() const
+{
+	return fStatistics;
+}
+
+void LobbyMessenger::Process()
+{
+	// Buffers provided by the last dispatched batch are only valid until now.
+	if (fBufferPoolPointer)
+	{
+		fBufferPoolPointer->InvalidateAll();
+	}
+
+	// Drop messages whose remaining fragments have not arrived in time, such as when the sender has left.
+	auto currentTime = std::chrono::steady_clock::now();
+	for (auto iterator = fReassemblyMap.begin(); iterator != fReassemblyMap.end();)
+	{
+		if ((currentTime - iterator->second.StartTime) >= std::chrono::seconds(kReassemblyTimeoutInSeconds))
+		{
+			fStatistics.ReassemblyDropCount++;
+			iterator = fReassemblyMap.erase(iterator);
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+
+	// Do not continue if no messages were received this frame.
+	if (fBatchPointer->Messages.empty())
+	{
+		return;
+	}
+
+	// Hand the batch over to a "lobbyMessages" event.
+	fBatchPointer->IsUsingBuffers = fIsUsingBuffers;
+	fStatistics.ReceivedCount += fBatchPointer->Messages.size();
+	auto taskPointer = std::make_shared<DispatchLobbyMessagesEventTask>();
+	taskPointer->AcquireEventDataFrom(fBatchPointer);
+	fContext.QueueDispatchEventTask(taskPointer);
+
+	// Collect the next frame's messages into the previously dispatched batch, keeping its capacity.
+	// Note: The spare batch is only still referenced if its event has not been dispatched yet.
+	fBatchPointer.swap(fSpareBatchPointer);
+	if (fBatchPointer && fBatchPointer.unique())
+	{
+		fBatchPointer->Messages.clear();
+		fBatchPointer->Bytes.clear();
+	}
+	else
+	{
+		fBatchPointer = std::make_shared<Batch>();
+	}
+}
+
+bool LobbyMessenger::PushMessageTo(lua_State* luaStatePointer, const Batch& batch, size_t messageIndex)
+{
+	// Validate.
+	if (!luaStatePointer || (messageIndex >= batch.Messages.size()))
+	{
+		return false;
+	}
+
+	// Push the message as a string, unless buffers were requested.
+	auto& message = batch.Messages[messageIndex];
+	auto bytesPointer = batch.Bytes.data() + message.ByteOffset;
+	if (!batch.IsUsingBuffers)
+	{
+		lua_pushlstring(luaStatePointer, bytesPointer, message.ByteCount);
+		return true;
+	}
+
+	// Push the message as a pooled buffer referencing the batch's bytes.
+	auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
+	auto messengerPointer = contextPointer ? contextPointer->GetLobbyMessenger() : nullptr;
+	if (!messengerPointer)
+	{
+		return false;
+	}
+	if (!messengerPointer->fBufferPoolPointer)
+	{
+		messengerPointer->fBufferPoolPointer.reset(new LuaBufferPool(contextPointer->GetMainLuaState()));
+	}
+	return messengerPointer->fBufferPoolPointer->PushTo(luaStatePointer, messageIndex, bytesPointer, message.ByteCount);
+}
+
+void LobbyMessenger::OnLobbyMessageReceived(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& senderID,
+	uint32_t messageID, uint32_t messageLength)
+{
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if (!matchmakingPointer)
+	{
+		return;
+	}
+
+	// Framed messages are copied to a scratch buffer and decoded from there into the batch.
+	// Otherwise, the batch is grown to fit the message and the SDK copies it straight into the batch.
+	// Note: At least 1 byte is reserved so that the SDK is never given a pointer past the end of the buffer.
+	auto codecPointer = fContext.GetPayloadCodec();
+	bool isFramed = codecPointer && codecPointer->IsMessageFramingEnabled();
+	auto& bytes = fBatchPointer->Bytes;
+	auto byteOffset = bytes.size();
+	auto& targetBytes = isFramed ? fReceiveFrame : bytes;
+	auto targetOffset = isFramed ? 0 : byteOffset;
+	targetBytes.resize(targetOffset + (messageLength > 0 ? messageLength : 1));
+	galaxy::api::GalaxyID messageSenderId;
+	auto readByteCount = matchmakingPointer->GetLobbyMessage(
+			lobbyID, messageID, messageSenderId, targetBytes.data() + targetOffset, messageLength);
+	if (readByteCount > messageLength)
+	{
+		readByteCount = messageLength;
+	}
+	targetBytes.resize(targetOffset + readByteCount);
+	if (!messageSenderId.IsValid())
+	{
+		messageSenderId = senderID;
+	}
+
+	// Decode the frame, reassembling fragmented frames first.
+	if (isFramed)
+	{
+		bool wasDecoded = false;
+		if (!fReceiveFrame.empty() && ((uint8_t)fReceiveFrame[0] == PayloadCodec::kFragmentFrameType))
+		{
+			SenderKey senderKey(lobbyID.ToUint64(), messageSenderId.ToUint64());
+			auto reassemblyPointer = AddFragment(senderKey, fReceiveFrame.data(), fReceiveFrame.size());
+			if (!reassemblyPointer)
+			{
+				return;
+			}
+			auto& frame = reassemblyPointer->Frame;
+			if (!frame.empty() && ((uint8_t)frame[0] == PayloadCodec::kControlFrameType))
+			{
+				RouteControlFrame(lobbyID, messageSenderId, frame.data(), frame.size());
+				fReassemblyMap.erase(senderKey);
+				return;
+			}
+			wasDecoded = codecPointer->DecodeFrame(frame.data(), frame.size(), bytes);
+			fReassemblyMap.erase(senderKey);
+			if (wasDecoded)
+			{
+				fStatistics.ReassembledCount++;
+			}
+		}
+		else if (!fReceiveFrame.empty() && ((uint8_t)fReceiveFrame[0] == PayloadCodec::kControlFrameType))
+		{
+			RouteControlFrame(lobbyID, messageSenderId, fReceiveFrame.data(), fReceiveFrame.size());
+			return;
+		}
+		else
+		{
+			wasDecoded = codecPointer->DecodeFrame(fReceiveFrame.data(), fReceiveFrame.size(), bytes);
+		}
+		if (!wasDecoded)
+		{
+			fStatistics.DecodeDropCount++;
+			return;
+		}
+	}
+
+	// Add the message to the batch.
+	Message message;
+	message.LobbyId = lobbyID;
+	message.SenderId = messageSenderId;
+	message.ByteOffset = byteOffset;
+	message.ByteCount = bytes.size() - byteOffset;
+	fBatchPointer->Messages.push_back(message);
+}
+
+LobbyMessenger::Reassembly* LobbyMessenger::AddFragment(
+	const SenderKey& senderKey, const char* fragmentPointer, size_t fragmentByteCount)
+{
+	// Validate.
+	if (fragmentByteCount <= kFragmentHeaderByteCount)
+	{
+		return nullptr;
+	}
+
+	// Parse the fragment's header.
+	auto header = (const uint8_t*)fragmentPointer;
+	auto sequence = (uint16_t)(header[1] | (header[2] << 8));
+	auto fragmentIndex = (uint16_t)(header[3] | (header[4] << 8));
+	auto fragmentCount = (uint16_t)(header[5] | (header[6] << 8));
+	if ((fragmentCount < 2) || (fragmentIndex >= fragmentCount))
+	{
+		return nullptr;
+	}
+
+	// Start a new reassembly on a message's first fragment, replacing any message that was left incomplete.
+	auto iterator = fReassemblyMap.find(senderKey);
+	if (0 == fragmentIndex)
+	{
+		if (iterator == fReassemblyMap.end())
+		{
+			iterator = fReassemblyMap.insert(std::make_pair(senderKey, Reassembly())).first;
+		}
+		else
+		{
+			fStatistics.ReassemblyDropCount++;
+		}
+		auto& reassembly = iterator->second;
+		reassembly.Sequence = sequence;
+		reassembly.FragmentCount = fragmentCount;
+		reassembly.NextFragmentIndex = 0;
+		reassembly.Frame.clear();
+		reassembly.StartTime = std::chrono::steady_clock::now();
+	}
+	else if (iterator == fReassemblyMap.end())
+	{
+		// The message's first fragment was missed.
+		return nullptr;
+	}
+
+	// Drop the sender's message if this fragment is not the one expected next.
+	auto& reassembly = iterator->second;
+	if ((reassembly.Sequence != sequence) || (reassembly.FragmentCount != fragmentCount) ||
+	    (reassembly.NextFragmentIndex != fragmentIndex))
+	{
+		fStatistics.ReassemblyDropCount++;
+		fReassemblyMap.erase(iterator);
+		return nullptr;
+	}
+
+	// Append the fragment, refusing to grow beyond what the codec will accept.
+	auto chunkByteCount = fragmentByteCount - kFragmentHeaderByteCount;
+	if ((reassembly.Frame.size() + chunkByteCount) > (PayloadCodec::kMaxDecodedByteCount + kMaxMessageByteCount))
+	{
+		fStatistics.ReassemblyDropCount++;
+		fReassemblyMap.erase(iterator);
+		return nullptr;
+	}
+	reassembly.Frame.insert(
+			reassembly.Frame.end(), fragmentPointer + kFragmentHeaderByteCount, fragmentPointer + fragmentByteCount);
+	reassembly.NextFragmentIndex++;
+	return (reassembly.NextFragmentIndex == reassembly.FragmentCount) ? &reassembly : nullptr;
+}
+
+void LobbyMessenger::RouteControlFrame(
+	const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& senderId,
+	const char* framePointer, size_t frameByteCount)
+{
+	// Validate.
+	if (frameByteCount < 2)
+	{
+		fStatistics.DecodeDropCount++;
+		return;
+	}
+
+	// Hand the message's bytes, following the frame type and control type, to its subsystem.
+	// Note: Control types which are unknown to this version of the plugin are ignored.
+	auto controlType = (uint8_t)framePointer[1];
+	if (HostElection::kPingReportControlType == controlType)
+	{
+		fContext.GetHostElection()->OnPingReportReceived(lobbyId, senderId, framePointer + 2, frameByteCount - 2);
+	}
+}
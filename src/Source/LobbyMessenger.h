@@ -0,0 +1,296 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyMessenger.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class LuaBufferPool;
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Sends lobby messages on behalf of Lua and delivers received lobby messages to Lua in per-frame batches.
+
+  Received messages are copied by IMatchmaking::GetLobbyMessage() straight into the end of one growable byte
+  buffer shared by all messages received during a frame, which retains its capacity between frames. Process()
+  then dispatches one "lobbyMessages" event providing all of the frame's messages, either as Lua strings or,
+  for binary protocols, as pooled "plugin.gog.Buffer" userdata which read the batch's bytes in place.
+
+  When the context's PayloadCodec has message framing enabled, sent messages are framed (and compressed when
+  that helps) and received frames are decoded into the batch instead. Frames which cannot be decoded are dropped.
+  Frames bigger than the current message size limit, initially kMaxMessageByteCount, are split into fragments
+  which are reassembled per sender, so that Lua receives one message no matter how many lobby messages it took
+  to send it. If the SDK rejects a message while the user is in its lobby, the limit is halved, down to
+  kMinMessageByteCount, and the frame is sent again in smaller fragments.
+
+  Framing also allows the plugin to exchange its own control messages, which are routed to the subsystem
+  owning their control type and are never provided to Lua.
+ */
+class LobbyMessenger : public galaxy::api::GlobalLobbyMessageListener
+{
+	public:
+		/**
+		  Initial limit of the lobby messages sent to the SDK. Bigger framed messages are fragmented.
+
+		  IMatchmaking::SendLobbyMessage() documents no maximum size, so this is set to 4095 bytes, the limit
+		  IMatchmaking::SetLobbyData() documents for a lobby data value, which is the only size limit the SDK
+		  documents for data shared via a lobby. The limit is lowered if the SDK rejects messages this big.
+		 */
+		static const size_t kMaxMessageByteCount;
+
+		/**
+		  Lowest the message size limit is halved down to when the SDK rejects messages.
+		  This is not an SDK limit, but bounds the number of retries and the fragments' header overhead.
+		 */
+		static const size_t kMinMessageByteCount;
+
+		/** Number of seconds a sender has to deliver all of a message's fragments before they are dropped. */
+		static const int kReassemblyTimeoutInSeconds;
+
+		/** One received message within a batch. */
+		struct Message
+		{
+			galaxy::api::GalaxyID LobbyId;
+			galaxy::api::GalaxyID SenderId;
+
+			/** Offset of the message's first byte within the batch's "Bytes". */
+			size_t ByteOffset;
+
+			/** Number of bytes in the message. */
+			size_t ByteCount;
+		};
+
+		/** All messages received during one frame. */
+		struct Batch
+		{
+			Batch();
+
+			std::vector<Message> Messages;
+
+			/** The bytes of all messages, back to back. */
+			std::vector<char> Bytes;
+
+			/** Set true to provide messages to Lua as buffers instead of strings. */
+			bool IsUsingBuffers;
+		};
+
+		/** Running totals of the messenger's traffic. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of messages sent by Send(). */
+			uint64_t SentCount;
+
+			/** Number of sent messages which had to be fragmented. */
+			uint64_t FragmentedCount;
+
+			/** Number of fragments sent. */
+			uint64_t FragmentSentCount;
+
+			/** Number of messages rejected by the SDK which caused the message size limit to be lowered. */
+			uint64_t RejectedCount;
+
+			/** Number of messages dispatched to Lua. */
+			uint64_t ReceivedCount;
+
+			/** Number of received messages which were reassembled from fragments. */
+			uint64_t ReassembledCount;
+
+			/** Number of partially received messages dropped due to timeouts or missing fragments. */
+			uint64_t ReassemblyDropCount;
+
+			/** Number of received frames dropped because they could not be decoded. */
+			uint64_t DecodeDropCount;
+		};
+
+		/**
+		  Creates a new messenger.
+		  @param context The runtime context that will dispatch this messenger's events to Lua.
+		 */
+		LobbyMessenger(RuntimeContext& context);
+
+		virtual ~LobbyMessenger();
+
+		/**
+		  Sends a message to all members of the given lobby.
+		  @param lobbyId The lobby to send to. The user must be a member of it.
+		  @param bytesPointer The message's bytes.
+		  @param byteCount Number of bytes in the message.
+		  @return Returns true if the message was sent. Returns false if given invalid arguments or if rejected by GOG.
+		 */
+		bool Send(const galaxy::api::GalaxyID& lobbyId, const char* bytesPointer, size_t byteCount);
+
+		/**
+		  Sends a control message to all members of the given lobby, fragmenting it if needed.
+		  @param lobbyId The lobby to send to. The user must be a member of it.
+		  @param controlType Identifies the subsystem the message is routed to by receivers.
+		  @param bytesPointer The message's bytes. Can be null if "byteCount" is zero.
+		  @param byteCount Number of bytes in the message.
+		  @return Returns true if the message was sent.
+		          Returns false if message framing is disabled, if given invalid arguments or if rejected by GOG.
+		 */
+		bool SendControl(
+				const galaxy::api::GalaxyID& lobbyId, uint8_t controlType, const char* bytesPointer, size_t byteCount);
+
+		/**
+		  Determines if received messages are provided to Lua as "plugin.gog.Buffer" userdata.
+		  @return Returns true if messages are provided as buffers. Returns false if they are provided as strings.
+		 */
+		bool IsUsingBuffers() const;
+
+		/**
+		  Sets whether received messages are provided to Lua as "plugin.gog.Buffer" userdata or as strings.
+		  Buffers are only valid during the "lobbyMessages" event they were provided by.
+		  @param value Set true to provide messages as buffers. Set false to provide them as strings.
+		 */
+		void SetUsingBuffers(bool value);
+
+		/** Gets the messenger's running totals. */
+		const Statistics& GetStatistics() const;
+
+		/**
+		  Dispatches a "lobbyMessages" event providing the messages received since the last call, if any.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		/**
+		  Pushes the given message of a batch to Lua via the messenger of the runtime context that owns the Lua state.
+		  Intended to be used by event tasks which only have access to a Lua state.
+		  @param luaStatePointer The Lua state to push to.
+		  @param batch The batch providing the message.
+		  @param messageIndex Index of the message within the batch.
+		  @return Returns true if a string or buffer was pushed to Lua. Returns false if nothing was pushed.
+		 */
+		static bool PushMessageTo(lua_State* luaStatePointer, const Batch& batch, size_t messageIndex);
+
+		virtual void OnLobbyMessageReceived(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& senderID,
+				uint32_t messageID, uint32_t messageLength);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyMessenger(const LobbyMessenger&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyMessenger&) = delete;
+
+		/** A message being reassembled from one sender's fragments. */
+		struct Reassembly
+		{
+			/** Sequence number shared by all of the message's fragments. */
+			uint16_t Sequence;
+
+			/** Total number of fragments making up the message. */
+			uint16_t FragmentCount;
+
+			/** Index of the next fragment expected. Fragments from a sender are received in order. */
+			uint16_t NextFragmentIndex;
+
+			/** The frame reassembled so far. */
+			std::vector<char> Frame;
+
+			/** Time the first fragment was received. */
+			std::chrono::steady_clock::time_point StartTime;
+		};
+
+		/** Identifies a sender by lobby and user GalaxyID::ToUint64() values. */
+		typedef std::pair<uint64_t, uint64_t> SenderKey;
+
+		/**
+		  Adds the given fragment to its sender's reassembly.
+		  @param senderKey The lobby and user the fragment was received from.
+		  @param fragmentPointer The fragment, starting with its header.
+		  @param fragmentByteCount Number of bytes in the fragment.
+		  @return Returns a pointer to the sender's reassembly if the fragment completed it, to be erased by the caller.
+		          Returns null if more fragments are needed or if the fragment was dropped.
+		 */
+		Reassembly* AddFragment(const SenderKey& senderKey, const char* fragmentPointer, size_t fragmentByteCount);
+
+		/**
+		  Sends the frame in "fSendFrame" as one lobby message, or as fragments if it is too big.
+		  Lowers the message size limit and sends the frame again if the SDK rejects its first message.
+		  @param matchmakingPointer The SDK's matchmaking interface. Cannot be null.
+		  @param lobbyId The lobby to send to.
+		  @param isFragmented Set true if the frame had to be fragmented.
+		  @return Returns true if the whole frame was sent. Returns false if rejected by GOG or if too big.
+		 */
+		bool SendFrame(
+				galaxy::api::IMatchmaking* matchmakingPointer, const galaxy::api::GalaxyID& lobbyId, bool& isFragmented);
+
+		/**
+		  Lowers the message size limit below the size of a message the SDK rejected, unless the rejection cannot
+		  be due to its size, ie: if the user is not in the lobby or if the message was already small enough.
+		  @param lobbyId The lobby the message was sent to.
+		  @param rejectedByteCount Number of bytes in the rejected message.
+		  @return Returns true if the limit was lowered and the message should be sent again.
+		          Returns false if not.
+		 */
+		bool LowerMessageByteCountBelow(const galaxy::api::GalaxyID& lobbyId, size_t rejectedByteCount);
+
+		/**
+		  Hands a received control frame over to the subsystem owning its control type.
+		  @param lobbyId The lobby the frame was received in.
+		  @param senderId The member who sent the frame.
+		  @param framePointer The frame, starting with its frame type.
+		  @param frameByteCount Number of bytes in the frame.
+		 */
+		void RouteControlFrame(
+				const galaxy::api::GalaxyID& lobbyId, const galaxy::api::GalaxyID& senderId,
+				const char* framePointer, size_t frameByteCount);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Collects the messages received during the current frame. */
+		std::shared_ptr<Batch> fBatchPointer;
+
+		/** The previously dispatched batch, recycled once its event task has released it. */
+		std::shared_ptr<Batch> fSpareBatchPointer;
+
+		/** Reusable buffer which outgoing messages are framed into. */
+		std::vector<char> fSendFrame;
+
+		/** Reusable buffer which outgoing fragments are written to. */
+		std::vector<char> fSendFragment;
+
+		/** Sequence number of the next fragmented message. */
+		uint16_t fNextFragmentSequence;
+
+		/** Largest lobby message currently sent to the SDK, between kMinMessageByteCount and kMaxMessageByteCount. */
+		size_t fMessageByteCount;
+
+		/** Messages being reassembled, one per sender. */
+		std::map<SenderKey, Reassembly> fReassemblyMap;
+
+		/** The messenger's running totals. */
+		Statistics fStatistics;
+
+		/** Reusable buffer which incoming frames are copied to before being decoded into the batch. */
+		std::vector<char> fReceiveFrame;
+
+		/** Provides the buffer userdata provided by "lobbyMessages" events. Null until buffers are first used. */
+		std::unique_ptr<LuaBufferPool> fBufferPoolPointer;
+
+		/** Set true to provide messages to Lua as buffers. */
+		bool fIsUsingBuffers;
+};
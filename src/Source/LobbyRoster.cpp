@@ -0,0 +1,227 @@
+// --------------------------------------------------------------------------------
+//
+// LobbyRoster.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LobbyRoster.h"
+#include "DispatchEventTask.h"
+#include "LuaGalaxyId.h"
+#include "PersonaNameCache.h"
+#include "RuntimeContext.h"
+#include "UserInformationScheduler.h"
+#include <algorithm>
+#include <memory>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+LobbyRoster::LobbyRoster(RuntimeContext& context)
+:	fContext(context)
+{
+}
+
+LobbyRoster::~LobbyRoster()
+{
+}
+
+const std::vector<galaxy::api::GalaxyID>* LobbyRoster::GetMembersOf(const galaxy::api::GalaxyID& lobbyId) const
+{
+	auto iterator = fRosterMap.find(lobbyId.ToUint64());
+	return (iterator != fRosterMap.end()) ? &iterator->second.MemberIds : nullptr;
+}
+
+galaxy::api::GalaxyID LobbyRoster::GetOwnerOf(const galaxy::api::GalaxyID& lobbyId) const
+{
+	auto iterator = fRosterMap.find(lobbyId.ToUint64());
+	return (iterator != fRosterMap.end()) ? iterator->second.OwnerId : galaxy::api::GalaxyID();
+}
+
+bool LobbyRoster::IsSharingLobbyWith(
+	const galaxy::api::GalaxyID& memberId, const galaxy::api::GalaxyID& excludedLobbyId) const
+{
+	for (auto&& pair : fRosterMap)
+	{
+		if (pair.first == excludedLobbyId.ToUint64())
+		{
+			continue;
+		}
+		auto& memberIds = pair.second.MemberIds;
+		if (std::find(memberIds.begin(), memberIds.end(), memberId) != memberIds.end())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool LobbyRoster::PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& lobbyId) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Fetch the requested roster.
+	auto iterator = fRosterMap.find(lobbyId.ToUint64());
+	if (iterator == fRosterMap.end())
+	{
+		return false;
+	}
+	auto& roster = iterator->second;
+
+	// Push the roster.
+	lua_createtable(luaStatePointer, 0, 2);
+	PushGalaxyIdTo(luaStatePointer, roster.OwnerId);
+	lua_setfield(luaStatePointer, -2, "ownerId");
+	lua_createtable(luaStatePointer, (int)roster.MemberIds.size(), 0);
+	for (size_t index = 0; index < roster.MemberIds.size(); index++)
+	{
+		auto& memberId = roster.MemberIds[index];
+		PushMemberEntryTo(luaStatePointer, memberId, memberId == roster.OwnerId);
+		lua_rawseti(luaStatePointer, -2, (int)index + 1);
+	}
+	lua_setfield(luaStatePointer, -2, "members");
+	return true;
+}
+
+bool LobbyRoster::PushMemberEntryTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& memberId, bool isOwner)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push the entry. The persona name is omitted until GOG has the member's information.
+	lua_createtable(luaStatePointer, 0, 3);
+	PushGalaxyIdTo(luaStatePointer, memberId);
+	lua_setfield(luaStatePointer, -2, "userId");
+	if (PersonaNameCache::PushPersonaNameTo(luaStatePointer, memberId))
+	{
+		lua_setfield(luaStatePointer, -2, "personaName");
+	}
+	lua_pushboolean(luaStatePointer, isOwner ? 1 : 0);
+	lua_setfield(luaStatePointer, -2, "isOwner");
+	return true;
+}
+
+void LobbyRoster::OnLobbyEntered(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyEnterResult result)
+{
+	// Do not continue if the lobby was not entered.
+	auto matchmakingPointer = galaxy::api::Matchmaking();
+	if ((result != galaxy::api::LOBBY_ENTER_RESULT_SUCCESS) || !matchmakingPointer)
+	{
+		return;
+	}
+
+	// Read the full roster once. It is only updated incrementally from here on.
+	auto& roster = fRosterMap[lobbyID.ToUint64()];
+	roster.OwnerId = matchmakingPointer->GetLobbyOwner(lobbyID);
+	roster.MemberIds.clear();
+	uint32_t memberCount = matchmakingPointer->GetNumLobbyMembers(lobbyID);
+	roster.MemberIds.reserve(memberCount);
+	for (uint32_t index = 0; index < memberCount; index++)
+	{
+		auto memberId = matchmakingPointer->GetLobbyMemberByIndex(lobbyID, index);
+		if (memberId.IsValid())
+		{
+			roster.MemberIds.push_back(memberId);
+			RequestInformationFor(memberId);
+		}
+	}
+}
+
+void LobbyRoster::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	fRosterMap.erase(lobbyID.ToUint64());
+}
+
+void LobbyRoster::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Ignore lobbies that we're not tracking.
+	auto iterator = fRosterMap.find(lobbyID.ToUint64());
+	if (iterator == fRosterMap.end())
+	{
+		return;
+	}
+	auto& roster = iterator->second;
+
+	// Apply the change to the roster.
+	auto memberIterator = std::find(roster.MemberIds.begin(), roster.MemberIds.end(), memberID);
+	const char* phaseName = nullptr;
+	switch (memberStateChange)
+	{
+		case galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED:
+			if (memberIterator != roster.MemberIds.end())
+			{
+				return;
+			}
+			roster.MemberIds.push_back(memberID);
+			RequestInformationFor(memberID);
+			phaseName = "entered";
+			break;
+		case galaxy::api::LOBBY_MEMBER_STATE_CHANGED_LEFT:
+			phaseName = "left";
+			break;
+		case galaxy::api::LOBBY_MEMBER_STATE_CHANGED_DISCONNECTED:
+			phaseName = "disconnected";
+			break;
+		case galaxy::api::LOBBY_MEMBER_STATE_CHANGED_KICKED:
+			phaseName = "kicked";
+			break;
+		case galaxy::api::LOBBY_MEMBER_STATE_CHANGED_BANNED:
+			phaseName = "banned";
+			break;
+		default:
+			return;
+	}
+	if (galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED != memberStateChange)
+	{
+		if (memberIterator == roster.MemberIds.end())
+		{
+			return;
+		}
+		roster.MemberIds.erase(memberIterator);
+	}
+	DispatchEventFor(phaseName, lobbyID, memberID, roster);
+}
+
+void LobbyRoster::OnLobbyOwnerChanged(const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& newOwnerID)
+{
+	auto iterator = fRosterMap.find(lobbyID.ToUint64());
+	if ((iterator == fRosterMap.end()) || (iterator->second.OwnerId == newOwnerID))
+	{
+		return;
+	}
+	iterator->second.OwnerId = newOwnerID;
+	DispatchEventFor("ownerChanged", lobbyID, newOwnerID, iterator->second);
+}
+
+void LobbyRoster::RequestInformationFor(const galaxy::api::GalaxyID& memberId)
+{
+	auto friendsPointer = galaxy::api::Friends();
+	if (friendsPointer && !friendsPointer->IsUserInformationAvailable(memberId))
+	{
+		fContext.GetUserInformationScheduler()->Request(memberId, false);
+	}
+}
+
+void LobbyRoster::DispatchEventFor(
+	const char* phaseName, const galaxy::api::GalaxyID& lobbyId,
+	const galaxy::api::GalaxyID& memberId, const Roster& roster)
+{
+	auto taskPointer = std::make_shared<DispatchLobbyMemberEventTask>();
+	taskPointer->AcquireEventDataFrom(
+			phaseName, lobbyId, memberId, roster.OwnerId, (uint32_t)roster.MemberIds.size());
+	fContext.QueueDispatchEventTask(taskPointer);
+}
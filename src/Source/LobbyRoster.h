@@ -0,0 +1,136 @@
+// ----------------------------------------------------------------------------
+//
+// LobbyRoster.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Keeps a native member list and owner of every lobby the user is in.
+
+  A lobby's roster is read from the SDK once when the lobby is entered and is then updated incrementally by
+  OnLobbyMemberStateChanged() and OnLobbyOwnerChanged(). Lua reads a whole roster with one call instead of
+  calling GetNumLobbyMembers() and GetLobbyMemberByIndex() per member.
+
+  Every change is dispatched to Lua as a "lobbyMember" event carrying the member's resolved entry. Members whose
+  user information is not available yet are requested via the context's UserInformationScheduler.
+ */
+class LobbyRoster
+:	public galaxy::api::GlobalLobbyEnteredListener,
+	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener,
+	public galaxy::api::GlobalLobbyOwnerChangeListener
+{
+	public:
+		/**
+		  Creates a new roster cache.
+		  @param context The runtime context that will dispatch this object's events to Lua.
+		 */
+		LobbyRoster(RuntimeContext& context);
+
+		virtual ~LobbyRoster();
+
+		/**
+		  Fetches the given lobby's members, in the order they entered the lobby.
+		  @param lobbyId The lobby to fetch the members of.
+		  @return Returns a pointer to the lobby's member IDs. Returns null if the user is not in the given lobby.
+		 */
+		const std::vector<galaxy::api::GalaxyID>* GetMembersOf(const galaxy::api::GalaxyID& lobbyId) const;
+
+		/**
+		  Fetches the given lobby's owner.
+		  @param lobbyId The lobby to fetch the owner of.
+		  @return Returns the owner's ID. Returns an invalid ID if the user is not in the given lobby.
+		 */
+		galaxy::api::GalaxyID GetOwnerOf(const galaxy::api::GalaxyID& lobbyId) const;
+
+		/**
+		  Determines if the given user is a member of any lobby the user is in, besides the given one.
+		  Intended for services which forget a peer's state once no lobby is shared with it anymore.
+		  @param memberId The user to look for.
+		  @param excludedLobbyId The lobby to ignore, such as the one the member or the user is leaving.
+		  @return Returns true if another lobby is shared with the given user. Returns false if not.
+		 */
+		bool IsSharingLobbyWith(const galaxy::api::GalaxyID& memberId, const galaxy::api::GalaxyID& excludedLobbyId) const;
+
+		/**
+		  Pushes the given lobby's roster to Lua as a table with an "ownerId" and a "members" array of member entries.
+		  @param luaStatePointer The Lua state to push to.
+		  @param lobbyId The lobby whose roster should be pushed.
+		  @return Returns true if a table was pushed. Returns false if the user is not in the given lobby.
+		 */
+		bool PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& lobbyId) const;
+
+		/**
+		  Pushes a member entry table providing the member's "userId", "personaName" and "isOwner" fields.
+		  Intended to be used by this class and by event tasks which only have access to a Lua state.
+		  @param luaStatePointer The Lua state to push to.
+		  @param memberId The member to push.
+		  @param isOwner Set true if the member owns the lobby.
+		  @return Returns true if a table was pushed. Returns false if given a null Lua state.
+		 */
+		static bool PushMemberEntryTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& memberId, bool isOwner);
+
+		virtual void OnLobbyEntered(const galaxy::api::GalaxyID& lobbyID, galaxy::api::LobbyEnterResult result);
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+		virtual void OnLobbyOwnerChanged(const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& newOwnerID);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LobbyRoster(const LobbyRoster&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LobbyRoster&) = delete;
+
+		struct Roster
+		{
+			/** The lobby's current owner. */
+			galaxy::api::GalaxyID OwnerId;
+
+			/** The lobby's members in the order they entered the lobby. */
+			std::vector<galaxy::api::GalaxyID> MemberIds;
+		};
+
+		/**
+		  Requests the given member's information if GOG does not have it yet, so that its persona name can be resolved.
+		  @param memberId The member to fetch information for.
+		 */
+		void RequestInformationFor(const galaxy::api::GalaxyID& memberId);
+
+		/**
+		  Queues a "lobbyMember" event to be dispatched to Lua.
+		  @param phaseName The kind of change, such as "entered" or "ownerChanged".
+		  @param lobbyId The lobby that changed.
+		  @param memberId The member that changed.
+		  @param roster The lobby's roster after the change.
+		 */
+		void DispatchEventFor(
+				const char* phaseName, const galaxy::api::GalaxyID& lobbyId,
+				const galaxy::api::GalaxyID& memberId, const Roster& roster);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Rosters of the lobbies the user is in, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, Roster> fRosterMap;
+};
@@ -0,0 +1,291 @@
+// --------------------------------------------------------------------------------
+//
+// LuaBuffer.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LuaBuffer.h"
+
+extern "C"
+{
+#	include "lua.h"
+#	include "lauxlib.h"
+}
+
+
+/** Name of the Lua metatable assigned to all buffer userdata. */
+static const char kLuaBufferMetatableName[] = "plugin.gog.Buffer";
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+/**
+  Converts the given Lua string-style range arguments to a zero based byte range.
+  Negative indexes count from the end of the buffer, like Lua's string.sub().
+  @param luaStatePointer The Lua state providing the range arguments.
+  @param byteCount Number of bytes in the buffer.
+  @param defaultEndIndex The one based end index to use if the 2nd range argument was not provided.
+  @param startOffsetPointer Set to the zero based offset of the range's first byte.
+  @return Returns the number of bytes in the range. Returns zero if the range is empty.
+ */
+static size_t GetByteRangeFrom(
+	lua_State* luaStatePointer, size_t byteCount, lua_Integer defaultEndIndex, size_t* startOffsetPointer)
+{
+	auto startIndex = luaL_optinteger(luaStatePointer, 2, 1);
+	auto endIndex = luaL_optinteger(luaStatePointer, 3, defaultEndIndex);
+	if (startIndex < 0)
+	{
+		startIndex += (lua_Integer)byteCount + 1;
+	}
+	if (endIndex < 0)
+	{
+		endIndex += (lua_Integer)byteCount + 1;
+	}
+	if (startIndex < 1)
+	{
+		startIndex = 1;
+	}
+	if (endIndex > (lua_Integer)byteCount)
+	{
+		endIndex = (lua_Integer)byteCount;
+	}
+	*startOffsetPointer = (size_t)(startIndex - 1);
+	return (startIndex <= endIndex) ? (size_t)(endIndex - startIndex + 1) : 0;
+}
+
+/** buffer:len() and #buffer */
+static int OnGetLength(lua_State* luaStatePointer)
+{
+	auto bufferPointer = (LuaBuffer*)luaL_checkudata(luaStatePointer, 1, kLuaBufferMetatableName);
+	lua_pushinteger(luaStatePointer, bufferPointer->BytesPointer ? (lua_Integer)bufferPointer->ByteCount : 0);
+	return 1;
+}
+
+/** buffer:byte([i [, j]]) */
+static int OnGetBytes(lua_State* luaStatePointer)
+{
+	auto bufferPointer = (LuaBuffer*)luaL_checkudata(luaStatePointer, 1, kLuaBufferMetatableName);
+	if (!bufferPointer->BytesPointer)
+	{
+		return 0;
+	}
+	size_t startOffset = 0;
+	auto defaultEndIndex = luaL_optinteger(luaStatePointer, 2, 1);
+	auto count = GetByteRangeFrom(luaStatePointer, bufferPointer->ByteCount, defaultEndIndex, &startOffset);
+	luaL_checkstack(luaStatePointer, (int)count, "buffer range is too large");
+	for (size_t index = 0; index < count; index++)
+	{
+		lua_pushinteger(luaStatePointer, (unsigned char)bufferPointer->BytesPointer[startOffset + index]);
+	}
+	return (int)count;
+}
+
+/** buffer:sub([i [, j]]) */
+static int OnGetSubString(lua_State* luaStatePointer)
+{
+	auto bufferPointer = (LuaBuffer*)luaL_checkudata(luaStatePointer, 1, kLuaBufferMetatableName);
+	if (!bufferPointer->BytesPointer)
+	{
+		lua_pushliteral(luaStatePointer, "");
+		return 1;
+	}
+	size_t startOffset = 0;
+	auto count = GetByteRangeFrom(luaStatePointer, bufferPointer->ByteCount, -1, &startOffset);
+	lua_pushlstring(luaStatePointer, bufferPointer->BytesPointer + startOffset, count);
+	return 1;
+}
+
+/** buffer:isValid() */
+static int OnIsValid(lua_State* luaStatePointer)
+{
+	auto bufferPointer = (LuaBuffer*)luaL_checkudata(luaStatePointer, 1, kLuaBufferMetatableName);
+	lua_pushboolean(luaStatePointer, bufferPointer->BytesPointer ? 1 : 0);
+	return 1;
+}
+
+/** tostring(buffer) */
+static int OnToString(lua_State* luaStatePointer)
+{
+	auto bufferPointer = (LuaBuffer*)luaL_checkudata(luaStatePointer, 1, kLuaBufferMetatableName);
+	auto byteCount = bufferPointer->BytesPointer ? bufferPointer->ByteCount : 0;
+	lua_pushfstring(luaStatePointer, "%s (%d bytes)", kLuaBufferMetatableName, (int)byteCount);
+	return 1;
+}
+
+//---------------------------------------------------------------------------------
+// Public Functions
+//---------------------------------------------------------------------------------
+LuaBuffer* PushNewLuaBufferTo(lua_State* luaStatePointer)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return nullptr;
+	}
+
+	// Create the buffer.
+	auto bufferPointer = (LuaBuffer*)lua_newuserdata(luaStatePointer, sizeof(LuaBuffer));
+	bufferPointer->BytesPointer = nullptr;
+	bufferPointer->ByteCount = 0;
+
+	// Assign it the buffer metatable, creating the metatable the first time.
+	if (luaL_newmetatable(luaStatePointer, kLuaBufferMetatableName))
+	{
+		const struct luaL_Reg luaFunctions[] =
+		{
+			{ "len", OnGetLength },
+			{ "byte", OnGetBytes },
+			{ "sub", OnGetSubString },
+			{ "isValid", OnIsValid },
+			{ nullptr, nullptr }
+		};
+		lua_createtable(luaStatePointer, 0, 4);
+		luaL_register(luaStatePointer, nullptr, luaFunctions);
+		lua_setfield(luaStatePointer, -2, "__index");
+		lua_pushcfunction(luaStatePointer, OnGetLength);
+		lua_setfield(luaStatePointer, -2, "__len");
+		lua_pushcfunction(luaStatePointer, OnToString);
+		lua_setfield(luaStatePointer, -2, "__tostring");
+	}
+	lua_setmetatable(luaStatePointer, -2);
+	return bufferPointer;
+}
+
+LuaBuffer* GetLuaBufferFrom(lua_State* luaStatePointer, int luaStackIndex)
+{
+	// Validate.
+	if (!luaStatePointer || (lua_type(luaStatePointer, luaStackIndex) != LUA_TUSERDATA))
+	{
+		return nullptr;
+	}
+
+	// Only return the userdata if it has the buffer metatable.
+	LuaBuffer* bufferPointer = nullptr;
+	if (lua_getmetatable(luaStatePointer, luaStackIndex))
+	{
+		luaL_getmetatable(luaStatePointer, kLuaBufferMetatableName);
+		if (lua_rawequal(luaStatePointer, -1, -2))
+		{
+			bufferPointer = (LuaBuffer*)lua_touserdata(luaStatePointer, luaStackIndex);
+		}
+		lua_pop(luaStatePointer, 2);
+	}
+	return bufferPointer;
+}
+
+const char* GetLuaBytesFrom(lua_State* luaStatePointer, int luaStackIndex, size_t* byteCountPointer)
+{
+	// Validate.
+	if (!luaStatePointer || !byteCountPointer)
+	{
+		return nullptr;
+	}
+	*byteCountPointer = 0;
+
+	// Note: lua_type() must be used instead of lua_isstring() since the latter is also true for numbers.
+	if (lua_type(luaStatePointer, luaStackIndex) == LUA_TSTRING)
+	{
+		return lua_tolstring(luaStatePointer, luaStackIndex, byteCountPointer);
+	}
+	auto bufferPointer = GetLuaBufferFrom(luaStatePointer, luaStackIndex);
+	if (!bufferPointer || !bufferPointer->BytesPointer)
+	{
+		return nullptr;
+	}
+	*byteCountPointer = bufferPointer->ByteCount;
+	return bufferPointer->BytesPointer;
+}
+
+//---------------------------------------------------------------------------------
+// LuaBufferPool Class Members
+//---------------------------------------------------------------------------------
+LuaBufferPool::LuaBufferPool(lua_State* luaStatePointer)
+:	fLuaStatePointer(luaStatePointer),
+	fLuaReferenceId(LUA_NOREF)
+{
+	if (fLuaStatePointer)
+	{
+		lua_newtable(fLuaStatePointer);
+		fLuaReferenceId = luaL_ref(fLuaStatePointer, LUA_REGISTRYINDEX);
+	}
+}
+
+LuaBufferPool::~LuaBufferPool()
+{
+	InvalidateAll();
+	if (fLuaStatePointer && (fLuaReferenceId != LUA_NOREF))
+	{
+		luaL_unref(fLuaStatePointer, LUA_REGISTRYINDEX, fLuaReferenceId);
+	}
+	fBufferPointers.clear();
+}
+
+bool LuaBufferPool::PushTo(lua_State* luaStatePointer, size_t slotIndex, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if (!luaStatePointer || !bytesPointer || (fLuaReferenceId == LUA_NOREF))
+	{
+		return false;
+	}
+
+	// Push the slot's buffer if already pushed since the last InvalidateAll() call, or create one for it.
+	LuaBuffer* bufferPointer = nullptr;
+	if (slotIndex < fBufferPointers.size())
+	{
+		bufferPointer = fBufferPointers[slotIndex];
+		lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, fLuaReferenceId);
+		lua_rawgeti(luaStatePointer, -1, (int)slotIndex + 1);
+		lua_remove(luaStatePointer, -2);
+	}
+	else
+	{
+		// Slots are filled in order, so a new slot is always appended to the table.
+		if (slotIndex != fBufferPointers.size())
+		{
+			return false;
+		}
+		lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, fLuaReferenceId);
+		bufferPointer = PushNewLuaBufferTo(luaStatePointer);
+		lua_pushvalue(luaStatePointer, -1);
+		lua_rawseti(luaStatePointer, -3, (int)slotIndex + 1);
+		lua_remove(luaStatePointer, -2);
+		fBufferPointers.push_back(bufferPointer);
+	}
+
+	// Point the buffer to the given bytes.
+	bufferPointer->BytesPointer = bytesPointer;
+	bufferPointer->ByteCount = byteCount;
+	return true;
+}
+
+void LuaBufferPool::InvalidateAll()
+{
+	// Do not continue if no buffers have been handed out.
+	if (fBufferPointers.empty())
+	{
+		return;
+	}
+
+	// Invalidate the buffers. Buffers still referenced by Lua will read as empty from now on.
+	for (auto&& bufferPointer : fBufferPointers)
+	{
+		bufferPointer->BytesPointer = nullptr;
+		bufferPointer->ByteCount = 0;
+	}
+
+	// Release the buffers from the pool's table so that they are never handed out again.
+	if (fLuaStatePointer && (fLuaReferenceId != LUA_NOREF))
+	{
+		lua_rawgeti(fLuaStatePointer, LUA_REGISTRYINDEX, fLuaReferenceId);
+		for (size_t index = fBufferPointers.size(); index > 0; index--)
+		{
+			lua_pushnil(fLuaStatePointer);
+			lua_rawseti(fLuaStatePointer, -2, (int)index);
+		}
+		lua_pop(fLuaStatePointer, 1);
+	}
+	fBufferPointers.clear();
+}
@@ -0,0 +1,118 @@
+// ----------------------------------------------------------------------------
+//
+// LuaBuffer.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Read-only view of native bytes provided to Lua as a "plugin.gog.Buffer" userdata.
+
+  Lets Lua read binary payloads in place via string-like methods, without the bytes being copied into a
+  Lua string first. The bytes are owned natively, which is why a buffer is only valid until its owner
+  invalidates it. Reading an invalidated buffer behaves as if it were empty.
+
+  Lua methods: len(), byte([i [, j]]), sub([i [, j]]), isValid(). The "#" operator provides the length too.
+ */
+struct LuaBuffer
+{
+	/** Pointer to the first byte. Null if invalidated. */
+	const char* BytesPointer;
+
+	/** Number of bytes referenced by "BytesPointer". */
+	size_t ByteCount;
+};
+
+/**
+  Pushes a new "plugin.gog.Buffer" userdata to the top of the Lua stack.
+  @param luaStatePointer Pointer to the Lua state to push the buffer to.
+  @return Returns a pointer to the new buffer, which is initially invalid. Returns null if given a null Lua state.
+ */
+LuaBuffer* PushNewLuaBufferTo(lua_State* luaStatePointer);
+
+/**
+  Fetches a "plugin.gog.Buffer" userdata from the given Lua stack index.
+  @param luaStatePointer Pointer to the Lua state to read the buffer from.
+  @param luaStackIndex Index to the buffer userdata.
+  @return Returns a pointer to the buffer. Returns null if the given index does not reference a buffer.
+ */
+LuaBuffer* GetLuaBufferFrom(lua_State* luaStatePointer, int luaStackIndex);
+
+/**
+  Fetches the bytes of a Lua string or "plugin.gog.Buffer" at the given Lua stack index.
+  @param luaStatePointer Pointer to the Lua state to read from.
+  @param luaStackIndex Index to a string or buffer.
+  @param byteCountPointer Set to the number of bytes fetched. Cannot be null.
+  @return Returns a pointer to the bytes. Returns null if the index does not reference a string or a valid buffer.
+ */
+const char* GetLuaBytesFrom(lua_State* luaStatePointer, int luaStackIndex, size_t* byteCountPointer);
+
+
+/**
+  Hands out "plugin.gog.Buffer" userdata to event dispatches by slot index.
+
+  Event tasks providing many buffers per dispatch fetch them by slot index, which returns the same userdata
+  when a slot is pushed again before the next InvalidateAll() call. Since the buffers reference bytes owned by
+  the event's producer, the producer is expected to call InvalidateAll() before it reuses those bytes.
+
+  Userdata is never reused across InvalidateAll() calls. Lua may have kept a buffer from an earlier dispatch,
+  and that buffer must stay invalid instead of silently referencing a later dispatch's bytes.
+ */
+class LuaBufferPool
+{
+	public:
+		/**
+		  Creates a new pool.
+		  @param luaStatePointer The main Lua state that the pooled buffers will be referenced in.
+		 */
+		LuaBufferPool(lua_State* luaStatePointer);
+
+		/** Releases the pool's buffers from the Lua registry. */
+		virtual ~LuaBufferPool();
+
+		/**
+		  Points the given slot's buffer to the given bytes and pushes it to the top of the Lua stack.
+		  @param luaStatePointer The Lua state to push to. Must be the pool's Lua state or one of its coroutines.
+		  @param slotIndex Zero based index of the slot to push.
+		  @param bytesPointer The bytes for the buffer to reference.
+		  @param byteCount Number of bytes referenced by "bytesPointer".
+		  @return Returns true if a buffer was pushed to Lua. Returns false if given invalid arguments.
+		 */
+		bool PushTo(lua_State* luaStatePointer, size_t slotIndex, const char* bytesPointer, size_t byteCount);
+
+		/**
+		  Invalidates all buffers handed out by PushTo() and releases them from the pool.
+		  The next PushTo() calls create new buffers.
+		 */
+		void InvalidateAll();
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		LuaBufferPool(const LuaBufferPool&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const LuaBufferPool&) = delete;
+
+		/** The Lua state whose registry holds the pool's table of buffers. */
+		lua_State* fLuaStatePointer;
+
+		/** Lua registry reference to the table of buffers indexed by slot. */
+		int fLuaReferenceId;
+
+		/** Buffers pushed since the last InvalidateAll() call, indexed by slot. Kept alive by the referenced table. */
+		std::vector<LuaBuffer*> fBufferPointers;
+};
@@ -0,0 +1,80 @@
+// --------------------------------------------------------------------------------
+//
+// LuaGalaxyId.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LuaGalaxyId.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+bool PushGalaxyIdTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& galaxyId)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Push nil for invalid IDs so that Lua can easily test for them.
+	if (!galaxyId.IsValid())
+	{
+		lua_pushnil(luaStatePointer);
+		return true;
+	}
+
+	// Push the ID as a decimal string.
+	char stringBuffer[32];
+	snprintf(stringBuffer, sizeof(stringBuffer), "%llu", (unsigned long long)galaxyId.ToUint64());
+	lua_pushstring(luaStatePointer, stringBuffer);
+	return true;
+}
+
+galaxy::api::GalaxyID GetGalaxyIdFrom(lua_State* luaStatePointer, int luaStackIndex)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return galaxy::api::GalaxyID();
+	}
+
+	// Note: lua_type() must be used instead of lua_isstring() since the latter is also true for numbers.
+	auto luaType = lua_type(luaStatePointer, luaStackIndex);
+	if (LUA_TSTRING == luaType)
+	{
+		const char* stringId = lua_tostring(luaStatePointer, luaStackIndex);
+		if (!stringId || ('\0' == stringId[0]))
+		{
+			return galaxy::api::GalaxyID();
+		}
+		char* endPointer = nullptr;
+		auto value = strtoull(stringId, &endPointer, 10);
+		if (!endPointer || (*endPointer != '\0'))
+		{
+			return galaxy::api::GalaxyID();
+		}
+		return galaxy::api::GalaxyID((uint64_t)value);
+	}
+	else if (LUA_TNUMBER == luaType)
+	{
+		// Only accept integer values which can be losslessly represented by a Lua number.
+		auto value = lua_tonumber(luaStatePointer, luaStackIndex);
+		if ((value <= 0) || (value != std::floor(value)) || (value > 9007199254740992.0))
+		{
+			return galaxy::api::GalaxyID();
+		}
+		return galaxy::api::GalaxyID((uint64_t)value);
+	}
+	return galaxy::api::GalaxyID();
+}
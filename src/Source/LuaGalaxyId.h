@@ -0,0 +1,40 @@
+// ----------------------------------------------------------------------------
+//
+// LuaGalaxyId.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "GalaxyID.h"
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Pushes the given GOG ID to the top of the Lua stack as a decimal string.
+
+  GalaxyIDs are 64-bit values which cannot be represented by Lua 5.1 numbers without losing precision,
+  which is why they're exchanged with Lua as strings.
+  @param luaStatePointer Pointer to the Lua state to push the ID to.
+  @param galaxyId The ID to push. An invalid ID is pushed as nil.
+  @return Returns true if a value was pushed to Lua. Returns false if given a null Lua state.
+ */
+bool PushGalaxyIdTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& galaxyId);
+
+/**
+  Fetches a GOG ID from the given Lua stack index.
+  @param luaStatePointer Pointer to the Lua state to read the ID from.
+  @param luaStackIndex Index to a decimal string or an integer Lua number providing the ID.
+  @return Returns the ID stored at the given index.
+
+          Returns an invalid GalaxyID if the given index does not reference a valid ID.
+ */
+galaxy::api::GalaxyID GetGalaxyIdFrom(lua_State* luaStatePointer, int luaStackIndex);
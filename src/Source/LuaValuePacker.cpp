@@ -0,0 +1,440 @@
+// --------------------------------------------------------------------------------
+//
+// LuaValuePacker.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "LuaValuePacker.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <unordered_map>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+const int kMaxLuaValuePackDepth = 32;
+
+/** Tag of nil. Also terminates a table's key/value pairs. */
+static const uint8_t kNilTag = 0x00;
+static const uint8_t kFalseTag = 0x01;
+static const uint8_t kTrueTag = 0x02;
+
+/** Tag of an integral number from 0 to 2^53, followed by the number as a varint. */
+static const uint8_t kPositiveIntegerTag = 0x03;
+
+/** Tag of an integral number from -2^53 to -1, followed by -(number + 1) as a varint. */
+static const uint8_t kNegativeIntegerTag = 0x04;
+
+/** Tag of any other number, followed by the number as a little endian double. */
+static const uint8_t kDoubleTag = 0x05;
+
+/** Tag of a string written in full, followed by its length as a varint and its bytes. */
+static const uint8_t kStringTag = 0x06;
+
+/** Tag of a string already written, followed by the string's number as a varint. */
+static const uint8_t kStringReferenceTag = 0x07;
+
+/** Tag of a table, followed by its array part's length as a varint, its values and its key/value pairs. */
+static const uint8_t kTableTag = 0x08;
+
+/** Strings shorter than this are always written in full since a reference would not be any smaller. */
+static const size_t kMinReferencedStringByteCount = 2;
+
+/** Largest magnitude up to which all integral doubles are exactly representable. */
+static const double kMaxExactInteger = 9007199254740992.0;
+
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+static void WriteVarint(std::vector<char>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back((char)value);
+}
+
+static bool ReadVarint(const uint8_t* bytesPointer, size_t byteCount, size_t* offsetPointer, uint64_t* valuePointer)
+{
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (*offsetPointer >= byteCount)
+		{
+			return false;
+		}
+		auto nextByte = bytesPointer[(*offsetPointer)++];
+		value |= (uint64_t)(nextByte & 0x7F) << shift;
+		if (!(nextByte & 0x80))
+		{
+			*valuePointer = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** State of one PackLuaValueFrom() call. */
+struct PackState
+{
+	lua_State* LuaStatePointer;
+	std::vector<char>* BytesPointer;
+	std::string* ErrorMessagePointer;
+
+	/**
+	  Numbers of the strings written so far, keyed by the address of their Lua string.
+	  Lua 5.1 interns all strings, so equal strings share one address, which stays valid while packing since
+	  every string written is referenced by the value being packed.
+	 */
+	std::unordered_map<const char*, uint32_t> StringNumberMap;
+};
+
+static bool PackValue(PackState& state, int luaStackIndex, int depth);
+
+static void PackNumber(PackState& state, lua_Number value)
+{
+	auto& bytes = *state.BytesPointer;
+	if ((floor(value) == value) && (fabs(value) <= kMaxExactInteger))
+	{
+		if (value >= 0)
+		{
+			bytes.push_back((char)kPositiveIntegerTag);
+			WriteVarint(bytes, (uint64_t)value);
+		}
+		else
+		{
+			bytes.push_back((char)kNegativeIntegerTag);
+			WriteVarint(bytes, (uint64_t)(-(value + 1.0)));
+		}
+		return;
+	}
+	uint64_t bits;
+	double doubleValue = (double)value;
+	memcpy(&bits, &doubleValue, sizeof(bits));
+	bytes.push_back((char)kDoubleTag);
+	for (int byteIndex = 0; byteIndex < 8; byteIndex++)
+	{
+		bytes.push_back((char)((bits >> (byteIndex * 8)) & 0xFF));
+	}
+}
+
+static void PackString(PackState& state, int luaStackIndex)
+{
+	auto& bytes = *state.BytesPointer;
+	size_t byteCount = 0;
+	auto stringPointer = lua_tolstring(state.LuaStatePointer, luaStackIndex, &byteCount);
+	if (byteCount >= kMinReferencedStringByteCount)
+	{
+		auto result = state.StringNumberMap.emplace(stringPointer, (uint32_t)state.StringNumberMap.size());
+		if (!result.second)
+		{
+			bytes.push_back((char)kStringReferenceTag);
+			WriteVarint(bytes, result.first->second);
+			return;
+		}
+	}
+	bytes.push_back((char)kStringTag);
+	WriteVarint(bytes, byteCount);
+	bytes.insert(bytes.end(), stringPointer, stringPointer + byteCount);
+}
+
+static bool PackTable(PackState& state, int luaStackIndex, int depth)
+{
+	// Validate.
+	auto luaStatePointer = state.LuaStatePointer;
+	if (depth >= kMaxLuaValuePackDepth)
+	{
+		*state.ErrorMessagePointer = "Tables are nested too deeply or reference themselves.";
+		return false;
+	}
+	if (!lua_checkstack(luaStatePointer, 3))
+	{
+		*state.ErrorMessagePointer = "Out of Lua stack space.";
+		return false;
+	}
+	if (luaStackIndex < 0)
+	{
+		luaStackIndex = lua_gettop(luaStatePointer) + luaStackIndex + 1;
+	}
+
+	// Determine the array part's length, which ends at the first nil since the length operator may skip holes.
+	auto maxArrayCount = (int)lua_objlen(luaStatePointer, luaStackIndex);
+	int arrayCount = 0;
+	for (; arrayCount < maxArrayCount; arrayCount++)
+	{
+		lua_rawgeti(luaStatePointer, luaStackIndex, arrayCount + 1);
+		bool isNil = lua_isnil(luaStatePointer, -1);
+		lua_pop(luaStatePointer, 1);
+		if (isNil)
+		{
+			break;
+		}
+	}
+
+	// Write the array part.
+	auto& bytes = *state.BytesPointer;
+	bytes.push_back((char)kTableTag);
+	WriteVarint(bytes, (uint64_t)arrayCount);
+	for (int index = 1; index <= arrayCount; index++)
+	{
+		lua_rawgeti(luaStatePointer, luaStackIndex, index);
+		bool wasPacked = PackValue(state, -1, depth + 1);
+		lua_pop(luaStatePointer, 1);
+		if (!wasPacked)
+		{
+			return false;
+		}
+	}
+
+	// Write all other key/value pairs, followed by a nil tag since keys cannot be nil.
+	// Note: Number keys must not be converted to strings in place since that would break lua_next().
+	lua_pushnil(luaStatePointer);
+	while (lua_next(luaStatePointer, luaStackIndex))
+	{
+		if (lua_type(luaStatePointer, -2) == LUA_TNUMBER)
+		{
+			auto key = lua_tonumber(luaStatePointer, -2);
+			if ((floor(key) == key) && (key >= 1) && (key <= arrayCount))
+			{
+				lua_pop(luaStatePointer, 1);
+				continue;
+			}
+		}
+		if (!PackValue(state, -2, depth + 1) || !PackValue(state, -1, depth + 1))
+		{
+			lua_pop(luaStatePointer, 2);
+			return false;
+		}
+		lua_pop(luaStatePointer, 1);
+	}
+	bytes.push_back((char)kNilTag);
+	return true;
+}
+
+static bool PackValue(PackState& state, int luaStackIndex, int depth)
+{
+	auto luaStatePointer = state.LuaStatePointer;
+	switch (lua_type(luaStatePointer, luaStackIndex))
+	{
+		case LUA_TNONE:
+		case LUA_TNIL:
+			state.BytesPointer->push_back((char)kNilTag);
+			return true;
+		case LUA_TBOOLEAN:
+			state.BytesPointer->push_back((char)(lua_toboolean(luaStatePointer, luaStackIndex) ? kTrueTag : kFalseTag));
+			return true;
+		case LUA_TNUMBER:
+			PackNumber(state, lua_tonumber(luaStatePointer, luaStackIndex));
+			return true;
+		case LUA_TSTRING:
+			PackString(state, luaStackIndex);
+			return true;
+		case LUA_TTABLE:
+			return PackTable(state, luaStackIndex, depth);
+		default:
+			break;
+	}
+	*state.ErrorMessagePointer = "Cannot pack a value of type \"";
+	*state.ErrorMessagePointer += lua_typename(luaStatePointer, lua_type(luaStatePointer, luaStackIndex));
+	*state.ErrorMessagePointer += "\".";
+	return false;
+}
+
+/** State of one PushUnpackedLuaValueTo() call. */
+struct UnpackState
+{
+	lua_State* LuaStatePointer;
+	const uint8_t* BytesPointer;
+	size_t ByteCount;
+	size_t Offset;
+
+	/** Offsets and lengths of the referenceable strings read so far, in the order they were written. */
+	std::vector<std::pair<size_t, size_t>> Strings;
+};
+
+/**
+  Reads the next value and pushes it to Lua.
+  @param state The unpack call's state.
+  @param depth Number of tables the value is nested in.
+  @param isNilPointer Set true if a nil tag was read, in which case nil is pushed. Can be null.
+  @return Returns true if a value was pushed. Returns false if the bytes are malformed, in which case
+          values may have been left on the Lua stack.
+ */
+static bool UnpackValue(UnpackState& state, int depth, bool* isNilPointer)
+{
+	auto luaStatePointer = state.LuaStatePointer;
+	if ((state.Offset >= state.ByteCount) || !lua_checkstack(luaStatePointer, 3))
+	{
+		return false;
+	}
+	auto tag = state.BytesPointer[state.Offset++];
+	if (isNilPointer)
+	{
+		*isNilPointer = (kNilTag == tag);
+	}
+	uint64_t value = 0;
+	switch (tag)
+	{
+		case kNilTag:
+			lua_pushnil(luaStatePointer);
+			return true;
+		case kFalseTag:
+		case kTrueTag:
+			lua_pushboolean(luaStatePointer, (kTrueTag == tag) ? 1 : 0);
+			return true;
+		case kPositiveIntegerTag:
+		case kNegativeIntegerTag:
+			if (!ReadVarint(state.BytesPointer, state.ByteCount, &state.Offset, &value))
+			{
+				return false;
+			}
+			lua_pushnumber(
+					luaStatePointer, (kPositiveIntegerTag == tag) ? (lua_Number)value : -(lua_Number)value - 1.0);
+			return true;
+		case kDoubleTag:
+		{
+			if ((state.ByteCount - state.Offset) < 8)
+			{
+				return false;
+			}
+			uint64_t bits = 0;
+			for (int byteIndex = 0; byteIndex < 8; byteIndex++)
+			{
+				bits |= (uint64_t)state.BytesPointer[state.Offset++] << (byteIndex * 8);
+			}
+			double doubleValue;
+			memcpy(&doubleValue, &bits, sizeof(doubleValue));
+			lua_pushnumber(luaStatePointer, (lua_Number)doubleValue);
+			return true;
+		}
+		case kStringTag:
+			if (!ReadVarint(state.BytesPointer, state.ByteCount, &state.Offset, &value) ||
+			    (value > (state.ByteCount - state.Offset)))
+			{
+				return false;
+			}
+			if (value >= kMinReferencedStringByteCount)
+			{
+				state.Strings.push_back(std::make_pair(state.Offset, (size_t)value));
+			}
+			lua_pushlstring(luaStatePointer, (const char*)state.BytesPointer + state.Offset, (size_t)value);
+			state.Offset += (size_t)value;
+			return true;
+		case kStringReferenceTag:
+			if (!ReadVarint(state.BytesPointer, state.ByteCount, &state.Offset, &value) ||
+			    (value >= state.Strings.size()))
+			{
+				return false;
+			}
+			lua_pushlstring(
+					luaStatePointer, (const char*)state.BytesPointer + state.Strings[(size_t)value].first,
+					state.Strings[(size_t)value].second);
+			return true;
+		case kTableTag:
+		{
+			// Every value takes at least one byte, which bounds how much the table can preallocate.
+			if ((depth >= kMaxLuaValuePackDepth) ||
+			    !ReadVarint(state.BytesPointer, state.ByteCount, &state.Offset, &value) ||
+			    (value > (state.ByteCount - state.Offset)))
+			{
+				return false;
+			}
+			auto arrayCount = (int)value;
+			lua_createtable(luaStatePointer, arrayCount, 0);
+			for (int index = 1; index <= arrayCount; index++)
+			{
+				if (!UnpackValue(state, depth + 1, nullptr))
+				{
+					return false;
+				}
+				lua_rawseti(luaStatePointer, -2, index);
+			}
+			while (true)
+			{
+				bool isNil = false;
+				if (!UnpackValue(state, depth + 1, &isNil))
+				{
+					return false;
+				}
+				if (isNil)
+				{
+					lua_pop(luaStatePointer, 1);
+					break;
+				}
+				if (lua_type(luaStatePointer, -1) == LUA_TNUMBER)
+				{
+					auto key = lua_tonumber(luaStatePointer, -1);
+					if (key != key)
+					{
+						// NaN keys cannot be assigned.
+						return false;
+					}
+				}
+				if (!UnpackValue(state, depth + 1, nullptr))
+				{
+					return false;
+				}
+				lua_rawset(luaStatePointer, -3);
+			}
+			return true;
+		}
+		default:
+			break;
+	}
+	return false;
+}
+
+
+//---------------------------------------------------------------------------------
+// Public Functions
+//---------------------------------------------------------------------------------
+
+bool PackLuaValueFrom(lua_State* luaStatePointer, int luaStackIndex, std::vector<char>& bytes, std::string& errorMessage)
+{
+	bytes.clear();
+	errorMessage.clear();
+	if (!luaStatePointer)
+	{
+		errorMessage = "Lua state is null.";
+		return false;
+	}
+	PackState state;
+	state.LuaStatePointer = luaStatePointer;
+	state.BytesPointer = &bytes;
+	state.ErrorMessagePointer = &errorMessage;
+	return PackValue(state, luaStackIndex, 0);
+}
+
+bool PushUnpackedLuaValueTo(lua_State* luaStatePointer, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if (!luaStatePointer || !bytesPointer)
+	{
+		return false;
+	}
+
+	// Unpack the value, which must span all of the given bytes.
+	UnpackState state;
+	state.LuaStatePointer = luaStatePointer;
+	state.BytesPointer = (const uint8_t*)bytesPointer;
+	state.ByteCount = byteCount;
+	state.Offset = 0;
+	auto previousTop = lua_gettop(luaStatePointer);
+	if (!UnpackValue(state, 0, nullptr) || (state.Offset != byteCount))
+	{
+		lua_settop(luaStatePointer, previousTop);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,54 @@
+// ----------------------------------------------------------------------------
+//
+// LuaValuePacker.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Schema-less binary encoding of Lua values, used by gog.pack() and gog.unpack().
+
+  Supports nil, booleans, numbers, strings and tables of those. Every value starts with a one byte tag.
+  Integral numbers are written as varints, other numbers as little endian doubles. Strings of at least
+  2 bytes are numbered in the order they are first written and repeats are written as a reference to
+  that number instead, which makes repeated table keys cheap. A table is written as its array part's
+  length followed by its values, then by its other key/value pairs and a terminating nil tag.
+ */
+
+/** Maximum nesting depth of tables, which also rejects tables referencing themselves. */
+extern const int kMaxLuaValuePackDepth;
+
+/**
+  Packs the Lua value at the given stack index.
+  @param luaStatePointer Pointer to the Lua state to read the value from.
+  @param luaStackIndex Index to the value to pack.
+  @param bytes The vector to write the packed value to. Its previous contents are replaced.
+  @param errorMessage Set to a description of the problem if the value cannot be packed.
+  @return Returns true if the value was packed.
+          Returns false if it is or contains an unsupported type, or if its tables are nested too deeply.
+ */
+bool PackLuaValueFrom(lua_State* luaStatePointer, int luaStackIndex, std::vector<char>& bytes, std::string& errorMessage);
+
+/**
+  Unpacks the given bytes and pushes the resulting Lua value to the top of the Lua stack.
+  @param luaStatePointer Pointer to the Lua state to push the value to.
+  @param bytesPointer The bytes written by PackLuaValueFrom().
+  @param byteCount Number of bytes to unpack.
+  @return Returns true if a value was pushed to Lua. Returns false if the bytes are malformed, pushing nothing.
+ */
+bool PushUnpackedLuaValueTo(lua_State* luaStatePointer, const char* bytesPointer, size_t byteCount);
@@ -0,0 +1,1069 @@
+// --------------------------------------------------------------------------------
+//
+// P2PNetworking.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "P2PNetworking.h"
+#include "DispatchEventTask.h"
+#include "LobbyRoster.h"
+#include "LuaBuffer.h"
+#include "P2PReliability.h"
+#include "RuntimeContext.h"
+#include "SnapshotReplicator.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+const size_t P2PNetworking::kDefaultFrameByteBudget = 256 * 1024;
+const size_t P2PNetworking::kSendQueueCapacity = 1024;
+const size_t P2PNetworking::kMaxDatagramByteCount = 1200;
+const size_t P2PNetworking::kMaxScheduledByteCountPerPeer = 1024 * 1024;
+const double P2PNetworking::kTokenBucketBurstInSeconds = 0.1;
+
+/** Number of milliseconds the worker thread waits for packets to send before polling for received packets again. */
+static const int kWorkerPollIntervalInMilliseconds = 1;
+
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+/** Gets the number of bytes needed to write the given value as a varint. */
+static size_t GetVarintByteCountOf(uint64_t value)
+{
+	size_t byteCount = 1;
+	for (; value >= 0x80; value >>= 7)
+	{
+		byteCount++;
+	}
+	return byteCount;
+}
+
+static void WriteVarint(std::vector<char>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back((char)value);
+}
+
+static bool ReadVarint(const uint8_t* bytesPointer, size_t byteCount, size_t* offsetPointer, uint64_t* valuePointer)
+{
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (*offsetPointer >= byteCount)
+		{
+			return false;
+		}
+		auto nextByte = bytesPointer[(*offsetPointer)++];
+		value |= (uint64_t)(nextByte & 0x7F) << shift;
+		if (!(nextByte & 0x80))
+		{
+			*valuePointer = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+  Adds the totals counted by the worker thread to the given totals.
+  Only includes the totals which the worker thread counts.
+ */
+static void AddWorkerTotalsTo(P2PNetworking::Statistics& targetStatistics, const P2PNetworking::Statistics& statistics)
+{
+	targetStatistics.SentCount += statistics.SentCount;
+	targetStatistics.DatagramSentCount += statistics.DatagramSentCount;
+	targetStatistics.SentByteCount += statistics.SentByteCount;
+	targetStatistics.BudgetExhaustedCount += statistics.BudgetExhaustedCount;
+	targetStatistics.SendFailureCount += statistics.SendFailureCount;
+	targetStatistics.UnpackDropCount += statistics.UnpackDropCount;
+}
+
+/** Determines if the given send type asks for the packet to be sent right away instead of by ProcessData(). */
+static bool IsImmediate(galaxy::api::P2PSendType sendType)
+{
+	return (galaxy::api::P2P_SEND_UNRELIABLE_IMMEDIATE == sendType) ||
+			(galaxy::api::P2P_SEND_RELIABLE_IMMEDIATE == sendType);
+}
+
+/** Gets the variant of the given send type which sends the packet right away instead of by ProcessData(). */
+static galaxy::api::P2PSendType ToImmediate(galaxy::api::P2PSendType sendType)
+{
+	if (galaxy::api::P2P_SEND_UNRELIABLE == sendType)
+	{
+		return galaxy::api::P2P_SEND_UNRELIABLE_IMMEDIATE;
+	}
+	if (galaxy::api::P2P_SEND_RELIABLE == sendType)
+	{
+		return galaxy::api::P2P_SEND_RELIABLE_IMMEDIATE;
+	}
+	return sendType;
+}
+
+
+//---------------------------------------------------------------------------------
+// P2PNetworking Class Members
+//---------------------------------------------------------------------------------
+
+P2PNetworking::Batch::Batch()
+:	IsUsingBuffers(false)
+{
+}
+
+P2PNetworking::Statistics::Statistics()
+:	SentCount(0),
+	DatagramSentCount(0),
+	SentByteCount(0),
+	ReceivedCount(0),
+	ReceivedByteCount(0),
+	BudgetExhaustedCount(0),
+	SendFailureCount(0),
+	SendQueueFullCount(0),
+	UnpackDropCount(0),
+	DeferredCount(0),
+	DeferredByteCount(0),
+	ScheduleQueueFullCount(0)
+{
+}
+
+P2PNetworking::ScheduledPeer::ScheduledPeer()
+:	TokenByteCount(0),
+	Queues(3),
+	QueuedByteCount(0)
+{
+}
+
+P2PNetworking::ChannelTraffic::ChannelTraffic()
+:	SentCount(0),
+	SentByteCount(0),
+	ReceivedCount(0),
+	ReceivedByteCount(0)
+{
+}
+
+P2PNetworking::P2PNetworking(RuntimeContext& context)
+:	fContext(context),
+	fBatchPointer(std::make_shared<Batch>()),
+	fNextChannelIndex(0),
+	fFrameByteBudget(kDefaultFrameByteBudget),
+	fIsUsingBuffers(false),
+	fIsAggregating(false),
+	fAggregator(false),
+	fWorkerAggregator(true),
+	fIsThreaded(false),
+	fIsWorkerRunning(false),
+	fChannelPriorities(256, SendPriority::kNormal),
+	fPeerBytesPerSecond(0),
+	fIsScheduling(false),
+	fScheduledByteCount(0)
+{
+}
+
+P2PNetworking::~P2PNetworking()
+{
+	StopWorker();
+}
+
+bool P2PNetworking::Send(
+	const galaxy::api::GalaxyID& userId, const char* bytesPointer, size_t byteCount,
+	galaxy::api::P2PSendType sendType, uint8_t channel)
+{
+	// Validate.
+	if (!userId.IsValid() || !bytesPointer || (byteCount > UINT32_MAX))
+	{
+		return false;
+	}
+
+	// Send the packet right away if nothing is being scheduled.
+	if (!fIsScheduling && fScheduledPeerMap.empty())
+	{
+		return SendNow(userId, bytesPointer, byteCount, sendType, channel);
+	}
+
+	// Send the packet right away if its peer has tokens left and nothing queued ahead of it.
+	// Low priority packets are always deferred so that the frame's other packets go out first.
+	auto priority = (size_t)fChannelPriorities[channel];
+	auto& peer = fScheduledPeerMap[userId.ToUint64()];
+	RefillTokens(peer, std::chrono::steady_clock::now());
+	bool isDeferred = (SendPriority::kLow == fChannelPriorities[channel]) || (peer.TokenByteCount < 0);
+	for (size_t queueIndex = 0; !isDeferred && (queueIndex <= priority); queueIndex++)
+	{
+		isDeferred = !peer.Queues[queueIndex].empty();
+	}
+	if (!isDeferred)
+	{
+		if (!SendNow(userId, bytesPointer, byteCount, sendType, channel))
+		{
+			return false;
+		}
+		if (fPeerBytesPerSecond > 0)
+		{
+			peer.TokenByteCount -= (double)byteCount;
+		}
+		return true;
+	}
+
+	// Otherwise queue it for Flush() to send.
+	if ((peer.QueuedByteCount + byteCount) > kMaxScheduledByteCountPerPeer)
+	{
+		fStatistics.ScheduleQueueFullCount++;
+		return false;
+	}
+	peer.Queues[priority].emplace_back();
+	auto& packet = peer.Queues[priority].back();
+	packet.UserId = userId;
+	packet.SendType = sendType;
+	packet.Channel = channel;
+	packet.Bytes.Assign(fBufferPool, bytesPointer, byteCount);
+	peer.QueuedByteCount += byteCount;
+	fScheduledByteCount += byteCount;
+	fStatistics.DeferredCount++;
+	fStatistics.DeferredByteCount += byteCount;
+	return true;
+}
+
+P2PNetworking::SendPriority P2PNetworking::GetChannelPriority(uint8_t channel) const
+{
+	return fChannelPriorities[channel];
+}
+
+void P2PNetworking::SetChannelPriority(uint8_t channel, SendPriority priority)
+{
+	fChannelPriorities[channel] = priority;
+	fIsScheduling = (fPeerBytesPerSecond > 0) ||
+			(std::find(fChannelPriorities.begin(), fChannelPriorities.end(), SendPriority::kLow) != fChannelPriorities.end());
+}
+
+size_t P2PNetworking::GetPeerBytesPerSecond() const
+{
+	return fPeerBytesPerSecond;
+}
+
+void P2PNetworking::SetPeerBytesPerSecond(size_t byteCount)
+{
+	fPeerBytesPerSecond = byteCount;
+	fIsScheduling = (fPeerBytesPerSecond > 0) ||
+			(std::find(fChannelPriorities.begin(), fChannelPriorities.end(), SendPriority::kLow) != fChannelPriorities.end());
+}
+
+size_t P2PNetworking::GetScheduledByteCount() const
+{
+	return fScheduledByteCount;
+}
+
+void P2PNetworking::GetScheduledCountsWith(
+	const galaxy::api::GalaxyID& userId, size_t& packetCount, size_t& byteCount) const
+{
+	packetCount = 0;
+	byteCount = 0;
+	auto peerIterator = fScheduledPeerMap.find(userId.ToUint64());
+	if (peerIterator == fScheduledPeerMap.end())
+	{
+		return;
+	}
+	for (auto&& queue : peerIterator->second.Queues)
+	{
+		packetCount += queue.size();
+	}
+	byteCount = peerIterator->second.QueuedByteCount;
+}
+
+PacketBufferPool& P2PNetworking::GetBufferPool()
+{
+	return fBufferPool;
+}
+
+const PacketBufferPool::Statistics& P2PNetworking::GetBufferPoolStatistics() const
+{
+	return fBufferPool.GetStatistics();
+}
+
+bool P2PNetworking::SendNow(
+	const galaxy::api::GalaxyID& userId, const char* bytesPointer, size_t byteCount,
+	galaxy::api::P2PSendType sendType, uint8_t channel)
+{
+	// In threaded mode, copy the packet into the worker's queue and wake it up.
+	// Note: The slot's byte vector is reused, so this does not allocate once the queue has warmed up.
+	if (fIsThreaded)
+	{
+		auto packetPointer = fSendQueuePointer->BeginPush();
+		if (!packetPointer)
+		{
+			fStatistics.SendQueueFullCount++;
+			return false;
+		}
+		packetPointer->UserId = userId;
+		packetPointer->SendType = sendType;
+		packetPointer->Channel = channel;
+		packetPointer->Bytes.assign(bytesPointer, bytesPointer + byteCount);
+		fSendQueuePointer->EndPush();
+		fWorkerCondition.notify_one();
+	}
+	else
+	{
+		// Otherwise send the packet now, or pack it into its datagram.
+		auto networkingPointer = galaxy::api::Networking();
+		if (!networkingPointer)
+		{
+			return false;
+		}
+		bool wasSent = false;
+		if (fIsAggregating)
+		{
+			wasSent = fAggregator.Add(networkingPointer, userId, bytesPointer, byteCount, sendType, channel, fStatistics);
+		}
+		else
+		{
+			wasSent = networkingPointer->SendP2PPacket(userId, bytesPointer, (uint32_t)byteCount, sendType, channel);
+			if (wasSent)
+			{
+				fStatistics.SentCount++;
+				fStatistics.SentByteCount += byteCount;
+			}
+		}
+		if (!wasSent)
+		{
+			return false;
+		}
+	}
+
+	// Count the packet towards the peer's traffic.
+	auto& traffic = fPeerTrafficMap[userId.ToUint64()][channel];
+	traffic.SentCount++;
+	traffic.SentByteCount += byteCount;
+	return true;
+}
+
+void P2PNetworking::SetUserChannels(const std::vector<uint8_t>& channels)
+{
+	std::vector<uint8_t> sortedChannels(channels);
+	std::sort(sortedChannels.begin(), sortedChannels.end());
+	sortedChannels.erase(std::unique(sortedChannels.begin(), sortedChannels.end()), sortedChannels.end());
+	fUserChannels.swap(sortedChannels);
+	UpdateSubscribedChannels();
+}
+
+const std::vector<uint8_t>& P2PNetworking::GetUserChannels() const
+{
+	return fUserChannels;
+}
+
+void P2PNetworking::UpdateSubscribedChannels()
+{
+	// Subscribe to the user's channels along with the internal channels which have to be read to work.
+	// Note: A channel an internal subsystem no longer uses is dropped here, so its raw packets don't reach Lua.
+	std::vector<uint8_t> sortedChannels(fUserChannels);
+	auto reliabilityPointer = fContext.GetP2PReliability();
+	if (reliabilityPointer && (reliabilityPointer->GetChannel() >= 0))
+	{
+		sortedChannels.push_back((uint8_t)reliabilityPointer->GetChannel());
+	}
+	auto replicatorPointer = fContext.GetSnapshotReplicator();
+	if (replicatorPointer && (replicatorPointer->GetChannel() >= 0))
+	{
+		sortedChannels.push_back((uint8_t)replicatorPointer->GetChannel());
+	}
+	std::sort(sortedChannels.begin(), sortedChannels.end());
+	sortedChannels.erase(std::unique(sortedChannels.begin(), sortedChannels.end()), sortedChannels.end());
+	if (sortedChannels == fSubscribedChannels)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(fWorkerMutex);
+		fSubscribedChannels.swap(sortedChannels);
+	}
+	fNextChannelIndex = 0;
+
+	// Preallocate the arena now that packets will be read.
+	if (!fSubscribedChannels.empty())
+	{
+		fBatchPointer->Bytes.reserve(fFrameByteBudget);
+	}
+}
+
+const std::vector<uint8_t>& P2PNetworking::GetSubscribedChannels() const
+{
+	return fSubscribedChannels;
+}
+
+size_t P2PNetworking::GetFrameByteBudget() const
+{
+	return fFrameByteBudget;
+}
+
+void P2PNetworking::SetFrameByteBudget(size_t byteCount)
+{
+	if (0 == byteCount)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(fWorkerMutex);
+		fFrameByteBudget = byteCount;
+	}
+	if (!fSubscribedChannels.empty())
+	{
+		fBatchPointer->Bytes.reserve(fFrameByteBudget);
+	}
+}
+
+bool P2PNetworking::IsUsingBuffers() const
+{
+	return fIsUsingBuffers;
+}
+
+void P2PNetworking::SetUsingBuffers(bool value)
+{
+	fIsUsingBuffers = value;
+}
+
+bool P2PNetworking::IsAggregating() const
+{
+	return fIsAggregating;
+}
+
+void P2PNetworking::SetAggregating(bool value)
+{
+	// Note: The worker thread flushes its own datagrams every time it drains its queue.
+	fIsAggregating = value;
+	if (!value)
+	{
+		Flush();
+	}
+}
+
+void P2PNetworking::Flush()
+{
+	DrainScheduledPackets();
+	auto networkingPointer = galaxy::api::Networking();
+	if (!fIsThreaded && networkingPointer)
+	{
+		fAggregator.Flush(networkingPointer, fStatistics);
+	}
+}
+
+bool P2PNetworking::IsThreaded() const
+{
+	return fIsThreaded;
+}
+
+void P2PNetworking::SetThreaded(bool value)
+{
+	if (value == fIsThreaded)
+	{
+		return;
+	}
+	if (!value)
+	{
+		StopWorker();
+		return;
+	}
+
+	// Start the worker thread, after sending what was packed on the main thread.
+	Flush();
+	if (!fSendQueuePointer)
+	{
+		fSendQueuePointer.reset(new SpscQueue<OutgoingPacket>(kSendQueueCapacity));
+	}
+	fReadyBatchPointer = std::make_shared<Batch>();
+	fReadyBatchPointer->Bytes.reserve(fFrameByteBudget);
+	fIsThreaded = true;
+	fIsWorkerRunning = true;
+	fWorkerThread = std::thread(&P2PNetworking::RunWorker, this);
+}
+
+const P2PNetworking::Statistics& P2PNetworking::GetStatistics() const
+{
+	return fStatistics;
+}
+
+const P2PNetworking::PeerTraffic* P2PNetworking::GetTrafficWith(const galaxy::api::GalaxyID& userId) const
+{
+	auto iterator = fPeerTrafficMap.find(userId.ToUint64());
+	return (iterator != fPeerTrafficMap.end()) ? &iterator->second : nullptr;
+}
+
+const std::unordered_map<uint64_t, P2PNetworking::PeerTraffic>& P2PNetworking::GetPeerTrafficMap() const
+{
+	return fPeerTrafficMap;
+}
+
+void P2PNetworking::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	// Stop counting the traffic of every peer we no longer share a lobby with.
+	auto rosterPointer = fContext.GetLobbyRoster();
+	for (auto trafficIterator = fPeerTrafficMap.begin(); trafficIterator != fPeerTrafficMap.end();)
+	{
+		if (rosterPointer->IsSharingLobbyWith(galaxy::api::GalaxyID(trafficIterator->first), lobbyID))
+		{
+			++trafficIterator;
+		}
+		else
+		{
+			trafficIterator = fPeerTrafficMap.erase(trafficIterator);
+		}
+	}
+}
+
+void P2PNetworking::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Stop counting a departed member's traffic, unless it is still in another lobby with us.
+	if (galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED == memberStateChange)
+	{
+		return;
+	}
+	if (!fContext.GetLobbyRoster()->IsSharingLobbyWith(memberID, lobbyID))
+	{
+		fPeerTrafficMap.erase(memberID.ToUint64());
+	}
+}
+
+void P2PNetworking::RefillTokens(ScheduledPeer& peer, std::chrono::steady_clock::time_point currentTime) const
+{
+	// Unlimited peers are never out of tokens.
+	if (0 == fPeerBytesPerSecond)
+	{
+		peer.TokenByteCount = 0;
+		peer.RefillTime = currentTime;
+		return;
+	}
+
+	// Note: A new peer's refill time is the clock's epoch, which fills its bucket.
+	auto capacity = (std::max)((double)fPeerBytesPerSecond * kTokenBucketBurstInSeconds, (double)kMaxDatagramByteCount);
+	auto elapsedSeconds = std::chrono::duration<double>(currentTime - peer.RefillTime).count();
+	peer.TokenByteCount = (std::min)(capacity, peer.TokenByteCount + (elapsedSeconds * (double)fPeerBytesPerSecond));
+	peer.RefillTime = currentTime;
+}
+
+void P2PNetworking::DrainScheduledPackets()
+{
+	// Do not continue if nothing is queued or rate limited.
+	if (fScheduledPeerMap.empty())
+	{
+		return;
+	}
+
+	auto currentTime = std::chrono::steady_clock::now();
+	auto capacity = (std::max)((double)fPeerBytesPerSecond * kTokenBucketBurstInSeconds, (double)kMaxDatagramByteCount);
+	for (auto peerIterator = fScheduledPeerMap.begin(); peerIterator != fScheduledPeerMap.end();)
+	{
+		// Send the peer's queued packets while it has tokens, highest priority first.
+		// Lower priorities wait for as long as a higher priority has packets left.
+		auto& peer = peerIterator->second;
+		RefillTokens(peer, currentTime);
+		for (auto&& queue : peer.Queues)
+		{
+			while (!queue.empty() && (peer.TokenByteCount >= 0))
+			{
+				auto& packet = queue.front();
+				auto byteCount = packet.Bytes.GetByteCount();
+				auto bytesPointer = byteCount ? packet.Bytes.GetBytes() : "";
+				if (!SendNow(packet.UserId, bytesPointer, byteCount, packet.SendType, packet.Channel))
+				{
+					fStatistics.SendFailureCount++;
+				}
+				if (fPeerBytesPerSecond > 0)
+				{
+					peer.TokenByteCount -= (double)byteCount;
+				}
+				peer.QueuedByteCount -= byteCount;
+				fScheduledByteCount -= byteCount;
+				queue.pop_front();
+			}
+			if (!queue.empty())
+			{
+				break;
+			}
+		}
+
+		// Forget the peer once it has nothing queued and its bucket is full again.
+		if ((0 == peer.QueuedByteCount) && ((0 == fPeerBytesPerSecond) || (peer.TokenByteCount >= capacity)))
+		{
+			peerIterator = fScheduledPeerMap.erase(peerIterator);
+		}
+		else
+		{
+			++peerIterator;
+		}
+	}
+}
+
+size_t P2PNetworking::GetSendQueueCount() const
+{
+	return (fIsThreaded && fSendQueuePointer) ? fSendQueuePointer->GetCount() : 0;
+}
+
+void P2PNetworking::Process()
+{
+	// Buffers provided by the last dispatched batch are only valid until now.
+	if (fBufferPoolPointer)
+	{
+		fBufferPoolPointer->InvalidateAll();
+	}
+
+	// In threaded mode, take the worker's batch and totals.
+	if (fIsThreaded)
+	{
+		{
+			std::lock_guard<std::mutex> lock(fWorkerMutex);
+			if (!fReadyBatchPointer->Packets.empty())
+			{
+				fBatchPointer.swap(fReadyBatchPointer);
+			}
+			AddWorkerTotalsTo(fStatistics, fWorkerStatistics);
+			fWorkerStatistics = Statistics();
+		}
+		if (!fBatchPointer->Packets.empty())
+		{
+			DispatchBatch();
+		}
+		return;
+	}
+
+	// Do not continue if not subscribed to any channels, unless the worker left packets behind.
+	if (fSubscribedChannels.empty() && fBatchPointer->Packets.empty())
+	{
+		return;
+	}
+	auto networkingPointer = galaxy::api::Networking();
+	if (!networkingPointer)
+	{
+		return;
+	}
+
+	// Read packets into the arena until all subscribed channels are drained or the frame's budget is spent.
+	if (!fSubscribedChannels.empty())
+	{
+		auto firstChannelIndex = fNextChannelIndex % fSubscribedChannels.size();
+		fNextChannelIndex = firstChannelIndex + 1;
+		bool isBudgetExhausted = ReadPackets(
+				networkingPointer, *fBatchPointer, fSubscribedChannels, firstChannelIndex,
+				fFrameByteBudget, fIsAggregating, fStatistics);
+		if (isBudgetExhausted)
+		{
+			fStatistics.BudgetExhaustedCount++;
+		}
+	}
+
+	// Hand the packets read this frame over to Lua.
+	if (!fBatchPointer->Packets.empty())
+	{
+		DispatchBatch();
+	}
+}
+
+bool P2PNetworking::PushPayloadTo(lua_State* luaStatePointer, const Batch& batch, size_t packetIndex)
+{
+	// Validate.
+	if (!luaStatePointer || (packetIndex >= batch.Packets.size()))
+	{
+		return false;
+	}
+
+	// Push the payload as a string, unless buffers were requested.
+	auto& packet = batch.Packets[packetIndex];
+	auto bytesPointer = batch.Bytes.data() + packet.ByteOffset;
+	if (!batch.IsUsingBuffers)
+	{
+		lua_pushlstring(luaStatePointer, bytesPointer, packet.ByteCount);
+		return true;
+	}
+
+	// Push the payload as a pooled buffer referencing the batch's arena.
+	auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
+	auto networkingPointer = contextPointer ? contextPointer->GetP2PNetworking() : nullptr;
+	if (!networkingPointer)
+	{
+		return false;
+	}
+	if (!networkingPointer->fBufferPoolPointer)
+	{
+		networkingPointer->fBufferPoolPointer.reset(new LuaBufferPool(contextPointer->GetMainLuaState()));
+	}
+	return networkingPointer->fBufferPoolPointer->PushTo(luaStatePointer, packetIndex, bytesPointer, packet.ByteCount);
+}
+
+bool P2PNetworking::ReadPackets(
+	galaxy::api::INetworking* networkingPointer, Batch& batch, const std::vector<uint8_t>& channels,
+	size_t firstChannelIndex, size_t byteBudget, bool isAggregated, Statistics& statistics)
+{
+	auto& bytes = batch.Bytes;
+	auto channelCount = channels.size();
+	for (size_t channelOffset = 0; channelOffset < channelCount; channelOffset++)
+	{
+		auto channel = channels[(firstChannelIndex + channelOffset) % channelCount];
+		uint32_t packetByteCount = 0;
+		while (networkingPointer->IsP2PPacketAvailable(&packetByteCount, channel))
+		{
+			// Leave the packet queued if it doesn't fit in what's left of the budget.
+			// Note: A packet bigger than the whole budget is read alone so that it does not block its channel.
+			auto byteOffset = bytes.size();
+			if (((byteOffset + packetByteCount) > byteBudget) && (byteOffset > 0))
+			{
+				return true;
+			}
+
+			// Have the SDK copy the packet straight into the arena.
+			// Note: At least 1 byte is reserved so that the SDK is never given a pointer past the end of the arena.
+			bytes.resize(byteOffset + (packetByteCount > 0 ? packetByteCount : 1));
+			uint32_t readByteCount = 0;
+			galaxy::api::GalaxyID senderId;
+			bool wasRead = networkingPointer->ReadP2PPacket(
+					bytes.data() + byteOffset, packetByteCount, &readByteCount, senderId, channel);
+			if (!wasRead)
+			{
+				bytes.resize(byteOffset);
+				break;
+			}
+			if (readByteCount > packetByteCount)
+			{
+				readByteCount = packetByteCount;
+			}
+			bytes.resize(byteOffset + readByteCount);
+
+			// Add the packet to the batch.
+			Packet packet;
+			packet.SenderId = senderId;
+			packet.Channel = channel;
+			packet.Stream = -1;
+			if (!isAggregated)
+			{
+				packet.ByteOffset = byteOffset;
+				packet.ByteCount = readByteCount;
+				batch.Packets.push_back(packet);
+				continue;
+			}
+
+			// Otherwise add each of the datagram's messages, leaving them in place within the arena.
+			// Note: The whole datagram is dropped if it is malformed.
+			auto packetCount = batch.Packets.size();
+			auto offset = byteOffset;
+			bool isValid = true;
+			while (offset < bytes.size())
+			{
+				uint64_t messageByteCount = 0;
+				if (!ReadVarint((const uint8_t*)bytes.data(), bytes.size(), &offset, &messageByteCount) ||
+				    (messageByteCount > (bytes.size() - offset)))
+				{
+					isValid = false;
+					break;
+				}
+				packet.ByteOffset = offset;
+				packet.ByteCount = (size_t)messageByteCount;
+				batch.Packets.push_back(packet);
+				offset += (size_t)messageByteCount;
+			}
+			if (!isValid)
+			{
+				batch.Packets.resize(packetCount);
+				bytes.resize(byteOffset);
+				statistics.UnpackDropCount++;
+			}
+		}
+	}
+	return false;
+}
+
+void P2PNetworking::AppendPackets(Batch& targetBatch, const Batch& sourceBatch)
+{
+	auto byteOffset = targetBatch.Bytes.size();
+	targetBatch.Bytes.insert(targetBatch.Bytes.end(), sourceBatch.Bytes.begin(), sourceBatch.Bytes.end());
+	for (auto&& packet : sourceBatch.Packets)
+	{
+		targetBatch.Packets.push_back(packet);
+		targetBatch.Packets.back().ByteOffset += byteOffset;
+	}
+}
+
+void P2PNetworking::DispatchBatch()
+{
+	// Count the received packets towards their peer's traffic, before any are exchanged for what they deliver.
+	for (auto&& packet : fBatchPointer->Packets)
+	{
+		auto& traffic = fPeerTrafficMap[packet.SenderId.ToUint64()][packet.Channel];
+		traffic.ReceivedCount++;
+		traffic.ReceivedByteCount += packet.ByteCount;
+	}
+
+	// Exchange the reliable and snapshot channels' packets for the messages and snapshots they deliver, if any.
+	fContext.GetP2PReliability()->Receive(*fBatchPointer);
+	fContext.GetSnapshotReplicator()->Receive(*fBatchPointer);
+	if (fBatchPointer->Packets.empty())
+	{
+		fBatchPointer->Bytes.clear();
+		return;
+	}
+
+	// Hand the batch over to a "p2pPackets" event.
+	fBatchPointer->IsUsingBuffers = fIsUsingBuffers;
+	fStatistics.ReceivedCount += fBatchPointer->Packets.size();
+	fStatistics.ReceivedByteCount += fBatchPointer->Bytes.size();
+	auto taskPointer = std::make_shared<DispatchP2PPacketsEventTask>();
+	taskPointer->AcquireEventDataFrom(fBatchPointer);
+	fContext.QueueDispatchEventTask(taskPointer);
+
+	// Collect the next packets into the previously dispatched batch, keeping its arena.
+	// Note: The spare batch is only still referenced if its event has not been dispatched yet.
+	fBatchPointer.swap(fSpareBatchPointer);
+	if (fBatchPointer && fBatchPointer.unique())
+	{
+		fBatchPointer->Packets.clear();
+		fBatchPointer->Bytes.clear();
+	}
+	else
+	{
+		fBatchPointer = std::make_shared<Batch>();
+		fBatchPointer->Bytes.reserve(fFrameByteBudget);
+	}
+}
+
+void P2PNetworking::SendQueuedPackets(galaxy::api::INetworking* networkingPointer, Statistics& statistics)
+{
+	bool isAggregating = fIsAggregating;
+	for (auto packetPointer = fSendQueuePointer->GetFront(); packetPointer; packetPointer = fSendQueuePointer->GetFront())
+	{
+		// Send the packet right away instead of on the main thread's next ProcessData() call.
+		auto sendType = ToImmediate(packetPointer->SendType);
+		auto& bytes = packetPointer->Bytes;
+		if (isAggregating && networkingPointer)
+		{
+			fWorkerAggregator.Add(
+					networkingPointer, packetPointer->UserId, bytes.data(), bytes.size(),
+					packetPointer->SendType, packetPointer->Channel, statistics);
+			fSendQueuePointer->Pop();
+			continue;
+		}
+		bool wasSent = networkingPointer && networkingPointer->SendP2PPacket(
+				packetPointer->UserId, bytes.data(), (uint32_t)bytes.size(), sendType, packetPointer->Channel);
+		if (wasSent)
+		{
+			statistics.SentCount++;
+			statistics.SentByteCount += bytes.size();
+		}
+		else
+		{
+			statistics.SendFailureCount++;
+		}
+		fSendQueuePointer->Pop();
+	}
+
+	// Send the datagrams packed from this drain of the queue right away.
+	if (networkingPointer)
+	{
+		fWorkerAggregator.Flush(networkingPointer, statistics);
+	}
+}
+
+void P2PNetworking::RunWorker()
+{
+	auto batchPointer = std::make_shared<Batch>();
+	std::vector<uint8_t> channels;
+	size_t byteBudget = 0;
+	size_t nextChannelIndex = 0;
+	Statistics statistics;
+	{
+		std::lock_guard<std::mutex> lock(fWorkerMutex);
+		channels = fSubscribedChannels;
+		byteBudget = fFrameByteBudget;
+	}
+	batchPointer->Bytes.reserve(byteBudget);
+
+	while (fIsWorkerRunning)
+	{
+		// Send the packets queued by Lua.
+		auto networkingPointer = galaxy::api::Networking();
+		SendQueuedPackets(networkingPointer, statistics);
+
+		// Read packets until drained, or until the batch is full if Process() has not taken the last one yet.
+		bool isBudgetExhausted = false;
+		if (networkingPointer && !channels.empty())
+		{
+			auto firstChannelIndex = nextChannelIndex % channels.size();
+			nextChannelIndex = firstChannelIndex + 1;
+			isBudgetExhausted = ReadPackets(
+					networkingPointer, *batchPointer, channels, firstChannelIndex, byteBudget, fIsAggregating, statistics);
+			if (isBudgetExhausted)
+			{
+				statistics.BudgetExhaustedCount++;
+			}
+		}
+
+		// Hand the batch and totals over to the main thread and pick up its latest settings.
+		std::unique_lock<std::mutex> lock(fWorkerMutex);
+		bool wasHandedOver = false;
+		if (!batchPointer->Packets.empty() && fReadyBatchPointer->Packets.empty())
+		{
+			batchPointer.swap(fReadyBatchPointer);
+			batchPointer->Packets.clear();
+			batchPointer->Bytes.clear();
+			wasHandedOver = true;
+		}
+		AddWorkerTotalsTo(fWorkerStatistics, statistics);
+		statistics = Statistics();
+		if (channels != fSubscribedChannels)
+		{
+			channels = fSubscribedChannels;
+		}
+		byteBudget = fFrameByteBudget;
+
+		// Keep reading if packets were left unread and there is room for them. Otherwise wait for sends.
+		// Note: A Send() racing this wait is at worst delayed by one poll interval.
+		if (!(isBudgetExhausted && wasHandedOver))
+		{
+			auto sendQueuePointer = fSendQueuePointer.get();
+			fWorkerCondition.wait_for(
+					lock, std::chrono::milliseconds(kWorkerPollIntervalInMilliseconds),
+					[this, sendQueuePointer]() { return !fIsWorkerRunning || sendQueuePointer->GetFront(); });
+		}
+	}
+
+	// Flush what's left and leave the packets read so far for Process() to dispatch.
+	SendQueuedPackets(galaxy::api::Networking(), statistics);
+	std::lock_guard<std::mutex> lock(fWorkerMutex);
+	AppendPackets(*fReadyBatchPointer, *batchPointer);
+	AddWorkerTotalsTo(fWorkerStatistics, statistics);
+}
+
+void P2PNetworking::StopWorker()
+{
+	// Do not continue if the worker is not running.
+	if (!fIsThreaded)
+	{
+		return;
+	}
+
+	// Stop the worker thread and wait for it to exit.
+	fIsWorkerRunning = false;
+	fWorkerCondition.notify_one();
+	if (fWorkerThread.joinable())
+	{
+		fWorkerThread.join();
+	}
+	fIsThreaded = false;
+
+	// Have Process() dispatch the packets the worker has read on the main thread's behalf.
+	AppendPackets(*fBatchPointer, *fReadyBatchPointer);
+	fReadyBatchPointer.reset();
+	AddWorkerTotalsTo(fStatistics, fWorkerStatistics);
+	fWorkerStatistics = Statistics();
+}
+
+
+//---------------------------------------------------------------------------------
+// P2PNetworking::Aggregator Class Members
+//---------------------------------------------------------------------------------
+
+P2PNetworking::Aggregator::Datagram::Datagram()
+:	SendType(galaxy::api::P2P_SEND_UNRELIABLE),
+	Channel(0),
+	MessageCount(0),
+	PayloadByteCount(0),
+	WasUsed(false)
+{
+}
+
+P2PNetworking::Aggregator::Aggregator(bool isSendingImmediately)
+:	fIsSendingImmediately(isSendingImmediately)
+{
+}
+
+bool P2PNetworking::Aggregator::Add(
+	galaxy::api::INetworking* networkingPointer, const galaxy::api::GalaxyID& userId,
+	const char* bytesPointer, size_t byteCount, galaxy::api::P2PSendType sendType,
+	uint8_t channel, Statistics& statistics)
+{
+	// Fetch the peer's datagram for the given channel and send type.
+	DatagramKey key(userId.ToUint64(), (uint16_t)((channel << 8) | ((int)sendType & 0xFF)));
+	auto& datagram = fDatagramMap[key];
+	if (!datagram.UserId.IsValid())
+	{
+		datagram.UserId = userId;
+		datagram.SendType = sendType;
+		datagram.Channel = channel;
+	}
+	datagram.WasUsed = true;
+
+	// Send the datagram first if the message doesn't fit in it.
+	// Note: A message too big to share a datagram is still given its own, so that receivers can unpack it.
+	bool wasSent = true;
+	auto packedByteCount = GetVarintByteCountOf(byteCount) + byteCount;
+	if ((datagram.Bytes.size() + packedByteCount) > kMaxDatagramByteCount)
+	{
+		wasSent = Send(networkingPointer, datagram, statistics);
+	}
+
+	// Pack the message.
+	WriteVarint(datagram.Bytes, byteCount);
+	datagram.Bytes.insert(datagram.Bytes.end(), bytesPointer, bytesPointer + byteCount);
+	datagram.MessageCount++;
+	datagram.PayloadByteCount += byteCount;
+
+	// Send the datagram now if the message is too big to wait for others or if it has to go out immediately.
+	if ((packedByteCount > kMaxDatagramByteCount) || IsImmediate(sendType))
+	{
+		wasSent = Send(networkingPointer, datagram, statistics) && wasSent;
+	}
+	return wasSent;
+}
+
+void P2PNetworking::Aggregator::Flush(galaxy::api::INetworking* networkingPointer, Statistics& statistics)
+{
+	for (auto iterator = fDatagramMap.begin(); iterator != fDatagramMap.end();)
+	{
+		auto& datagram = iterator->second;
+		if (!datagram.WasUsed)
+		{
+			iterator = fDatagramMap.erase(iterator);
+			continue;
+		}
+		Send(networkingPointer, datagram, statistics);
+		datagram.WasUsed = false;
+		++iterator;
+	}
+}
+
+bool P2PNetworking::Aggregator::Send(
+	galaxy::api::INetworking* networkingPointer, Datagram& datagram, Statistics& statistics)
+{
+	// Do not continue if the datagram is empty.
+	if (datagram.Bytes.empty())
+	{
+		return true;
+	}
+
+	// Send the datagram and empty it, keeping its capacity.
+	auto sendType = fIsSendingImmediately ? ToImmediate(datagram.SendType) : datagram.SendType;
+	bool wasSent = networkingPointer->SendP2PPacket(
+			datagram.UserId, datagram.Bytes.data(), (uint32_t)datagram.Bytes.size(), sendType, datagram.Channel);
+	if (wasSent)
+	{
+		statistics.SentCount += datagram.MessageCount;
+		statistics.SentByteCount += datagram.PayloadByteCount;
+		statistics.DatagramSentCount++;
+	}
+	else
+	{
+		statistics.SendFailureCount += datagram.MessageCount;
+	}
+	datagram.Bytes.clear();
+	datagram.MessageCount = 0;
+	datagram.PayloadByteCount = 0;
+	return wasSent;
+}
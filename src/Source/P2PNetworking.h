@@ -0,0 +1,622 @@
+// ----------------------------------------------------------------------------
+//
+// P2PNetworking.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "GalaxyApi.h"
+#include "PacketBufferPool.h"
+#include "SpscQueue.h"
+
+// Forward declarations.
+class LuaBufferPool;
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Sends P2P packets on behalf of Lua and pumps received P2P packets to Lua in per-frame batches.
+
+  Process() drains the subscribed channels via IsP2PPacketAvailable() and ReadP2PPacket(), which copies each packet
+  straight into the end of one preallocated byte arena shared by all packets read during a frame. It then dispatches
+  one "p2pPackets" event providing the frame's sender IDs, channels and payloads as parallel arrays. Payloads are
+  provided either as Lua strings or as pooled "plugin.gog.Buffer" userdata which read the arena in place.
+
+  Reading stops once the frame's byte budget is spent, leaving the remaining packets queued by the SDK for the
+  next frames. Channels are drained starting from a different channel every frame so that none is starved.
+
+  In threaded mode, a worker thread does the reading instead, polling every millisecond, and hands its batches
+  over to Process() which only dispatches them. Send() then queues packets to the worker via a lock-free
+  single producer/consumer queue and the worker sends them immediately, so that the latency between Lua's call
+  and the packet going out no longer depends on the frame rate. This relies on the Galaxy API being thread-safe.
+
+  With aggregation enabled, sent messages are packed per peer, channel and send type into datagrams of up to
+  kMaxDatagramByteCount bytes, each message prefixed by its varint length. Datagrams are sent when full, when
+  given an immediate message, and right before the next ProcessData() call (or after each drain of the queue in
+  threaded mode). Received datagrams are unpacked in place within the arena. All peers have to enable aggregation
+  since aggregated and plain packets cannot be told apart.
+
+  Sent packets can be scheduled by channel priority and rate limited per peer by a token bucket. A packet is sent
+  right away if its peer has tokens left and no packets of the same or a higher priority queued. Otherwise it is
+  queued and sent by Flush() once the peer's bucket has refilled, highest priority first. A peer's lower priority
+  packets are deferred for as long as it has higher priority packets queued. Low priority packets are always
+  deferred to the next Flush() so that the frame's other packets go out first. Scheduling happens on the main
+  thread, ahead of the aggregator and of the worker thread's queue.
+
+  The traffic exchanged with each peer is counted until no lobby is shared with the peer anymore.
+ */
+class P2PNetworking
+:	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener
+{
+	public:
+		/** Default number of bytes the pump may read per frame. */
+		static const size_t kDefaultFrameByteBudget;
+
+		/** Maximum number of packets queued to the worker thread by Send() in threaded mode. */
+		static const size_t kSendQueueCapacity;
+
+		/** Largest datagram packed by the aggregator. Chosen to fit a typical MTU along with UDP/IP headers. */
+		static const size_t kMaxDatagramByteCount;
+
+		/** Maximum number of bytes the scheduler may hold queued per peer before Send() rejects packets. */
+		static const size_t kMaxScheduledByteCountPerPeer;
+
+		/** Number of seconds worth of a peer's bandwidth its token bucket can hold, allowing short bursts. */
+		static const double kTokenBucketBurstInSeconds;
+
+		/** Priority class of a channel's sent packets. */
+		enum class SendPriority
+		{
+			kHigh,
+			kNormal,
+			kLow
+		};
+
+		/** One received packet within a batch. */
+		struct Packet
+		{
+			galaxy::api::GalaxyID SenderId;
+			uint8_t Channel;
+
+			/** The P2PReliability stream the message was delivered on. -1 if received as is. */
+			int Stream;
+
+			/** Offset of the packet's first byte within the batch's "Bytes". */
+			size_t ByteOffset;
+
+			/** Number of bytes in the packet. */
+			size_t ByteCount;
+		};
+
+		/** All packets read during one frame. */
+		struct Batch
+		{
+			Batch();
+
+			std::vector<Packet> Packets;
+
+			/** The arena holding the bytes of all packets, back to back. */
+			std::vector<char> Bytes;
+
+			/** Set true to provide payloads to Lua as buffers instead of strings. */
+			bool IsUsingBuffers;
+		};
+
+		/** Running totals of the pump's traffic. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of packets sent by Send(). With aggregation enabled, the number of messages sent in datagrams. */
+			uint64_t SentCount;
+
+			/** Number of datagrams sent by the aggregator. */
+			uint64_t DatagramSentCount;
+
+			/** Number of payload bytes sent by Send(). */
+			uint64_t SentByteCount;
+
+			/** Number of packets dispatched to Lua. */
+			uint64_t ReceivedCount;
+
+			/** Number of payload bytes dispatched to Lua. */
+			uint64_t ReceivedByteCount;
+
+			/** Number of frames which stopped reading with packets still available due to the byte budget. */
+			uint64_t BudgetExhaustedCount;
+
+			/** Number of packets the worker thread, in threaded mode, or the scheduler failed to send. */
+			uint64_t SendFailureCount;
+
+			/** Number of Send() calls rejected in threaded mode because the worker's queue was full. */
+			uint64_t SendQueueFullCount;
+
+			/** Number of received datagrams dropped because they could not be unpacked. */
+			uint64_t UnpackDropCount;
+
+			/** Number of packets the scheduler queued instead of sending right away. */
+			uint64_t DeferredCount;
+
+			/** Number of payload bytes the scheduler queued instead of sending right away. */
+			uint64_t DeferredByteCount;
+
+			/** Number of Send() calls rejected because the peer's scheduler queue was full. */
+			uint64_t ScheduleQueueFullCount;
+		};
+
+		/** Traffic exchanged with one peer on one channel. */
+		struct ChannelTraffic
+		{
+			ChannelTraffic();
+
+			/** Number of packets given to Send(), or messages with aggregation enabled. */
+			uint64_t SentCount;
+
+			/** Number of payload bytes given to Send(). */
+			uint64_t SentByteCount;
+
+			/** Number of packets received, before being handed to the reliability layer or snapshot replicator. */
+			uint64_t ReceivedCount;
+
+			/** Number of payload bytes received. */
+			uint64_t ReceivedByteCount;
+		};
+
+		/** Traffic exchanged with one peer, keyed by channel. */
+		typedef std::map<uint8_t, ChannelTraffic> PeerTraffic;
+
+		/**
+		  Creates a new P2P packet pump which is not subscribed to any channels.
+		  @param context The runtime context that will dispatch this pump's events to Lua.
+		 */
+		P2PNetworking(RuntimeContext& context);
+
+		virtual ~P2PNetworking();
+
+		/**
+		  Sends a packet to the given user.
+		  @param userId The user to send to.
+		  @param bytesPointer The packet's bytes.
+		  @param byteCount Number of bytes in the packet.
+		  @param sendType How the SDK should deliver the packet.
+		  @param channel The channel to send on.
+		  @return Returns true if the packet was sent, or queued to the worker thread in threaded mode.
+		          Returns false if given invalid arguments, if rejected by GOG or if the worker's queue is full.
+		 */
+		bool Send(
+				const galaxy::api::GalaxyID& userId, const char* bytesPointer, size_t byteCount,
+				galaxy::api::P2PSendType sendType, uint8_t channel);
+
+		/**
+		  Gets the priority class of the packets sent on the given channel.
+		  @param channel The channel.
+		  @return Returns the channel's priority. Channels default to SendPriority::kNormal.
+		 */
+		SendPriority GetChannelPriority(uint8_t channel) const;
+
+		/**
+		  Sets the priority class of the packets sent on the given channel.
+		  @param channel The channel.
+		  @param priority The priority to assign.
+		 */
+		void SetChannelPriority(uint8_t channel, SendPriority priority);
+
+		/** Gets the number of bytes per second each peer may be sent. Returns zero if unlimited. */
+		size_t GetPeerBytesPerSecond() const;
+
+		/**
+		  Sets the number of bytes per second each peer may be sent, enforced by a token bucket per peer.
+		  @param byteCount The bandwidth in bytes per second. Set to zero for no limit.
+		 */
+		void SetPeerBytesPerSecond(size_t byteCount);
+
+		/** Gets the number of bytes held by the scheduler's queues for all peers. */
+		size_t GetScheduledByteCount() const;
+
+		/**
+		  Fetches the number of packets and payload bytes the scheduler holds for the given peer.
+		  @param userId The peer.
+		  @param packetCount Set to the number of packets deferred for the peer, at all priorities.
+		  @param byteCount Set to the number of payload bytes in those packets.
+		 */
+		void GetScheduledCountsWith(const galaxy::api::GalaxyID& userId, size_t& packetCount, size_t& byteCount) const;
+
+		/**
+		  Gets the pool providing the buffers of packets held by the P2P path, such as deferred packets.
+		  Also used by the reliability layer for its pending and buffered messages. Only usable on the main thread.
+		  @return Returns the pool.
+		 */
+		PacketBufferPool& GetBufferPool();
+
+		/** Gets the statistics of the pool returned by GetBufferPool(). */
+		const PacketBufferPool::Statistics& GetBufferPoolStatistics() const;
+
+		/**
+		  Sets the channels whose packets are provided to Lua via "p2pPackets" events.
+		  Process() reads these along with the channels used by the P2PReliability and SnapshotReplicator.
+		  Packets on other channels are left queued by the SDK.
+		  @param channels The channels to provide to Lua. Duplicates are ignored.
+		 */
+		void SetUserChannels(const std::vector<uint8_t>& channels);
+
+		/** Gets the channels set via SetUserChannels(), sorted in ascending order. */
+		const std::vector<uint8_t>& GetUserChannels() const;
+
+		/**
+		  Re-subscribes to the user channels plus the current channels of the P2PReliability and SnapshotReplicator.
+		  Expected to be called by those subsystems whenever their channel changes.
+		 */
+		void UpdateSubscribedChannels();
+
+		/** Gets the channels read by Process(), sorted in ascending order, including the internal ones. */
+		const std::vector<uint8_t>& GetSubscribedChannels() const;
+
+		/** Gets the number of bytes Process() may read per frame. */
+		size_t GetFrameByteBudget() const;
+
+		/**
+		  Sets the number of bytes Process() may read per frame and preallocates the arenas accordingly.
+		  A packet bigger than the budget is still read, alone, so that it can never block its channel.
+		  @param byteCount The budget in bytes. Must be greater than zero.
+		 */
+		void SetFrameByteBudget(size_t byteCount);
+
+		/**
+		  Determines if received payloads are provided to Lua as "plugin.gog.Buffer" userdata.
+		  @return Returns true if payloads are provided as buffers. Returns false if they are provided as strings.
+		 */
+		bool IsUsingBuffers() const;
+
+		/**
+		  Sets whether received payloads are provided to Lua as "plugin.gog.Buffer" userdata or as strings.
+		  Buffers are only valid during the "p2pPackets" event they were provided by.
+		  @param value Set true to provide payloads as buffers. Set false to provide them as strings.
+		 */
+		void SetUsingBuffers(bool value);
+
+		/**
+		  Determines if packets are read and sent by a worker thread.
+		  @return Returns true if in threaded mode. Returns false if packets are read by Process() on the main thread.
+		 */
+		bool IsThreaded() const;
+
+		/**
+		  Starts or stops the worker thread reading and sending packets.
+		  Packets already read or queued when stopping it are still delivered.
+		  @param value Set true to start the worker thread. Set false to stop it.
+		 */
+		void SetThreaded(bool value);
+
+		/**
+		  Determines if small messages are packed into datagrams.
+		  @return Returns true if aggregation is enabled. Returns false if every Send() call sends one packet.
+		 */
+		bool IsAggregating() const;
+
+		/**
+		  Enables or disables packing small messages into datagrams, for both sent and received packets.
+		  Disabling it sends the datagrams being packed.
+		  @param value Set true to enable aggregation. Set false to disable it.
+		 */
+		void SetAggregating(bool value);
+
+		/**
+		  Sends the scheduler's queued packets that its token buckets allow, then the datagrams packed since the last
+		  call. Datagrams are packed and sent by the worker thread instead in threaded mode.
+		  Expected to be called once per frame right before galaxy::api::ProcessData() so that the packets go out
+		  with that call.
+		 */
+		void Flush();
+
+		/** Gets the pump's running totals. */
+		const Statistics& GetStatistics() const;
+
+		/**
+		  Fetches the traffic exchanged with the given peer since the pump was created, or since the peer was
+		  last forgotten for not sharing a lobby with the user anymore.
+		  @param userId The peer.
+		  @return Returns a pointer to the peer's traffic by channel. Returns null if nothing was exchanged with it.
+		 */
+		const PeerTraffic* GetTrafficWith(const galaxy::api::GalaxyID& userId) const;
+
+		/** Gets the traffic exchanged with every peer, keyed by GalaxyID::ToUint64(). */
+		const std::unordered_map<uint64_t, PeerTraffic>& GetPeerTrafficMap() const;
+
+		/**
+		  Gets the number of packets waiting in the worker thread's queue.
+		  @return Returns the number of queued packets, shared by all peers. Returns zero if not in threaded mode.
+		 */
+		size_t GetSendQueueCount() const;
+
+		/**
+		  Reads the subscribed channels' packets within the frame's byte budget and dispatches them to Lua.
+		  In threaded mode, dispatches the packets read by the worker thread instead.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		/**
+		  Pushes the payload of the given packet of a batch to Lua via the pump of the runtime context that
+		  owns the Lua state. Intended to be used by event tasks which only have access to a Lua state.
+		  @param luaStatePointer The Lua state to push to.
+		  @param batch The batch providing the packet.
+		  @param packetIndex Index of the packet within the batch.
+		  @return Returns true if a string or buffer was pushed to Lua. Returns false if nothing was pushed.
+		 */
+		static bool PushPayloadTo(lua_State* luaStatePointer, const Batch& batch, size_t packetIndex);
+
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		P2PNetworking(const P2PNetworking&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const P2PNetworking&) = delete;
+
+		/** Packs sent messages into datagrams. Owned and used by one thread only. */
+		class Aggregator
+		{
+			public:
+				/**
+				  Creates a new aggregator.
+				  @param isSendingImmediately Set true to send all datagrams with the immediate variant of their send type.
+				 */
+				Aggregator(bool isSendingImmediately);
+
+				/**
+				  Appends a message to its peer, channel and send type's datagram, sending the datagram first if full.
+				  Messages too big to share a datagram are sent alone, and immediate messages are sent right away.
+				  @return Returns false if the message or its preceding datagram was rejected by GOG.
+				 */
+				bool Add(
+						galaxy::api::INetworking* networkingPointer, const galaxy::api::GalaxyID& userId,
+						const char* bytesPointer, size_t byteCount, galaxy::api::P2PSendType sendType,
+						uint8_t channel, Statistics& statistics);
+
+				/** Sends all datagrams packed so far and forgets the peers that have been idle since the last call. */
+				void Flush(galaxy::api::INetworking* networkingPointer, Statistics& statistics);
+
+			private:
+				/** Copy constructor deleted to prevent it from being called. */
+				Aggregator(const Aggregator&) = delete;
+
+				/** Method deleted to prevent the copy operator from being used. */
+				void operator=(const Aggregator&) = delete;
+
+				struct Datagram
+				{
+					Datagram();
+
+					galaxy::api::GalaxyID UserId;
+					galaxy::api::P2PSendType SendType;
+					uint8_t Channel;
+
+					/** The length prefixed messages packed so far. */
+					std::vector<char> Bytes;
+
+					/** Number of messages packed so far. */
+					uint32_t MessageCount;
+
+					/** Number of message bytes packed so far, excluding length prefixes. */
+					size_t PayloadByteCount;
+
+					/** Set true if messages were packed since the last Flush() call. */
+					bool WasUsed;
+				};
+
+				/** Sends the given datagram, if not empty, and empties it. */
+				bool Send(galaxy::api::INetworking* networkingPointer, Datagram& datagram, Statistics& statistics);
+
+				/** Identifies a datagram by user GalaxyID::ToUint64() and by channel and send type. */
+				typedef std::pair<uint64_t, uint16_t> DatagramKey;
+
+				/** Datagrams being packed. Kept between flushes for as long as they are used, retaining their capacity. */
+				std::map<DatagramKey, Datagram> fDatagramMap;
+
+				/** Set true to send all datagrams with the immediate variant of their send type. */
+				bool fIsSendingImmediately;
+		};
+
+		/** A packet queued by Send() for the worker thread to send. */
+		struct OutgoingPacket
+		{
+			galaxy::api::GalaxyID UserId;
+			galaxy::api::P2PSendType SendType;
+			uint8_t Channel;
+			std::vector<char> Bytes;
+		};
+
+		/** A packet deferred by the scheduler. */
+		struct ScheduledPacket
+		{
+			galaxy::api::GalaxyID UserId;
+			galaxy::api::P2PSendType SendType;
+			uint8_t Channel;
+			PacketBufferPool::Buffer Bytes;
+		};
+
+		/** The scheduler's state of one peer. */
+		struct ScheduledPeer
+		{
+			ScheduledPeer();
+
+			/** Bytes the peer may be sent right now. Goes negative when a packet exceeds what was left. */
+			double TokenByteCount;
+
+			/** Time the tokens were last refilled. */
+			std::chrono::steady_clock::time_point RefillTime;
+
+			/** Deferred packets, indexed by SendPriority. */
+			std::vector<std::deque<ScheduledPacket>> Queues;
+
+			/** Number of payload bytes in all queues. */
+			size_t QueuedByteCount;
+		};
+
+		/**
+		  Sends a packet without scheduling it, or queues it to the worker thread in threaded mode.
+		  Takes the same arguments and returns the same result as Send().
+		 */
+		bool SendNow(
+				const galaxy::api::GalaxyID& userId, const char* bytesPointer, size_t byteCount,
+				galaxy::api::P2PSendType sendType, uint8_t channel);
+
+		/**
+		  Adds the tokens earned by the given peer since they were last refilled, up to the bucket's capacity.
+		  @param peer The peer whose bucket to refill.
+		  @param currentTime The current time.
+		 */
+		void RefillTokens(ScheduledPeer& peer, std::chrono::steady_clock::time_point currentTime) const;
+
+		/** Sends the queued packets that the token buckets allow and forgets the peers that no longer need tracking. */
+		void DrainScheduledPackets();
+
+		/**
+		  Reads the given channels' packets into the given batch until drained or until the byte budget is spent.
+		  @param networkingPointer The SDK's networking interface. Cannot be null.
+		  @param batch The batch to append the packets to.
+		  @param channels The channels to read. Cannot be empty.
+		  @param firstChannelIndex Index within "channels" of the channel to read first.
+		  @param byteBudget Maximum number of bytes the batch may hold, unless it holds one bigger packet.
+		  @param isAggregated Set true to unpack each packet's length prefixed messages into separate batch packets.
+		  @param statistics The totals to count dropped datagrams in.
+		  @return Returns true if packets were left unread due to the budget. Returns false if all channels were drained.
+		 */
+		static bool ReadPackets(
+				galaxy::api::INetworking* networkingPointer, Batch& batch, const std::vector<uint8_t>& channels,
+				size_t firstChannelIndex, size_t byteBudget, bool isAggregated, Statistics& statistics);
+
+		/**
+		  Appends the packets of one batch to another.
+		  @param targetBatch The batch to append to.
+		  @param sourceBatch The batch to copy the packets from.
+		 */
+		static void AppendPackets(Batch& targetBatch, const Batch& sourceBatch);
+
+		/**
+		  Has the context's P2PReliability replace the reliable channel's packets in "fBatchPointer" with the messages
+		  they deliver, then hands the batch over to a "p2pPackets" event and replaces it with an empty batch.
+		 */
+		void DispatchBatch();
+
+		/** Sends the worker thread's queued packets, immediately. To be called on the worker thread. */
+		void SendQueuedPackets(galaxy::api::INetworking* networkingPointer, Statistics& statistics);
+
+		/** The worker thread's entry point. */
+		void RunWorker();
+
+		/** Stops the worker thread, if running, and collects the packets it has read but not handed over yet. */
+		void StopWorker();
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Collects the packets read during the current frame. */
+		std::shared_ptr<Batch> fBatchPointer;
+
+		/** The previously dispatched batch, recycled once its event task has released it. */
+		std::shared_ptr<Batch> fSpareBatchPointer;
+
+		/** The channels Lua subscribed to, sorted in ascending order. */
+		std::vector<uint8_t> fUserChannels;
+
+		/** The channels to read, sorted in ascending order. The user channels plus the internal ones. */
+		std::vector<uint8_t> fSubscribedChannels;
+
+		/** Index within "fSubscribedChannels" of the channel to read first on the next frame. */
+		size_t fNextChannelIndex;
+
+		/** Number of bytes Process() may read per frame. */
+		size_t fFrameByteBudget;
+
+		/** The pump's running totals. */
+		Statistics fStatistics;
+
+		/** Provides the buffer userdata provided by "p2pPackets" events. Null until buffers are first used. */
+		std::unique_ptr<LuaBufferPool> fBufferPoolPointer;
+
+		/** Set true to provide payloads to Lua as buffers. */
+		bool fIsUsingBuffers;
+
+		/** Set true to pack sent messages into datagrams and unpack received ones. Read by the worker thread. */
+		std::atomic<bool> fIsAggregating;
+
+		/** Packs the messages sent on the main thread. */
+		Aggregator fAggregator;
+
+		/** Packs the messages sent by the worker thread. Only used by the worker thread. */
+		Aggregator fWorkerAggregator;
+
+		/** Set true while in threaded mode. */
+		bool fIsThreaded;
+
+		/** The thread reading and sending packets in threaded mode. */
+		std::thread fWorkerThread;
+
+		/** Set true while the worker thread is expected to keep running. */
+		std::atomic<bool> fIsWorkerRunning;
+
+		/** Packets queued by Send() for the worker thread. Null until threaded mode is first used. */
+		std::unique_ptr<SpscQueue<OutgoingPacket>> fSendQueuePointer;
+
+		/**
+		  Guards "fReadyBatchPointer", "fWorkerStatistics" and, in threaded mode,
+		  "fSubscribedChannels" and "fFrameByteBudget".
+		 */
+		std::mutex fWorkerMutex;
+
+		/** Wakes up the worker thread when packets are queued or when it should stop. */
+		std::condition_variable fWorkerCondition;
+
+		/** Packets read by the worker thread waiting for Process() to dispatch them. */
+		std::shared_ptr<Batch> fReadyBatchPointer;
+
+		/** Totals counted by the worker thread since Process() last added them to "fStatistics". */
+		Statistics fWorkerStatistics;
+
+		/** Provides the buffers of deferred packets. Declared ahead of its users so that it is destroyed last. */
+		PacketBufferPool fBufferPool;
+
+		/** Priority of each channel's sent packets, indexed by channel. */
+		std::vector<SendPriority> fChannelPriorities;
+
+		/** Number of bytes per second each peer may be sent. Zero if unlimited. */
+		size_t fPeerBytesPerSecond;
+
+		/** Set true if Send() has to go through the scheduler, ie: when rate limiting or using low priorities. */
+		bool fIsScheduling;
+
+		/** The scheduler's state of each peer with queued packets or spent tokens, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, ScheduledPeer> fScheduledPeerMap;
+
+		/** Number of bytes held by the scheduler's queues for all peers. */
+		size_t fScheduledByteCount;
+
+		/** Traffic exchanged with each peer, keyed by GalaxyID::ToUint64(). Only used by the main thread. */
+		std::unordered_map<uint64_t, PeerTraffic> fPeerTrafficMap;
+};
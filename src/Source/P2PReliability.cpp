@@ -0,0 +1,650 @@
+// --------------------------------------------------------------------------------
+//
+// P2PReliability.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "P2PReliability.h"
+#include "LobbyRoster.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <random>
+#include <string.h>
+
+
+const int P2PReliability::kStreamCount = 256;
+const uint16_t P2PReliability::kWindowSize = 1024;
+const int P2PReliability::kMinResendTimeoutInMilliseconds = 40;
+const int P2PReliability::kTimeoutInSeconds = 10;
+const int P2PReliability::kMaxResendCountPerProcess = 32;
+
+/** Resend timeout in milliseconds used until a peer's round trip time has been measured. */
+static const double kDefaultResendTimeoutInMilliseconds = 200.0;
+
+/** Maximum number of times a message's resend timeout is doubled. */
+static const int kMaxResendBackoffCount = 5;
+
+/** Packet header flag set if the packet acknowledges the peer's packets. */
+static const uint8_t kHasAckFlag = 0x01;
+
+/** Packet header flag set if the packet carries a message. */
+static const uint8_t kHasMessageFlag = 0x02;
+
+/**
+  Size of a packet's header: flags, the sender's and the receiver's 32-bit session IDs, then a 16-bit ack and
+  32-bit ack bitfield, all little endian. The receiver's session ID is zero if the sender does not know it yet.
+ */
+static const size_t kHeaderByteCount = 15;
+
+/** Size of a message's header: 16-bit packet sequence, 8-bit stream and 16-bit stream sequence. */
+static const size_t kMessageHeaderByteCount = 5;
+
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+/** Determines if the given sequence number is more recent than the other, allowing for wrap around. */
+static bool IsSequenceNewer(uint16_t sequence, uint16_t otherSequence)
+{
+	return (sequence != otherSequence) && ((uint16_t)(sequence - otherSequence) < 0x8000);
+}
+
+/** Generates a random non-zero session ID. */
+static uint32_t GenerateSessionId()
+{
+	static std::random_device sRandomDevice;
+	static std::mt19937 sRandomEngine(
+			sRandomDevice() ^ (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count());
+	uint32_t sessionId;
+	do
+	{
+		sessionId = (uint32_t)sRandomEngine();
+	}
+	while (0 == sessionId);
+	return sessionId;
+}
+
+/** Combines a stream and a stream sequence number into one key. */
+static uint32_t ToMessageKey(uint8_t stream, uint16_t streamSequence)
+{
+	return ((uint32_t)stream << 16) | streamSequence;
+}
+
+static uint16_t Read16(const uint8_t* bytesPointer)
+{
+	return (uint16_t)(bytesPointer[0] | (bytesPointer[1] << 8));
+}
+
+static uint32_t Read32(const uint8_t* bytesPointer)
+{
+	return (uint32_t)bytesPointer[0] | ((uint32_t)bytesPointer[1] << 8) |
+			((uint32_t)bytesPointer[2] << 16) | ((uint32_t)bytesPointer[3] << 24);
+}
+
+static void Write16(std::vector<char>& bytes, uint16_t value)
+{
+	bytes.push_back((char)(value & 0xFF));
+	bytes.push_back((char)(value >> 8));
+}
+
+static void Write32(std::vector<char>& bytes, uint32_t value)
+{
+	for (int byteIndex = 0; byteIndex < 4; byteIndex++)
+	{
+		bytes.push_back((char)((value >> (byteIndex * 8)) & 0xFF));
+	}
+}
+
+/** Appends a delivered message to the given batch, copying its bytes to the end of the batch's arena. */
+static void AppendMessageTo(
+	P2PNetworking::Batch& batch, const galaxy::api::GalaxyID& senderId, uint8_t channel, uint8_t stream,
+	const char* bytesPointer, size_t byteCount)
+{
+	P2PNetworking::Packet packet;
+	packet.SenderId = senderId;
+	packet.Channel = channel;
+	packet.Stream = stream;
+	packet.ByteOffset = batch.Bytes.size();
+	packet.ByteCount = byteCount;
+	batch.Bytes.resize(packet.ByteOffset + byteCount);
+	if (byteCount > 0)
+	{
+		memcpy(batch.Bytes.data() + packet.ByteOffset, bytesPointer, byteCount);
+	}
+	batch.Packets.push_back(packet);
+}
+
+
+//---------------------------------------------------------------------------------
+// P2PReliability Class Members
+//---------------------------------------------------------------------------------
+
+P2PReliability::Statistics::Statistics()
+:	SentCount(0),
+	ResendCount(0),
+	AckSentCount(0),
+	DeliveredCount(0),
+	DuplicateCount(0),
+	OutOfOrderCount(0),
+	TimeoutCount(0),
+	ResetCount(0)
+{
+}
+
+P2PReliability::SentPacket::SentPacket()
+:	Sequence(0),
+	IsPending(false),
+	MessageKey(0),
+	IsResend(false)
+{
+}
+
+P2PReliability::Peer::Peer()
+:	LocalSession(GenerateSessionId()),
+	RemoteSession(0),
+	RetiredRemoteSession(0),
+	NextPacketSequence(0),
+	NextStreamSequences(kStreamCount, 0),
+	SentPackets(kWindowSize),
+	HasReceived(false),
+	RemoteSequence(0),
+	RemoteAckBits(0),
+	IsAckDue(false),
+	OldestUnackedSequence(0),
+	NextDeliverySequences(kStreamCount, 0),
+	RoundTripMilliseconds(-1.0),
+	RoundTripVariationMilliseconds(-1.0),
+	ReceivedPacketCount(0),
+	LostPacketCount(0)
+{
+}
+
+P2PReliability::PeerStatistics::PeerStatistics()
+:	RoundTripMilliseconds(-1.0),
+	RoundTripVariationMilliseconds(-1.0),
+	ReceivedPacketCount(0),
+	LostPacketCount(0),
+	PendingMessageCount(0)
+{
+}
+
+P2PReliability::P2PReliability(RuntimeContext& context)
+:	fContext(context),
+	fChannel(-1)
+{
+}
+
+P2PReliability::~P2PReliability()
+{
+}
+
+int P2PReliability::GetChannel() const
+{
+	return fChannel;
+}
+
+void P2PReliability::SetChannel(int channel)
+{
+	if ((channel < -1) || (channel > 255))
+	{
+		return;
+	}
+	if (channel != fChannel)
+	{
+		fChannel = channel;
+		fPeerMap.clear();
+		fContext.GetP2PNetworking()->UpdateSubscribedChannels();
+	}
+}
+
+bool P2PReliability::Send(const galaxy::api::GalaxyID& userId, int stream, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if ((fChannel < 0) || !userId.IsValid() || (stream < 0) || (stream >= kStreamCount) || !bytesPointer)
+	{
+		return false;
+	}
+	if (byteCount > (UINT32_MAX - kHeaderByteCount - kMessageHeaderByteCount))
+	{
+		return false;
+	}
+
+	// Refuse the message if the peer has too many messages in-flight.
+	auto& peer = fPeerMap[userId.ToUint64()];
+	if (peer.PendingMessages.size() >= kWindowSize)
+	{
+		return false;
+	}
+
+	// Keep the message until acknowledged and send it.
+	// Note: A message rejected by GOG is retried by Process() like a lost one.
+	auto streamSequence = peer.NextStreamSequences[stream]++;
+	auto messageKey = ToMessageKey((uint8_t)stream, streamSequence);
+	auto& message = peer.PendingMessages[messageKey];
+	message.Stream = (uint8_t)stream;
+	message.StreamSequence = streamSequence;
+	message.Bytes.Assign(fContext.GetP2PNetworking()->GetBufferPool(), bytesPointer, byteCount);
+	message.FirstSendTime = std::chrono::steady_clock::now();
+	message.ResendCount = 0;
+	SendPacket(userId, peer, &message, messageKey, false);
+	fStatistics.SentCount++;
+	return true;
+}
+
+void P2PReliability::Receive(P2PNetworking::Batch& batch)
+{
+	// Do not continue if disabled.
+	if (fChannel < 0)
+	{
+		return;
+	}
+
+	// Move the reliable channel's packets out of the batch, keeping the other packets in order.
+	auto& packets = batch.Packets;
+	fReceivedPackets.clear();
+	size_t keptCount = 0;
+	for (size_t index = 0; index < packets.size(); index++)
+	{
+		if ((packets[index].Channel == (uint8_t)fChannel) && (packets[index].Stream < 0))
+		{
+			fReceivedPackets.push_back(packets[index]);
+		}
+		else
+		{
+			packets[keptCount++] = packets[index];
+		}
+	}
+	packets.resize(keptCount);
+
+	// Handle the packets, appending their deliverable messages to the batch.
+	// Note: The packets' bytes remain in place in the arena, but may be moved as messages are appended.
+	for (auto&& packet : fReceivedPackets)
+	{
+		ReceivePacket(packet.SenderId, packet.ByteOffset, packet.ByteCount, batch);
+	}
+}
+
+void P2PReliability::Process()
+{
+	// Do not continue if disabled.
+	if (fChannel < 0)
+	{
+		return;
+	}
+
+	auto currentTime = std::chrono::steady_clock::now();
+	for (auto peerIterator = fPeerMap.begin(); peerIterator != fPeerMap.end();)
+	{
+		galaxy::api::GalaxyID userId(peerIterator->first);
+		auto& peer = peerIterator->second;
+
+		// Forget the peer if it has stopped acknowledging messages, such as when it has left.
+		// Note: If the peer is still around, the new session of our next packet makes it start over along with us.
+		bool hasTimedOut = false;
+		for (auto&& pair : peer.PendingMessages)
+		{
+			if ((currentTime - pair.second.FirstSendTime) >= std::chrono::seconds(kTimeoutInSeconds))
+			{
+				hasTimedOut = true;
+				break;
+			}
+		}
+		if (hasTimedOut)
+		{
+			fStatistics.TimeoutCount++;
+			peerIterator = fPeerMap.erase(peerIterator);
+			continue;
+		}
+
+		// Resend the messages whose packets have not been acknowledged in time, backing off on every attempt.
+		// Note: The resends are capped per call so that a stalled peer is not flooded with its whole window at once.
+		double resendTimeout = kDefaultResendTimeoutInMilliseconds;
+		if (peer.RoundTripMilliseconds >= 0)
+		{
+			resendTimeout = (std::max)((double)kMinResendTimeoutInMilliseconds, peer.RoundTripMilliseconds * 1.5);
+		}
+		int resendCount = 0;
+		for (auto&& pair : peer.PendingMessages)
+		{
+			auto& message = pair.second;
+			auto backoffCount = (std::min)(message.ResendCount, kMaxResendBackoffCount);
+			auto resendDuration = std::chrono::microseconds((int64_t)(resendTimeout * 1000.0) << backoffCount);
+			if ((currentTime - message.LastSendTime) < resendDuration)
+			{
+				continue;
+			}
+			SendPacket(userId, peer, &message, pair.first, true);
+			message.ResendCount++;
+			fStatistics.ResendCount++;
+			if (++resendCount >= kMaxResendCountPerProcess)
+			{
+				break;
+			}
+		}
+
+		// Acknowledge received packets which no outgoing message has acknowledged yet.
+		if (peer.IsAckDue)
+		{
+			if (SendPacket(userId, peer, nullptr, 0, false))
+			{
+				fStatistics.AckSentCount++;
+			}
+		}
+		++peerIterator;
+	}
+}
+
+double P2PReliability::GetRoundTripTimeWith(const galaxy::api::GalaxyID& userId) const
+{
+	auto iterator = fPeerMap.find(userId.ToUint64());
+	return (iterator != fPeerMap.end()) ? iterator->second.RoundTripMilliseconds : -1.0;
+}
+
+bool P2PReliability::GetPeerStatisticsWith(const galaxy::api::GalaxyID& userId, PeerStatistics& statistics) const
+{
+	auto iterator = fPeerMap.find(userId.ToUint64());
+	if (iterator == fPeerMap.end())
+	{
+		return false;
+	}
+	auto& peer = iterator->second;
+	statistics.RoundTripMilliseconds = peer.RoundTripMilliseconds;
+	statistics.RoundTripVariationMilliseconds = peer.RoundTripVariationMilliseconds;
+	statistics.ReceivedPacketCount = peer.ReceivedPacketCount;
+	statistics.LostPacketCount = peer.LostPacketCount;
+	statistics.PendingMessageCount = peer.PendingMessages.size();
+	return true;
+}
+
+const P2PReliability::Statistics& P2PReliability::GetStatistics() const
+{
+	return fStatistics;
+}
+
+void P2PReliability::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	// Forget every peer we no longer share a lobby with, including peers which were never sent anything.
+	auto rosterPointer = fContext.GetLobbyRoster();
+	for (auto peerIterator = fPeerMap.begin(); peerIterator != fPeerMap.end();)
+	{
+		if (rosterPointer->IsSharingLobbyWith(galaxy::api::GalaxyID(peerIterator->first), lobbyID))
+		{
+			++peerIterator;
+		}
+		else
+		{
+			peerIterator = fPeerMap.erase(peerIterator);
+		}
+	}
+}
+
+void P2PReliability::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Forget a departed member, unless it is still reachable via another lobby, where its streams must carry on.
+	if (galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED == memberStateChange)
+	{
+		return;
+	}
+	if (!fContext.GetLobbyRoster()->IsSharingLobbyWith(memberID, lobbyID))
+	{
+		fPeerMap.erase(memberID.ToUint64());
+	}
+}
+
+bool P2PReliability::SendPacket(
+	const galaxy::api::GalaxyID& userId, Peer& peer, PendingMessage* messagePointer,
+	uint32_t messageKey, bool isResend)
+{
+	// Write the header, acknowledging the peer's packets.
+	fPacketBytes.clear();
+	uint8_t flags = (peer.HasReceived ? kHasAckFlag : 0) | (messagePointer ? kHasMessageFlag : 0);
+	fPacketBytes.push_back((char)flags);
+	Write32(fPacketBytes, peer.LocalSession);
+	Write32(fPacketBytes, peer.RemoteSession);
+	Write16(fPacketBytes, peer.RemoteSequence);
+	Write32(fPacketBytes, peer.RemoteAckBits);
+
+	// Write the message, under a new packet sequence number which has to be acknowledged.
+	// Note: A packet still pending a full window later is overwritten. Its message has been resent by now.
+	if (messagePointer)
+	{
+		auto currentTime = std::chrono::steady_clock::now();
+		auto sequence = peer.NextPacketSequence++;
+		auto& sentPacket = peer.SentPackets[sequence % kWindowSize];
+		sentPacket.Sequence = sequence;
+		sentPacket.IsPending = true;
+		sentPacket.MessageKey = messageKey;
+		sentPacket.IsResend = isResend;
+		sentPacket.SendTime = currentTime;
+		messagePointer->LastSendTime = currentTime;
+		Write16(fPacketBytes, sequence);
+		fPacketBytes.push_back((char)messagePointer->Stream);
+		Write16(fPacketBytes, messagePointer->StreamSequence);
+		auto messageBytesPointer = messagePointer->Bytes.GetBytes();
+		fPacketBytes.insert(
+				fPacketBytes.end(), messageBytesPointer, messageBytesPointer + messagePointer->Bytes.GetByteCount());
+	}
+
+	// Send the packet unreliably.
+	bool wasSent = fContext.GetP2PNetworking()->Send(
+			userId, fPacketBytes.data(), fPacketBytes.size(), galaxy::api::P2P_SEND_UNRELIABLE, (uint8_t)fChannel);
+	if (wasSent)
+	{
+		peer.IsAckDue = false;
+	}
+	return wasSent;
+}
+
+void P2PReliability::ReceivePacket(
+	const galaxy::api::GalaxyID& userId, size_t byteOffset, size_t byteCount, P2PNetworking::Batch& batch)
+{
+	// Validate.
+	if (!userId.IsValid() || (byteCount < kHeaderByteCount))
+	{
+		return;
+	}
+	auto bytesPointer = (const uint8_t*)batch.Bytes.data() + byteOffset;
+	auto flags = bytesPointer[0];
+	bool hasMessage = (flags & kHasMessageFlag) != 0;
+	if (hasMessage && (byteCount < (kHeaderByteCount + kMessageHeaderByteCount)))
+	{
+		return;
+	}
+	auto senderSession = Read32(bytesPointer + 1);
+	auto receiverSession = Read32(bytesPointer + 5);
+	if (0 == senderSession)
+	{
+		return;
+	}
+	auto& peer = fPeerMap[userId.ToUint64()];
+	if (senderSession == peer.RetiredRemoteSession)
+	{
+		return;
+	}
+
+	// If the peer has started a new session, its streams start over and it knows nothing of what we've sent.
+	// Start over too, but keep our session so that the peer does not reset in turn.
+	if (senderSession != peer.RemoteSession)
+	{
+		if (peer.RemoteSession != 0)
+		{
+			auto localSession = peer.LocalSession;
+			auto retiredSession = peer.RemoteSession;
+			peer = Peer();
+			peer.LocalSession = localSession;
+			peer.RetiredRemoteSession = retiredSession;
+			fStatistics.ResetCount++;
+		}
+		peer.RemoteSession = senderSession;
+	}
+
+	// Drop packets addressed to an earlier session of ours, since their sequence numbers belong to that session.
+	// Reply right away so that the peer learns our current session and starts over.
+	if ((receiverSession != 0) && (receiverSession != peer.LocalSession))
+	{
+		peer.IsAckDue = true;
+		return;
+	}
+
+	// Release the messages of the packets acknowledged by the peer.
+	if (flags & kHasAckFlag)
+	{
+		auto ack = Read16(bytesPointer + 9);
+		auto ackBits = Read32(bytesPointer + 11);
+		auto currentTime = std::chrono::steady_clock::now();
+		for (int bitIndex = -1; bitIndex < 32; bitIndex++)
+		{
+			if ((bitIndex >= 0) && !(ackBits & (1u << bitIndex)))
+			{
+				continue;
+			}
+			auto sequence = (uint16_t)(ack - (bitIndex + 1));
+			auto& sentPacket = peer.SentPackets[sequence % kWindowSize];
+			if (!sentPacket.IsPending || (sentPacket.Sequence != sequence))
+			{
+				continue;
+			}
+			sentPacket.IsPending = false;
+			auto messageIterator = peer.PendingMessages.find(sentPacket.MessageKey);
+			if (messageIterator == peer.PendingMessages.end())
+			{
+				continue;
+			}
+			if (!sentPacket.IsResend)
+			{
+				auto sample = std::chrono::duration<double, std::milli>(currentTime - sentPacket.SendTime).count();
+				// Note: Smoothed as per RFC 6298, updating the deviation with the previous round trip time.
+				if (peer.RoundTripMilliseconds < 0)
+				{
+					peer.RoundTripMilliseconds = sample;
+					peer.RoundTripVariationMilliseconds = sample * 0.5;
+				}
+				else
+				{
+					auto deviation = (sample > peer.RoundTripMilliseconds) ?
+							(sample - peer.RoundTripMilliseconds) : (peer.RoundTripMilliseconds - sample);
+					peer.RoundTripVariationMilliseconds += (deviation - peer.RoundTripVariationMilliseconds) * 0.25;
+					peer.RoundTripMilliseconds += (sample - peer.RoundTripMilliseconds) * 0.125;
+				}
+			}
+			peer.PendingMessages.erase(messageIterator);
+		}
+	}
+
+	// Do not continue if the packet only carried acknowledgements.
+	if (!hasMessage)
+	{
+		return;
+	}
+
+	// Parse the message.
+	auto messageHeaderPointer = bytesPointer + kHeaderByteCount;
+	auto sequence = Read16(messageHeaderPointer);
+	auto stream = messageHeaderPointer[2];
+	auto streamSequence = Read16(messageHeaderPointer + 3);
+	auto payloadOffset = byteOffset + kHeaderByteCount + kMessageHeaderByteCount;
+	auto payloadByteCount = byteCount - kHeaderByteCount - kMessageHeaderByteCount;
+
+	// Drop messages too far ahead of their stream without acknowledging them, so that they are resent later.
+	auto& nextDeliverySequence = peer.NextDeliverySequences[stream];
+	auto distance = (uint16_t)(streamSequence - nextDeliverySequence);
+	bool isDuplicate = (distance >= 0x8000);
+	if (!isDuplicate && (distance >= kWindowSize))
+	{
+		return;
+	}
+
+	// Deliver the message if it is the next one of its stream, followed by the buffered messages it unblocks.
+	// Otherwise buffer it, stalling only its own stream.
+	auto messageKey = ToMessageKey(stream, streamSequence);
+	if (isDuplicate || (peer.BufferedMessages.find(messageKey) != peer.BufferedMessages.end()))
+	{
+		fStatistics.DuplicateCount++;
+	}
+	else if (0 == distance)
+	{
+		auto channel = (uint8_t)fChannel;
+		batch.Bytes.reserve(batch.Bytes.size() + payloadByteCount);
+		AppendMessageTo(batch, userId, channel, stream, batch.Bytes.data() + payloadOffset, payloadByteCount);
+		fStatistics.DeliveredCount++;
+		nextDeliverySequence++;
+		for (;;)
+		{
+			auto bufferedIterator = peer.BufferedMessages.find(ToMessageKey(stream, nextDeliverySequence));
+			if (bufferedIterator == peer.BufferedMessages.end())
+			{
+				break;
+			}
+			auto& bufferedBytes = bufferedIterator->second;
+			AppendMessageTo(batch, userId, channel, stream, bufferedBytes.GetBytes(), bufferedBytes.GetByteCount());
+			peer.BufferedMessages.erase(bufferedIterator);
+			fStatistics.DeliveredCount++;
+			nextDeliverySequence++;
+		}
+	}
+	else if (peer.BufferedMessages.size() < kWindowSize)
+	{
+		auto payloadPointer = batch.Bytes.data() + payloadOffset;
+		peer.BufferedMessages[messageKey].Assign(
+				fContext.GetP2PNetworking()->GetBufferPool(), payloadPointer, payloadByteCount);
+		fStatistics.OutOfOrderCount++;
+	}
+	else
+	{
+		return;
+	}
+
+	// Acknowledge the packets received so far right away if this one would shift the oldest of them out of the
+	// ack bitfield before the next Process(), since it would then never be acknowledged and be resent for nothing.
+	if (peer.IsAckDue && peer.HasReceived && IsSequenceNewer(sequence, peer.OldestUnackedSequence) &&
+	    ((uint16_t)(sequence - peer.OldestUnackedSequence) > 32))
+	{
+		if (SendPacket(userId, peer, nullptr, 0, false))
+		{
+			fStatistics.AckSentCount++;
+		}
+	}
+
+	// Acknowledge the packet, counting the packets its sequence number skips as lost until they show up.
+	peer.ReceivedPacketCount++;
+	if (!peer.HasReceived)
+	{
+		peer.HasReceived = true;
+		peer.RemoteSequence = sequence;
+		peer.RemoteAckBits = 0;
+	}
+	else if (IsSequenceNewer(sequence, peer.RemoteSequence))
+	{
+		auto shift = (uint16_t)(sequence - peer.RemoteSequence);
+		peer.LostPacketCount += shift - 1;
+		peer.RemoteAckBits = (shift < 32) ? (peer.RemoteAckBits << shift) : 0;
+		if (shift <= 32)
+		{
+			peer.RemoteAckBits |= (1u << (shift - 1));
+		}
+		peer.RemoteSequence = sequence;
+	}
+	else
+	{
+		auto distanceBehind = (uint16_t)(peer.RemoteSequence - sequence);
+		if ((distanceBehind >= 1) && (distanceBehind <= 32))
+		{
+			if (!(peer.RemoteAckBits & (1u << (distanceBehind - 1))) && (peer.LostPacketCount > 0))
+			{
+				peer.LostPacketCount--;
+			}
+			peer.RemoteAckBits |= (1u << (distanceBehind - 1));
+		}
+	}
+	if (!peer.IsAckDue || IsSequenceNewer(peer.OldestUnackedSequence, sequence))
+	{
+		peer.OldestUnackedSequence = sequence;
+	}
+	peer.IsAckDue = true;
+}
@@ -0,0 +1,334 @@
+// ----------------------------------------------------------------------------
+//
+// P2PReliability.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "GalaxyApi.h"
+#include "P2PNetworking.h"
+#include "PacketBufferPool.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Lightweight reliability layer providing independent, reliable and ordered message streams on top of
+  unreliable P2P packets sent on one SDK channel.
+
+  Every packet carrying a message is given a per-peer sequence number, and every packet acknowledges the last
+  sequence number received from the peer along with a bitfield of the 32 before it. A packet is acknowledged
+  right away, instead of on the next Process(), if waiting would shift an unacknowledged packet out of the
+  bitfield. Messages whose packets are not acknowledged in time are resent alone in new packets, with their
+  resend timeout doubling on each attempt and a limited number of resends per peer per Process(). Received
+  messages are delivered in order per stream, so that a lost packet only stalls its own stream while the
+  others keep being delivered. A peer which has not acknowledged a message for kTimeoutInSeconds is forgotten,
+  as is a peer which no lobby is shared with anymore.
+
+  The state kept for each peer is tagged with a random session ID, which every packet carries along with the
+  receiver's session ID as known by the sender. When a peer's session changes, because it restarted, forgot us
+  after a timeout or changed channels, its streams start over. The receiver then resets its own state for
+  that peer, keeping its session ID, so that both sides number their streams from zero again. Packets
+  addressed to an earlier session of the receiver are dropped instead of being delivered against the wrong
+  sequence numbers.
+
+  Messages are delivered by the P2PNetworking's "p2pPackets" event, tagged with their stream.
+ */
+class P2PReliability
+:	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener
+{
+	public:
+		/** Number of streams multiplexed on the reliable channel. */
+		static const int kStreamCount;
+
+		/** Maximum number of unacknowledged packets and buffered out of order messages per peer. */
+		static const uint16_t kWindowSize;
+
+		/** Shortest time in milliseconds to wait for a packet's acknowledgement before resending its message. */
+		static const int kMinResendTimeoutInMilliseconds;
+
+		/** Number of seconds a message may remain unacknowledged before its peer is considered gone. */
+		static const int kTimeoutInSeconds;
+
+		/** Maximum number of messages resent to one peer per Process(). The others are resent on later calls. */
+		static const int kMaxResendCountPerProcess;
+
+		/** Running totals of the reliability layer's traffic. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of messages sent by Send(). */
+			uint64_t SentCount;
+
+			/** Number of times a message was resent. */
+			uint64_t ResendCount;
+
+			/** Number of packets sent only to acknowledge received packets. */
+			uint64_t AckSentCount;
+
+			/** Number of messages delivered to Lua. */
+			uint64_t DeliveredCount;
+
+			/** Number of received messages which had already been delivered. */
+			uint64_t DuplicateCount;
+
+			/** Number of received messages buffered until the messages before them in their stream are received. */
+			uint64_t OutOfOrderCount;
+
+			/** Number of peers forgotten after failing to acknowledge a message in time. */
+			uint64_t TimeoutCount;
+
+			/** Number of times a peer's state was reset because the peer started a new session. */
+			uint64_t ResetCount;
+		};
+
+		/** Connection quality measured with one peer. */
+		struct PeerStatistics
+		{
+			PeerStatistics();
+
+			/** Smoothed round trip time in milliseconds. Negative until first measured. */
+			double RoundTripMilliseconds;
+
+			/** Smoothed deviation of the round trip time in milliseconds, ie: jitter. Negative until first measured. */
+			double RoundTripVariationMilliseconds;
+
+			/** Number of packets carrying a message received from the peer. */
+			uint64_t ReceivedPacketCount;
+
+			/** Number of the peer's packets presumed lost, from the gaps in their sequence numbers. */
+			uint64_t LostPacketCount;
+
+			/** Number of messages sent to the peer which are awaiting acknowledgement. */
+			size_t PendingMessageCount;
+		};
+
+		/**
+		  Creates a new reliability layer, disabled until given a channel.
+		  @param context The runtime context providing the P2PNetworking to send and receive with.
+		 */
+		P2PReliability(RuntimeContext& context);
+
+		virtual ~P2PReliability();
+
+		/**
+		  Gets the SDK channel the reliable streams are multiplexed on.
+		  @return Returns the channel. Returns -1 if the reliability layer is disabled.
+		 */
+		int GetChannel() const;
+
+		/**
+		  Sets the SDK channel to multiplex the reliable streams on. Changing it forgets all peers.
+		  The P2PNetworking is told to subscribe to the new channel, and to drop the old one.
+		  @param channel The channel between 0 and 255. Set to -1 to disable the reliability layer.
+		 */
+		void SetChannel(int channel);
+
+		/**
+		  Sends a message on one of the reliable streams.
+		  @param userId The user to send to.
+		  @param stream The stream to send on, between 0 and kStreamCount - 1.
+		  @param bytesPointer The message's bytes.
+		  @param byteCount Number of bytes in the message.
+		  @return Returns true if the message was sent and will be resent until acknowledged.
+		          Returns false if disabled, if given invalid arguments or if too many messages are unacknowledged.
+		 */
+		bool Send(const galaxy::api::GalaxyID& userId, int stream, const char* bytesPointer, size_t byteCount);
+
+		/**
+		  To be called by the P2PNetworking before dispatching a batch. Removes the reliable channel's packets from
+		  the batch, processes their acknowledgements and appends the messages which can be delivered in order.
+		  @param batch The batch about to be dispatched to Lua.
+		 */
+		void Receive(P2PNetworking::Batch& batch);
+
+		/**
+		  Resends unacknowledged messages, sends pending acknowledgements and forgets peers which timed out.
+		  Expected to be called once per frame after the P2PNetworking has been processed.
+		 */
+		void Process();
+
+		/**
+		  Fetches the smoothed round trip time measured with the given peer.
+		  @param userId The peer.
+		  @return Returns the round trip time in milliseconds. Returns -1 if nothing was acknowledged by the peer yet.
+		 */
+		double GetRoundTripTimeWith(const galaxy::api::GalaxyID& userId) const;
+
+		/**
+		  Fetches the connection quality measured with the given peer.
+		  @param userId The peer.
+		  @param statistics Set to the peer's statistics. Left unchanged if the peer is unknown.
+		  @return Returns true if the statistics were fetched. Returns false if nothing was exchanged with the peer.
+		 */
+		bool GetPeerStatisticsWith(const galaxy::api::GalaxyID& userId, PeerStatistics& statistics) const;
+
+		/** Gets the reliability layer's running totals. */
+		const Statistics& GetStatistics() const;
+
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		P2PReliability(const P2PReliability&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const P2PReliability&) = delete;
+
+		/** A sent message awaiting acknowledgement. */
+		struct PendingMessage
+		{
+			uint8_t Stream;
+			uint16_t StreamSequence;
+
+			/** The message's payload, pooled by the P2PNetworking's buffer pool. */
+			PacketBufferPool::Buffer Bytes;
+
+			/** Time the message was first sent. */
+			std::chrono::steady_clock::time_point FirstSendTime;
+
+			/** Time the message was last sent. */
+			std::chrono::steady_clock::time_point LastSendTime;
+
+			/** Number of times the message was resent. Each resend doubles the time waited before the next one. */
+			int ResendCount;
+		};
+
+		/** A sent packet awaiting acknowledgement, stored in a ring indexed by its sequence number. */
+		struct SentPacket
+		{
+			SentPacket();
+
+			uint16_t Sequence;
+
+			/** Set true while the packet is awaiting acknowledgement. */
+			bool IsPending;
+
+			/** Key of the message carried by the packet within the peer's "PendingMessages". */
+			uint32_t MessageKey;
+
+			/** Set true if the packet resent its message, in which case it is not used to measure round trips. */
+			bool IsResend;
+
+			std::chrono::steady_clock::time_point SendTime;
+		};
+
+		/** Reliability state of one peer. */
+		struct Peer
+		{
+			Peer();
+
+			/** Random non-zero ID of this state, sent with every packet so that the peer can detect a reset. */
+			uint32_t LocalSession;
+
+			/** The peer's session ID. Zero until a packet has been received from the peer. */
+			uint32_t RemoteSession;
+
+			/** The peer's previous session ID. Its packets still in flight are dropped instead of causing a reset. */
+			uint32_t RetiredRemoteSession;
+
+			/** Sequence number of the next packet carrying a message. */
+			uint16_t NextPacketSequence;
+
+			/** Sequence number of the next message sent, per stream. */
+			std::vector<uint16_t> NextStreamSequences;
+
+			/** Packets awaiting acknowledgement, indexed by sequence number modulo kWindowSize. */
+			std::vector<SentPacket> SentPackets;
+
+			/** Messages awaiting acknowledgement, keyed by stream and stream sequence. */
+			std::map<uint32_t, PendingMessage> PendingMessages;
+
+			/** Set true once a packet carrying a message has been received from the peer. */
+			bool HasReceived;
+
+			/** Most recent sequence number received from the peer. */
+			uint16_t RemoteSequence;
+
+			/** Bit N is set if packet "RemoteSequence - N - 1" was received from the peer. */
+			uint32_t RemoteAckBits;
+
+			/** Set true if packets were received since the peer was last sent an acknowledgement. */
+			bool IsAckDue;
+
+			/** Oldest sequence number received since the peer was last sent an acknowledgement. */
+			uint16_t OldestUnackedSequence;
+
+			/** Sequence number of the next message to deliver, per stream. */
+			std::vector<uint16_t> NextDeliverySequences;
+
+			/** Messages received ahead of the next message to deliver, keyed by stream and stream sequence. */
+			std::unordered_map<uint32_t, PacketBufferPool::Buffer> BufferedMessages;
+
+			/** Smoothed round trip time in milliseconds. Negative until first measured. */
+			double RoundTripMilliseconds;
+
+			/** Smoothed deviation of the round trip time in milliseconds. Negative until first measured. */
+			double RoundTripVariationMilliseconds;
+
+			/** Number of packets carrying a message received from the peer. */
+			uint64_t ReceivedPacketCount;
+
+			/**
+			  Number of the peer's packets skipped by the sequence numbers received. Packets arriving late, while
+			  still within the ack bitfield, are taken back out of the count.
+			 */
+			uint64_t LostPacketCount;
+		};
+
+		/**
+		  Sends a packet to the given peer carrying its acknowledgements and, optionally, a message.
+		  @param userId The peer to send to.
+		  @param peer The peer's state.
+		  @param messagePointer The message to send. Set to null to only send acknowledgements.
+		  @param messageKey The message's key within the peer's "PendingMessages".
+		  @param isResend Set true if the message was sent before.
+		  @return Returns true if the packet was sent. Returns false if rejected by GOG.
+		 */
+		bool SendPacket(
+				const galaxy::api::GalaxyID& userId, Peer& peer, PendingMessage* messagePointer,
+				uint32_t messageKey, bool isResend);
+
+		/**
+		  Handles one packet received on the reliable channel.
+		  @param userId The peer who sent the packet.
+		  @param byteOffset Offset of the packet's first byte within the batch's arena.
+		  @param byteCount Number of bytes in the packet.
+		  @param batch The batch holding the packet, to append deliverable messages to.
+		 */
+		void ReceivePacket(
+				const galaxy::api::GalaxyID& userId, size_t byteOffset, size_t byteCount, P2PNetworking::Batch& batch);
+
+		/** The runtime context providing the P2PNetworking. */
+		RuntimeContext& fContext;
+
+		/** The SDK channel the streams are multiplexed on. -1 if disabled. */
+		int fChannel;
+
+		/** State of every peer messages were exchanged with, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, Peer> fPeerMap;
+
+		/** Reusable buffer which outgoing packets are written to. */
+		std::vector<char> fPacketBytes;
+
+		/** Reusable buffer which the reliable channel's packets are moved to while a batch is being filtered. */
+		std::vector<P2PNetworking::Packet> fReceivedPackets;
+
+		/** The reliability layer's running totals. */
+		Statistics fStatistics;
+};
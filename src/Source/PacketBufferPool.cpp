@@ -0,0 +1,185 @@
+// --------------------------------------------------------------------------------
+//
+// PacketBufferPool.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "PacketBufferPool.h"
+#include <algorithm>
+#include <string.h>
+
+
+const size_t PacketBufferPool::kMinBufferByteCount = 64;
+const size_t PacketBufferPool::kMaxBufferByteCount = 64 * 1024;
+const size_t PacketBufferPool::kSlabByteCount = 64 * 1024;
+
+
+//---------------------------------------------------------------------------------
+// PacketBufferPool::Buffer Class Members
+//---------------------------------------------------------------------------------
+
+PacketBufferPool::Buffer::Buffer()
+:	fPoolPointer(nullptr),
+	fBytesPointer(nullptr),
+	fByteCount(0)
+{
+}
+
+PacketBufferPool::Buffer::Buffer(Buffer&& buffer)
+:	fPoolPointer(buffer.fPoolPointer),
+	fBytesPointer(buffer.fBytesPointer),
+	fByteCount(buffer.fByteCount)
+{
+	buffer.fPoolPointer = nullptr;
+	buffer.fBytesPointer = nullptr;
+	buffer.fByteCount = 0;
+}
+
+PacketBufferPool::Buffer::~Buffer()
+{
+	Reset();
+}
+
+PacketBufferPool::Buffer& PacketBufferPool::Buffer::operator=(Buffer&& buffer)
+{
+	if (&buffer != this)
+	{
+		Reset();
+		fPoolPointer = buffer.fPoolPointer;
+		fBytesPointer = buffer.fBytesPointer;
+		fByteCount = buffer.fByteCount;
+		buffer.fPoolPointer = nullptr;
+		buffer.fBytesPointer = nullptr;
+		buffer.fByteCount = 0;
+	}
+	return *this;
+}
+
+void PacketBufferPool::Buffer::Assign(PacketBufferPool& pool, const char* bytesPointer, size_t byteCount)
+{
+	Reset();
+	if (0 == byteCount)
+	{
+		return;
+	}
+	fPoolPointer = &pool;
+	fBytesPointer = pool.Acquire(byteCount);
+	fByteCount = byteCount;
+	memcpy(fBytesPointer, bytesPointer, byteCount);
+}
+
+void PacketBufferPool::Buffer::Reset()
+{
+	if (fPoolPointer)
+	{
+		fPoolPointer->Release(fBytesPointer, fByteCount);
+	}
+	fPoolPointer = nullptr;
+	fBytesPointer = nullptr;
+	fByteCount = 0;
+}
+
+const char* PacketBufferPool::Buffer::GetBytes() const
+{
+	return fBytesPointer;
+}
+
+size_t PacketBufferPool::Buffer::GetByteCount() const
+{
+	return fByteCount;
+}
+
+
+//---------------------------------------------------------------------------------
+// PacketBufferPool Class Members
+//---------------------------------------------------------------------------------
+
+PacketBufferPool::Statistics::Statistics()
+:	HitCount(0),
+	MissCount(0),
+	InUseByteCount(0),
+	HighWaterByteCount(0),
+	SlabByteCount(0)
+{
+}
+
+PacketBufferPool::PacketBufferPool()
+:	fFreeLists(GetSizeClassIndexOf(kMaxBufferByteCount) + 1)
+{
+}
+
+PacketBufferPool::~PacketBufferPool()
+{
+}
+
+const PacketBufferPool::Statistics& PacketBufferPool::GetStatistics() const
+{
+	return fStatistics;
+}
+
+char* PacketBufferPool::Acquire(size_t byteCount)
+{
+	// Allocate buffers too big to be pooled on their own.
+	auto sizeClassIndex = GetSizeClassIndexOf(byteCount);
+	if (sizeClassIndex >= fFreeLists.size())
+	{
+		fStatistics.MissCount++;
+		fStatistics.InUseByteCount += byteCount;
+		fStatistics.HighWaterByteCount = (std::max)(fStatistics.HighWaterByteCount, fStatistics.InUseByteCount);
+		return new char[byteCount];
+	}
+
+	// Carve a new slab into buffers of the size class if it has none left.
+	auto bufferByteCount = kMinBufferByteCount << sizeClassIndex;
+	auto& freeList = fFreeLists[sizeClassIndex];
+	if (freeList.empty())
+	{
+		fStatistics.MissCount++;
+		fSlabs.emplace_back(new char[kSlabByteCount]);
+		fStatistics.SlabByteCount += kSlabByteCount;
+		auto slabPointer = fSlabs.back().get();
+		for (size_t offset = kSlabByteCount; offset >= bufferByteCount; offset -= bufferByteCount)
+		{
+			freeList.push_back(slabPointer + offset - bufferByteCount);
+		}
+	}
+	else
+	{
+		fStatistics.HitCount++;
+	}
+	auto bytesPointer = freeList.back();
+	freeList.pop_back();
+	fStatistics.InUseByteCount += bufferByteCount;
+	fStatistics.HighWaterByteCount = (std::max)(fStatistics.HighWaterByteCount, fStatistics.InUseByteCount);
+	return bytesPointer;
+}
+
+void PacketBufferPool::Release(char* bytesPointer, size_t byteCount)
+{
+	auto sizeClassIndex = GetSizeClassIndexOf(byteCount);
+	if (sizeClassIndex >= fFreeLists.size())
+	{
+		fStatistics.InUseByteCount -= byteCount;
+		delete[] bytesPointer;
+		return;
+	}
+	fStatistics.InUseByteCount -= kMinBufferByteCount << sizeClassIndex;
+	fFreeLists[sizeClassIndex].push_back(bytesPointer);
+}
+
+size_t PacketBufferPool::GetSizeClassIndexOf(size_t byteCount)
+{
+	size_t sizeClassIndex = 0;
+	for (auto bufferByteCount = kMinBufferByteCount; bufferByteCount < byteCount; bufferByteCount <<= 1)
+	{
+		sizeClassIndex++;
+		if (bufferByteCount > kMaxBufferByteCount)
+		{
+			break;
+		}
+	}
+	return sizeClassIndex;
+}
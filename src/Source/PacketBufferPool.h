@@ -0,0 +1,149 @@
+// ----------------------------------------------------------------------------
+//
+// PacketBufferPool.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+
+/**
+  Size-classed slab allocator for the P2P path's packet buffers, such as packets deferred by the send scheduler
+  and messages held by the reliability layer until acknowledged or delivered.
+
+  Buffers are rounded up to a power of two between kMinBufferByteCount and kMaxBufferByteCount and carved out of
+  slabs of kSlabByteCount bytes. Released buffers go back to their size class' free list to be reused by the next
+  buffer of that class, and slabs are never given back to the heap until the pool is destroyed, so that a long
+  session settles on a fixed set of slabs instead of fragmenting the heap. Buffers bigger than kMaxBufferByteCount
+  are allocated on the heap individually.
+
+  Not thread-safe. Only used by the main thread.
+ */
+class PacketBufferPool
+{
+	public:
+		/** Size of the smallest size class. */
+		static const size_t kMinBufferByteCount;
+
+		/** Size of the biggest size class. */
+		static const size_t kMaxBufferByteCount;
+
+		/** Number of bytes allocated at once for a size class whose free list has run out. */
+		static const size_t kSlabByteCount;
+
+		/** Running totals and gauges of the pool. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of buffers acquired from a free list. */
+			uint64_t HitCount;
+
+			/** Number of buffers which required allocating a new slab or an oversized heap buffer. */
+			uint64_t MissCount;
+
+			/** Number of bytes held by buffers in use, by size class capacity. */
+			size_t InUseByteCount;
+
+			/** Highest "InUseByteCount" reached. */
+			size_t HighWaterByteCount;
+
+			/** Number of bytes allocated by slabs. */
+			size_t SlabByteCount;
+		};
+
+		/** Move-only handle to a pooled buffer, released back to its pool when destroyed or reassigned. */
+		class Buffer
+		{
+			public:
+				/** Creates an empty buffer. */
+				Buffer();
+
+				Buffer(Buffer&& buffer);
+
+				~Buffer();
+
+				Buffer& operator=(Buffer&& buffer);
+
+				/**
+				  Replaces the buffer's contents with a copy of the given bytes.
+				  @param pool The pool to acquire the buffer from.
+				  @param bytesPointer The bytes to copy. Can be null if "byteCount" is zero.
+				  @param byteCount Number of bytes to copy.
+				 */
+				void Assign(PacketBufferPool& pool, const char* bytesPointer, size_t byteCount);
+
+				/** Releases the buffer back to its pool, leaving it empty. */
+				void Reset();
+
+				/** Gets a pointer to the buffer's bytes. Returns null if empty. */
+				const char* GetBytes() const;
+
+				/** Gets the number of bytes assigned to the buffer. */
+				size_t GetByteCount() const;
+
+			private:
+				/** Copy constructor deleted to prevent it from being called. */
+				Buffer(const Buffer&) = delete;
+
+				/** Method deleted to prevent the copy operator from being used. */
+				void operator=(const Buffer&) = delete;
+
+				/** The pool the bytes were acquired from. Null if empty. */
+				PacketBufferPool* fPoolPointer;
+
+				char* fBytesPointer;
+				size_t fByteCount;
+		};
+
+		PacketBufferPool();
+		virtual ~PacketBufferPool();
+
+		/** Gets the pool's running totals. */
+		const Statistics& GetStatistics() const;
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		PacketBufferPool(const PacketBufferPool&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const PacketBufferPool&) = delete;
+
+		/**
+		  Acquires a buffer able to hold the given number of bytes.
+		  @param byteCount Number of bytes needed. Must be greater than zero.
+		  @return Returns a pointer to the buffer.
+		 */
+		char* Acquire(size_t byteCount);
+
+		/**
+		  Releases a buffer acquired via Acquire().
+		  @param bytesPointer The buffer to release.
+		  @param byteCount The number of bytes given to Acquire().
+		 */
+		void Release(char* bytesPointer, size_t byteCount);
+
+		/**
+		  Gets the size class of the given buffer size.
+		  @param byteCount Number of bytes needed.
+		  @return Returns the index of the size class. Returns an index past the last class if too big to be pooled.
+		 */
+		static size_t GetSizeClassIndexOf(size_t byteCount);
+
+		/** Released buffers of each size class, ready to be reused. */
+		std::vector<std::vector<char*>> fFreeLists;
+
+		/** All slabs allocated by the pool. */
+		std::vector<std::unique_ptr<char[]>> fSlabs;
+
+		/** The pool's running totals. */
+		Statistics fStatistics;
+};
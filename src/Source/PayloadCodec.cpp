@@ -0,0 +1,531 @@
+// --------------------------------------------------------------------------------
+//
+// PayloadCodec.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "PayloadCodec.h"
+#include <chrono>
+#include <cstring>
+
+
+//---------------------------------------------------------------------------------
+// Constants
+//---------------------------------------------------------------------------------
+
+const uint8_t PayloadCodec::kRawFrameType = 0x00;
+const uint8_t PayloadCodec::kLz4FrameType = 0x01;
+const uint8_t PayloadCodec::kFragmentFrameType = 0x02;
+const uint8_t PayloadCodec::kControlFrameType = 0x03;
+const size_t PayloadCodec::kMinCompressibleByteCount = 32;
+const size_t PayloadCodec::kMaxDecodedByteCount = 1024 * 1024;
+
+/** Marker prefixed to lobby data values which have been compressed. Not part of the base64 alphabet. */
+static const char kEncodedValueMarker = '~';
+
+/** Number of bits used to index the LZ4 match finder's hash table. */
+static const int kHashBitCount = 12;
+
+/** Shortest match the LZ4 format can encode. */
+static const size_t kMinMatchByteCount = 4;
+
+/** The LZ4 format requires a block's last bytes to be literals. */
+static const size_t kLastLiteralByteCount = 5;
+
+/** The LZ4 format requires a block's last match to start at least this many bytes before the end. */
+static const size_t kMatchFindLimit = 12;
+
+/** Largest distance back to a match that the LZ4 format can encode. */
+static const size_t kMaxMatchOffset = 65535;
+
+static const char kBase64Characters[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+static uint32_t Read32(const uint8_t* bytesPointer)
+{
+	uint32_t value;
+	memcpy(&value, bytesPointer, sizeof(value));
+	return value;
+}
+
+static void WriteVarint(std::vector<char>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back((char)value);
+}
+
+static bool ReadVarint(const uint8_t* bytesPointer, size_t byteCount, size_t* offsetPointer, uint64_t* valuePointer)
+{
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (*offsetPointer >= byteCount)
+		{
+			return false;
+		}
+		auto nextByte = bytesPointer[(*offsetPointer)++];
+		value |= (uint64_t)(nextByte & 0x7F) << shift;
+		if (!(nextByte & 0x80))
+		{
+			*valuePointer = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Writes an LZ4 length's overflow bytes, following a token nibble of 15. */
+static void WriteLengthOverflow(std::vector<char>& block, size_t length)
+{
+	for (; length >= 255; length -= 255)
+	{
+		block.push_back((char)255);
+	}
+	block.push_back((char)length);
+}
+
+/** Reads an LZ4 length's overflow bytes and adds them to the given length. */
+static bool ReadLengthOverflow(const uint8_t* blockPointer, size_t blockByteCount, size_t* offsetPointer, size_t* lengthPointer)
+{
+	uint8_t nextByte;
+	do
+	{
+		if (*offsetPointer >= blockByteCount)
+		{
+			return false;
+		}
+		nextByte = blockPointer[(*offsetPointer)++];
+		*lengthPointer += nextByte;
+	} while (255 == nextByte);
+	return true;
+}
+
+/** Appends one LZ4 sequence. A zero "matchByteCount" writes the block's final literals-only sequence. */
+static void WriteSequence(
+	std::vector<char>& block, const uint8_t* literalsPointer, size_t literalByteCount,
+	size_t matchOffset, size_t matchByteCount)
+{
+	auto tokenIndex = block.size();
+	block.push_back(0);
+	uint8_t token = (uint8_t)((literalByteCount < 15 ? literalByteCount : 15) << 4);
+	if (literalByteCount >= 15)
+	{
+		WriteLengthOverflow(block, literalByteCount - 15);
+	}
+	block.insert(block.end(), (const char*)literalsPointer, (const char*)literalsPointer + literalByteCount);
+	if (matchByteCount > 0)
+	{
+		block.push_back((char)(matchOffset & 0xFF));
+		block.push_back((char)(matchOffset >> 8));
+		auto matchLength = matchByteCount - kMinMatchByteCount;
+		token |= (uint8_t)(matchLength < 15 ? matchLength : 15);
+		if (matchLength >= 15)
+		{
+			WriteLengthOverflow(block, matchLength - 15);
+		}
+	}
+	block[tokenIndex] = (char)token;
+}
+
+static void EncodeBase64(const char* bytesPointer, size_t byteCount, std::string& text)
+{
+	auto bytes = (const uint8_t*)bytesPointer;
+	size_t index = 0;
+	for (; (index + 3) <= byteCount; index += 3)
+	{
+		uint32_t value = ((uint32_t)bytes[index] << 16) | ((uint32_t)bytes[index + 1] << 8) | bytes[index + 2];
+		text.push_back(kBase64Characters[(value >> 18) & 0x3F]);
+		text.push_back(kBase64Characters[(value >> 12) & 0x3F]);
+		text.push_back(kBase64Characters[(value >> 6) & 0x3F]);
+		text.push_back(kBase64Characters[value & 0x3F]);
+	}
+
+	// Note: Padding is omitted since the text's length already determines the number of trailing bytes.
+	auto remainingByteCount = byteCount - index;
+	if (remainingByteCount > 0)
+	{
+		uint32_t value = (uint32_t)bytes[index] << 16;
+		if (remainingByteCount > 1)
+		{
+			value |= (uint32_t)bytes[index + 1] << 8;
+		}
+		text.push_back(kBase64Characters[(value >> 18) & 0x3F]);
+		text.push_back(kBase64Characters[(value >> 12) & 0x3F]);
+		if (remainingByteCount > 1)
+		{
+			text.push_back(kBase64Characters[(value >> 6) & 0x3F]);
+		}
+	}
+}
+
+static bool DecodeBase64(const char* text, std::vector<char>& bytes)
+{
+	bytes.clear();
+	uint32_t value = 0;
+	int bitCount = 0;
+	for (; *text != '\0'; text++)
+	{
+		auto characterPointer = strchr(kBase64Characters, *text);
+		if (!characterPointer)
+		{
+			return false;
+		}
+		value = (value << 6) | (uint32_t)(characterPointer - kBase64Characters);
+		bitCount += 6;
+		if (bitCount >= 8)
+		{
+			bitCount -= 8;
+			bytes.push_back((char)((value >> bitCount) & 0xFF));
+		}
+	}
+	return (bitCount < 6);
+}
+
+//---------------------------------------------------------------------------------
+// PayloadCodec Class Members
+//---------------------------------------------------------------------------------
+
+PayloadCodec::Statistics::Statistics()
+:	EncodeCount(0),
+	CompressedCount(0),
+	EncodeInputByteCount(0),
+	EncodeOutputByteCount(0),
+	EncodeMicroseconds(0),
+	DecodeCount(0),
+	DecodeFailureCount(0),
+	DecodeMicroseconds(0)
+{
+}
+
+PayloadCodec::PayloadCodec()
+:	fIsMessageFramingEnabled(false),
+	fIsDataCompressionEnabled(false)
+{
+}
+
+PayloadCodec::~PayloadCodec()
+{
+}
+
+bool PayloadCodec::IsMessageFramingEnabled() const
+{
+	return fIsMessageFramingEnabled;
+}
+
+void PayloadCodec::SetMessageFramingEnabled(bool value)
+{
+	fIsMessageFramingEnabled = value;
+}
+
+bool PayloadCodec::IsDataCompressionEnabled() const
+{
+	return fIsDataCompressionEnabled;
+}
+
+void PayloadCodec::SetDataCompressionEnabled(bool value)
+{
+	fIsDataCompressionEnabled = value;
+}
+
+const PayloadCodec::Statistics& PayloadCodec::GetStatistics() const
+{
+	return fStatistics;
+}
+
+void PayloadCodec::EncodeFrame(const char* bytesPointer, size_t byteCount, std::vector<char>& frame)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Attempt to compress the payload, giving up as soon as the frame would be no smaller than a raw frame.
+	frame.clear();
+	bool wasCompressed = false;
+	if (bytesPointer && (byteCount >= kMinCompressibleByteCount) && (byteCount <= kMaxDecodedByteCount))
+	{
+		frame.push_back((char)kLz4FrameType);
+		WriteVarint(frame, byteCount);
+		auto headerByteCount = frame.size();
+		wasCompressed = CompressBlock(bytesPointer, byteCount, frame, byteCount - headerByteCount);
+	}
+
+	// Otherwise send the payload raw.
+	if (!wasCompressed)
+	{
+		frame.clear();
+		frame.push_back((char)kRawFrameType);
+		if (bytesPointer)
+		{
+			frame.insert(frame.end(), bytesPointer, bytesPointer + byteCount);
+		}
+	}
+
+	fStatistics.EncodeCount++;
+	if (wasCompressed)
+	{
+		fStatistics.CompressedCount++;
+	}
+	fStatistics.EncodeInputByteCount += byteCount;
+	fStatistics.EncodeOutputByteCount += frame.size();
+	fStatistics.EncodeMicroseconds += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - startTime).count();
+}
+
+bool PayloadCodec::DecodeFrame(const char* framePointer, size_t frameByteCount, std::vector<char>& bytes)
+{
+	// Validate.
+	if (!framePointer || (frameByteCount < 1))
+	{
+		fStatistics.DecodeFailureCount++;
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	bool wasDecoded = false;
+	auto frameType = (uint8_t)framePointer[0];
+	if (kRawFrameType == frameType)
+	{
+		bytes.insert(bytes.end(), framePointer + 1, framePointer + frameByteCount);
+		wasDecoded = true;
+	}
+	else if (kLz4FrameType == frameType)
+	{
+		size_t offset = 1;
+		uint64_t byteCount = 0;
+		if (ReadVarint((const uint8_t*)framePointer, frameByteCount, &offset, &byteCount) &&
+		    (byteCount <= kMaxDecodedByteCount))
+		{
+			auto startIndex = bytes.size();
+			bytes.resize(startIndex + (size_t)byteCount);
+			wasDecoded = DecompressBlock(
+					framePointer + offset, frameByteCount - offset, bytes.data() + startIndex, (size_t)byteCount);
+			if (!wasDecoded)
+			{
+				bytes.resize(startIndex);
+			}
+		}
+	}
+
+	if (wasDecoded)
+	{
+		fStatistics.DecodeCount++;
+	}
+	else
+	{
+		fStatistics.DecodeFailureCount++;
+	}
+	fStatistics.DecodeMicroseconds += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - startTime).count();
+	return wasDecoded;
+}
+
+std::string PayloadCodec::EncodeValue(const char* value)
+{
+	// Validate.
+	if (!value)
+	{
+		return std::string();
+	}
+
+	// Write the value as is if compression is disabled.
+	if (!fIsDataCompressionEnabled)
+	{
+		return std::string(value);
+	}
+
+	// Compress the value if that makes it smaller, even after base64 encoding the compressed frame.
+	// Note: The frame's header byte is dropped since the value's marker already identifies it as compressed.
+	auto byteCount = strlen(value);
+	if (byteCount >= kMinCompressibleByteCount)
+	{
+		EncodeFrame(value, byteCount, fValueFrame);
+		if ((uint8_t)fValueFrame[0] == kLz4FrameType)
+		{
+			auto encodedByteCount = 1 + ((((fValueFrame.size() - 1) * 4) + 2) / 3);
+			if (encodedByteCount < byteCount)
+			{
+				std::string encodedValue(1, kEncodedValueMarker);
+				encodedValue.reserve(encodedByteCount);
+				EncodeBase64(fValueFrame.data() + 1, fValueFrame.size() - 1, encodedValue);
+				return encodedValue;
+			}
+		}
+	}
+
+	// Write the value uncompressed, escaping a leading marker by doubling it.
+	if (kEncodedValueMarker == value[0])
+	{
+		return std::string(1, kEncodedValueMarker) + value;
+	}
+	return std::string(value);
+}
+
+void PayloadCodec::DecodeValue(const char* value, std::string& decodedValue)
+{
+	// Validate.
+	if (!value)
+	{
+		decodedValue.clear();
+		return;
+	}
+
+	// Values without a marker were written as is.
+	if (!fIsDataCompressionEnabled || (value[0] != kEncodedValueMarker))
+	{
+		decodedValue = value;
+		return;
+	}
+
+	// Unescape values written with a doubled marker.
+	if (kEncodedValueMarker == value[1])
+	{
+		decodedValue = value + 1;
+		return;
+	}
+
+	// Decompress the value, restoring the frame header which was dropped by EncodeValue().
+	bool wasDecoded = DecodeBase64(value + 1, fValueBytes);
+	if (wasDecoded)
+	{
+		fValueFrame.clear();
+		fValueFrame.push_back((char)kLz4FrameType);
+		fValueFrame.insert(fValueFrame.end(), fValueBytes.begin(), fValueBytes.end());
+		fValueBytes.clear();
+		wasDecoded = DecodeFrame(fValueFrame.data(), fValueFrame.size(), fValueBytes);
+	}
+	else
+	{
+		fStatistics.DecodeFailureCount++;
+	}
+	if (wasDecoded)
+	{
+		decodedValue.assign(fValueBytes.data(), fValueBytes.size());
+	}
+	else
+	{
+		decodedValue = value;
+	}
+}
+
+bool PayloadCodec::CompressBlock(
+	const char* bytesPointer, size_t byteCount, std::vector<char>& block, size_t maxBlockByteCount)
+{
+	auto bytes = (const uint8_t*)bytesPointer;
+	auto blockStartIndex = block.size();
+
+	// Table entries store an input offset plus 1, so that zero indicates an empty entry.
+	fHashTable.assign((size_t)1 << kHashBitCount, 0);
+
+	// Greedily replace every 4 byte sequence seen before with a match.
+	size_t anchorIndex = 0;
+	size_t index = 0;
+	if (byteCount > kMatchFindLimit)
+	{
+		auto matchStartLimit = byteCount - kMatchFindLimit;
+		auto matchEndLimit = byteCount - kLastLiteralByteCount;
+		while (index < matchStartLimit)
+		{
+			auto sequence = Read32(bytes + index);
+			auto hash = (sequence * 2654435761U) >> (32 - kHashBitCount);
+			size_t candidateIndex = fHashTable[hash];
+			fHashTable[hash] = (uint32_t)index + 1;
+			if ((0 == candidateIndex) || ((index - (candidateIndex - 1)) > kMaxMatchOffset) ||
+			    (Read32(bytes + candidateIndex - 1) != sequence))
+			{
+				index++;
+				continue;
+			}
+
+			// Extend the match backwards over pending literals and forwards up to the end limit.
+			size_t matchIndex = candidateIndex - 1;
+			while ((index > anchorIndex) && (matchIndex > 0) && (bytes[index - 1] == bytes[matchIndex - 1]))
+			{
+				index--;
+				matchIndex--;
+			}
+			size_t matchByteCount = kMinMatchByteCount;
+			while (((index + matchByteCount) < matchEndLimit) &&
+			       (bytes[index + matchByteCount] == bytes[matchIndex + matchByteCount]))
+			{
+				matchByteCount++;
+			}
+
+			WriteSequence(block, bytes + anchorIndex, index - anchorIndex, index - matchIndex, matchByteCount);
+			if ((block.size() - blockStartIndex) > maxBlockByteCount)
+			{
+				return false;
+			}
+			index += matchByteCount;
+			anchorIndex = index;
+		}
+	}
+
+	// End the block with the remaining literals.
+	WriteSequence(block, bytes + anchorIndex, byteCount - anchorIndex, 0, 0);
+	return ((block.size() - blockStartIndex) <= maxBlockByteCount);
+}
+
+bool PayloadCodec::DecompressBlock(const char* blockPointer, size_t blockByteCount, char* bytesPointer, size_t byteCount)
+{
+	auto block = (const uint8_t*)blockPointer;
+	size_t blockIndex = 0;
+	size_t index = 0;
+	while (blockIndex < blockByteCount)
+	{
+		// Copy the sequence's literals.
+		auto token = block[blockIndex++];
+		size_t literalByteCount = token >> 4;
+		if ((15 == literalByteCount) && !ReadLengthOverflow(block, blockByteCount, &blockIndex, &literalByteCount))
+		{
+			return false;
+		}
+		if ((literalByteCount > (blockByteCount - blockIndex)) || (literalByteCount > (byteCount - index)))
+		{
+			return false;
+		}
+		memcpy(bytesPointer + index, block + blockIndex, literalByteCount);
+		blockIndex += literalByteCount;
+		index += literalByteCount;
+
+		// The last sequence has no match.
+		if (blockIndex >= blockByteCount)
+		{
+			break;
+		}
+
+		// Copy the sequence's match byte by byte, since it is allowed to overlap the bytes it produces.
+		if ((blockByteCount - blockIndex) < 2)
+		{
+			return false;
+		}
+		size_t matchOffset = (size_t)block[blockIndex] | ((size_t)block[blockIndex + 1] << 8);
+		blockIndex += 2;
+		if ((0 == matchOffset) || (matchOffset > index))
+		{
+			return false;
+		}
+		size_t matchByteCount = token & 0x0F;
+		if ((15 == matchByteCount) && !ReadLengthOverflow(block, blockByteCount, &blockIndex, &matchByteCount))
+		{
+			return false;
+		}
+		matchByteCount += kMinMatchByteCount;
+		if (matchByteCount > (byteCount - index))
+		{
+			return false;
+		}
+		for (size_t matchIndex = 0; matchIndex < matchByteCount; matchIndex++, index++)
+		{
+			bytesPointer[index] = bytesPointer[index - matchOffset];
+		}
+	}
+	return (index == byteCount);
+}
@@ -0,0 +1,179 @@
+// ----------------------------------------------------------------------------
+//
+// PayloadCodec.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+
+/**
+  Opt-in framing layer which transparently compresses lobby messages and lobby data values.
+
+  Framed lobby messages start with a one byte header identifying how the rest of the frame is encoded.
+  Payloads are compressed with an LZ4 block compatible codec when that makes the frame smaller and are
+  sent raw otherwise. Since lobby data values are strings, a compressed value is base64 encoded behind a
+  printable "~" marker instead. Values which are not compressed are written as is, so that they can still be
+  matched by lobby list filters, except that a value starting with the marker has it doubled.
+
+  Framing has to be enabled by all peers since framed and unframed payloads cannot be told apart.
+  Counts the bytes and the time spent encoding and decoding so that Lua can monitor the codec via gog.getStats().
+ */
+class PayloadCodec
+{
+	public:
+		/** Frame header of a payload sent uncompressed. */
+		static const uint8_t kRawFrameType;
+
+		/** Frame header of a compressed payload. Followed by the decoded size as a varint and an LZ4 block. */
+		static const uint8_t kLz4FrameType;
+
+		/**
+		  Frame header of one fragment of a frame too big for one lobby message. Fragments are handled by the
+		  LobbyMessenger and are never given to DecodeFrame().
+		 */
+		static const uint8_t kFragmentFrameType;
+
+		/**
+		  Frame header of a message exchanged between plugins rather than sent by Lua, such as a host election
+		  ping report. Followed by a one byte control type. Handled by the LobbyMessenger, never by DecodeFrame().
+		 */
+		static const uint8_t kControlFrameType;
+
+		/** Payloads smaller than this number of bytes are never compressed. */
+		static const size_t kMinCompressibleByteCount;
+
+		/** Largest decoded size accepted from a compressed frame, protecting against malicious frames. */
+		static const size_t kMaxDecodedByteCount;
+
+		/** Running totals of all encode and decode operations. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of payloads encoded. */
+			uint64_t EncodeCount;
+
+			/** Number of encoded payloads which were compressed. */
+			uint64_t CompressedCount;
+
+			/** Number of bytes given to be encoded. */
+			uint64_t EncodeInputByteCount;
+
+			/** Number of bytes produced by encoding, including headers. */
+			uint64_t EncodeOutputByteCount;
+
+			/** Microseconds spent encoding. */
+			uint64_t EncodeMicroseconds;
+
+			/** Number of payloads decoded. */
+			uint64_t DecodeCount;
+
+			/** Number of payloads which could not be decoded and were dropped. */
+			uint64_t DecodeFailureCount;
+
+			/** Microseconds spent decoding. */
+			uint64_t DecodeMicroseconds;
+		};
+
+		PayloadCodec();
+		virtual ~PayloadCodec();
+
+		/** Determines if lobby messages are framed. */
+		bool IsMessageFramingEnabled() const;
+
+		/** Enables or disables the framing of lobby messages. */
+		void SetMessageFramingEnabled(bool value);
+
+		/** Determines if lobby data values are compressed. */
+		bool IsDataCompressionEnabled() const;
+
+		/** Enables or disables the compression of lobby data values. */
+		void SetDataCompressionEnabled(bool value);
+
+		/** Gets the codec's running totals. */
+		const Statistics& GetStatistics() const;
+
+		/**
+		  Encodes the given payload into a frame.
+		  @param bytesPointer The payload to encode. Can be null if "byteCount" is zero.
+		  @param byteCount Number of bytes in the payload.
+		  @param frame The vector to write the frame to. Its previous contents are replaced, but its capacity is reused.
+		 */
+		void EncodeFrame(const char* bytesPointer, size_t byteCount, std::vector<char>& frame);
+
+		/**
+		  Decodes the given frame and appends its payload to the given vector.
+		  @param framePointer The frame to decode.
+		  @param frameByteCount Number of bytes in the frame.
+		  @param bytes The vector to append the decoded payload to. Left unchanged on failure.
+		  @return Returns true if the frame was decoded. Returns false if it is not a valid frame.
+		 */
+		bool DecodeFrame(const char* framePointer, size_t frameByteCount, std::vector<char>& bytes);
+
+		/**
+		  Encodes the given lobby data value if data compression is enabled.
+		  @param value The value to encode. Cannot be null.
+		  @return Returns the string to write to the lobby.
+		 */
+		std::string EncodeValue(const char* value);
+
+		/**
+		  Decodes the given lobby data value if data compression is enabled.
+		  @param value The value read from the lobby. Cannot be null.
+		  @param decodedValue Set to the decoded value. Set to the given value as is if it is not encoded
+		                      or if it cannot be decoded.
+		 */
+		void DecodeValue(const char* value, std::string& decodedValue);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		PayloadCodec(const PayloadCodec&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const PayloadCodec&) = delete;
+
+		/**
+		  Compresses the given bytes into an LZ4 block appended to the given vector.
+		  @param bytesPointer The bytes to compress.
+		  @param byteCount Number of bytes to compress.
+		  @param block The vector to append the block to.
+		  @param maxBlockByteCount Gives up once the block grows beyond this many bytes.
+		  @return Returns true if compressed. Returns false if the block would have been too big.
+		 */
+		bool CompressBlock(const char* bytesPointer, size_t byteCount, std::vector<char>& block, size_t maxBlockByteCount);
+
+		/**
+		  Decompresses the given LZ4 block.
+		  @param blockPointer The block to decompress.
+		  @param blockByteCount Number of bytes in the block.
+		  @param bytesPointer Buffer to decompress to.
+		  @param byteCount Exact number of bytes that the block is expected to decompress to.
+		  @return Returns true if decompressed. Returns false if the block is malformed.
+		 */
+		static bool DecompressBlock(const char* blockPointer, size_t blockByteCount, char* bytesPointer, size_t byteCount);
+
+		/** Set true if lobby messages are framed. */
+		bool fIsMessageFramingEnabled;
+
+		/** Set true if lobby data values are compressed. */
+		bool fIsDataCompressionEnabled;
+
+		/** The codec's running totals. */
+		Statistics fStatistics;
+
+		/** LZ4 match finder's hash table of input offsets, kept between calls to avoid reallocating it. */
+		std::vector<uint32_t> fHashTable;
+
+		/** Reusable buffers used to encode and decode lobby data values. */
+		std::vector<char> fValueFrame;
+		std::vector<char> fValueBytes;
+};
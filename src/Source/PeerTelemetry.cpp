@@ -0,0 +1,237 @@
+// --------------------------------------------------------------------------------
+//
+// PeerTelemetry.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "PeerTelemetry.h"
+#include "DispatchEventTask.h"
+#include "LuaGalaxyId.h"
+#include "RuntimeContext.h"
+#include <memory>
+#include <vector>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+/** Gets the number of packets sent to and received from a peer on all channels. */
+static uint64_t GetPacketCountOf(const P2PNetworking::PeerTraffic& traffic)
+{
+	uint64_t packetCount = 0;
+	for (auto&& pair : traffic)
+	{
+		packetCount += pair.second.SentCount + pair.second.ReceivedCount;
+	}
+	return packetCount;
+}
+
+
+//---------------------------------------------------------------------------------
+// PeerTelemetry Class Members
+//---------------------------------------------------------------------------------
+
+PeerTelemetry::PeerStatistics::PeerStatistics()
+:	Ping(-1),
+	ConnectionType(galaxy::api::CONNECTION_TYPE_NONE),
+	HasReliabilityStatistics(false),
+	ScheduledPacketCount(0),
+	ScheduledByteCount(0),
+	WorkerQueueCount(0)
+{
+}
+
+PeerTelemetry::PeerTelemetry(RuntimeContext& context)
+:	fContext(context),
+	fIntervalInSeconds(0)
+{
+}
+
+PeerTelemetry::~PeerTelemetry()
+{
+}
+
+void PeerTelemetry::GetStatisticsWith(const galaxy::api::GalaxyID& userId, PeerStatistics& statistics) const
+{
+	statistics = PeerStatistics();
+	statistics.UserId = userId;
+	auto networkingPointer = galaxy::api::Networking();
+	if (networkingPointer && userId.IsValid())
+	{
+		statistics.Ping = networkingPointer->GetPingWith(userId);
+		statistics.ConnectionType = networkingPointer->GetConnectionType(userId);
+	}
+	statistics.HasReliabilityStatistics =
+			fContext.GetP2PReliability()->GetPeerStatisticsWith(userId, statistics.Reliability);
+	fContext.GetP2PNetworking()->GetScheduledCountsWith(
+			userId, statistics.ScheduledPacketCount, statistics.ScheduledByteCount);
+	statistics.WorkerQueueCount = fContext.GetP2PNetworking()->GetSendQueueCount();
+	auto trafficPointer = fContext.GetP2PNetworking()->GetTrafficWith(userId);
+	if (trafficPointer)
+	{
+		statistics.Traffic = *trafficPointer;
+	}
+}
+
+double PeerTelemetry::GetIntervalInSeconds() const
+{
+	return fIntervalInSeconds;
+}
+
+void PeerTelemetry::SetIntervalInSeconds(double seconds)
+{
+	if (!(seconds >= 0))
+	{
+		return;
+	}
+	if ((seconds > 0) && (fIntervalInSeconds <= 0))
+	{
+		fLastDispatchTime = std::chrono::steady_clock::now();
+	}
+	fIntervalInSeconds = seconds;
+}
+
+void PeerTelemetry::Process()
+{
+	// Do not continue if disabled or if the interval has not elapsed yet.
+	if (fIntervalInSeconds <= 0)
+	{
+		return;
+	}
+	auto currentTime = std::chrono::steady_clock::now();
+	if ((currentTime - fLastDispatchTime) < std::chrono::duration<double>(fIntervalInSeconds))
+	{
+		return;
+	}
+	fLastDispatchTime = currentTime;
+
+	// Forget the packet counts of peers whose traffic the P2PNetworking has forgotten, since they left.
+	auto& peerTrafficMap = fContext.GetP2PNetworking()->GetPeerTrafficMap();
+	for (auto countIterator = fLastPacketCountMap.begin(); countIterator != fLastPacketCountMap.end();)
+	{
+		if (peerTrafficMap.find(countIterator->first) == peerTrafficMap.end())
+		{
+			countIterator = fLastPacketCountMap.erase(countIterator);
+		}
+		else
+		{
+			++countIterator;
+		}
+	}
+
+	// Gather the statistics of the peers which packets were exchanged with since the last event.
+	std::vector<PeerStatistics> peers;
+	for (auto&& pair : peerTrafficMap)
+	{
+		auto packetCount = GetPacketCountOf(pair.second);
+		auto& lastPacketCount = fLastPacketCountMap[pair.first];
+		if (packetCount == lastPacketCount)
+		{
+			continue;
+		}
+		lastPacketCount = packetCount;
+		peers.emplace_back();
+		GetStatisticsWith(galaxy::api::GalaxyID(pair.first), peers.back());
+	}
+	if (peers.empty())
+	{
+		return;
+	}
+
+	// Notify Lua.
+	auto taskPointer = std::make_shared<DispatchPeerStatsEventTask>();
+	taskPointer->AcquireEventDataFrom(peers);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void PeerTelemetry::PushStatisticsTo(lua_State* luaStatePointer, const PeerStatistics& statistics)
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return;
+	}
+
+	// Push the peer's totals over all channels, followed by a table of totals by channel.
+	lua_createtable(luaStatePointer, 0, 16);
+	PushGalaxyIdTo(luaStatePointer, statistics.UserId);
+	lua_setfield(luaStatePointer, -2, "userId");
+	lua_pushinteger(luaStatePointer, statistics.Ping);
+	lua_setfield(luaStatePointer, -2, "ping");
+	const char* connectionTypeName = "none";
+	if (galaxy::api::CONNECTION_TYPE_DIRECT == statistics.ConnectionType)
+	{
+		connectionTypeName = "direct";
+	}
+	else if (galaxy::api::CONNECTION_TYPE_PROXY == statistics.ConnectionType)
+	{
+		connectionTypeName = "proxy";
+	}
+	lua_pushstring(luaStatePointer, connectionTypeName);
+	lua_setfield(luaStatePointer, -2, "connectionType");
+	if (statistics.HasReliabilityStatistics)
+	{
+		auto& reliability = statistics.Reliability;
+		if (reliability.RoundTripMilliseconds >= 0)
+		{
+			lua_pushnumber(luaStatePointer, reliability.RoundTripMilliseconds);
+			lua_setfield(luaStatePointer, -2, "roundTripTime");
+			lua_pushnumber(luaStatePointer, reliability.RoundTripVariationMilliseconds);
+			lua_setfield(luaStatePointer, -2, "jitter");
+		}
+		auto expectedPacketCount = reliability.ReceivedPacketCount + reliability.LostPacketCount;
+		if (expectedPacketCount > 0)
+		{
+			lua_pushnumber(luaStatePointer, (double)reliability.LostPacketCount / (double)expectedPacketCount);
+			lua_setfield(luaStatePointer, -2, "loss");
+		}
+		lua_pushnumber(luaStatePointer, (double)reliability.LostPacketCount);
+		lua_setfield(luaStatePointer, -2, "lostCount");
+		lua_pushinteger(luaStatePointer, (lua_Integer)reliability.PendingMessageCount);
+		lua_setfield(luaStatePointer, -2, "pendingMessageCount");
+	}
+	lua_pushinteger(luaStatePointer, (lua_Integer)statistics.ScheduledPacketCount);
+	lua_setfield(luaStatePointer, -2, "scheduledCount");
+	lua_pushnumber(luaStatePointer, (double)statistics.ScheduledByteCount);
+	lua_setfield(luaStatePointer, -2, "scheduledBytes");
+	lua_pushinteger(luaStatePointer, (lua_Integer)statistics.WorkerQueueCount);
+	lua_setfield(luaStatePointer, -2, "workerQueueCount");
+	P2PNetworking::ChannelTraffic totals;
+	lua_createtable(luaStatePointer, 0, (int)statistics.Traffic.size());
+	for (auto&& pair : statistics.Traffic)
+	{
+		auto& traffic = pair.second;
+		totals.SentCount += traffic.SentCount;
+		totals.SentByteCount += traffic.SentByteCount;
+		totals.ReceivedCount += traffic.ReceivedCount;
+		totals.ReceivedByteCount += traffic.ReceivedByteCount;
+		lua_createtable(luaStatePointer, 0, 4);
+		lua_pushnumber(luaStatePointer, (double)traffic.SentCount);
+		lua_setfield(luaStatePointer, -2, "sentCount");
+		lua_pushnumber(luaStatePointer, (double)traffic.SentByteCount);
+		lua_setfield(luaStatePointer, -2, "sentBytes");
+		lua_pushnumber(luaStatePointer, (double)traffic.ReceivedCount);
+		lua_setfield(luaStatePointer, -2, "receivedCount");
+		lua_pushnumber(luaStatePointer, (double)traffic.ReceivedByteCount);
+		lua_setfield(luaStatePointer, -2, "receivedBytes");
+		lua_rawseti(luaStatePointer, -2, (int)pair.first);
+	}
+	lua_setfield(luaStatePointer, -2, "channels");
+	lua_pushnumber(luaStatePointer, (double)totals.SentCount);
+	lua_setfield(luaStatePointer, -2, "sentCount");
+	lua_pushnumber(luaStatePointer, (double)totals.SentByteCount);
+	lua_setfield(luaStatePointer, -2, "sentBytes");
+	lua_pushnumber(luaStatePointer, (double)totals.ReceivedCount);
+	lua_setfield(luaStatePointer, -2, "receivedCount");
+	lua_pushnumber(luaStatePointer, (double)totals.ReceivedByteCount);
+	lua_setfield(luaStatePointer, -2, "receivedBytes");
+}
@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+//
+// PeerTelemetry.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include "GalaxyApi.h"
+#include "P2PNetworking.h"
+#include "P2PReliability.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Gathers per-peer connection statistics from the P2P layer for gog.getPeerStats() and the "peerStats" event.
+
+  Combines the traffic counted per channel by the P2PNetworking, the round trip time, jitter, loss and
+  pending messages measured by the P2PReliability, and the ping and connection type reported by the SDK.
+  Measurements only available via the reliability layer are omitted for peers it has not exchanged with.
+
+  When given an interval, Process() periodically dispatches one "peerStats" event providing the statistics
+  of every peer which packets were exchanged with during the interval.
+ */
+class PeerTelemetry
+{
+	public:
+		/** Connection statistics of one peer at one point in time. */
+		struct PeerStatistics
+		{
+			PeerStatistics();
+
+			galaxy::api::GalaxyID UserId;
+
+			/** Ping in milliseconds reported by the SDK. Negative if unknown. */
+			int Ping;
+
+			/** How the SDK is connected to the peer. */
+			galaxy::api::ConnectionType ConnectionType;
+
+			/** Set true if the statistics measured by the reliability layer are provided. */
+			bool HasReliabilityStatistics;
+
+			/** Statistics measured by the reliability layer. */
+			P2PReliability::PeerStatistics Reliability;
+
+			/** Number of packets the P2PNetworking's scheduler has deferred for the peer. */
+			size_t ScheduledPacketCount;
+
+			/** Number of payload bytes the P2PNetworking's scheduler has deferred for the peer. */
+			size_t ScheduledByteCount;
+
+			/**
+			  Number of packets waiting in the worker thread's send queue. Not specific to the peer, since the
+			  queue is shared by all peers, but provided along with its statistics to tell where packets wait.
+			 */
+			size_t WorkerQueueCount;
+
+			/** Traffic exchanged with the peer by channel. */
+			P2PNetworking::PeerTraffic Traffic;
+		};
+
+		/**
+		  Creates a new telemetry gatherer which does not dispatch events until given an interval.
+		  @param context The runtime context providing the P2P layer and dispatching events to Lua.
+		 */
+		PeerTelemetry(RuntimeContext& context);
+
+		virtual ~PeerTelemetry();
+
+		/**
+		  Fetches the given peer's current statistics.
+		  @param userId The peer.
+		  @param statistics Set to the peer's statistics.
+		 */
+		void GetStatisticsWith(const galaxy::api::GalaxyID& userId, PeerStatistics& statistics) const;
+
+		/** Gets the number of seconds between "peerStats" events. Returns zero if disabled. */
+		double GetIntervalInSeconds() const;
+
+		/**
+		  Sets how often "peerStats" events are dispatched.
+		  @param seconds The number of seconds between events. Set to zero to disable the events.
+		 */
+		void SetIntervalInSeconds(double seconds);
+
+		/**
+		  Dispatches a "peerStats" event if the interval has elapsed.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		/**
+		  Pushes the given statistics to the top of the Lua stack as a new table.
+		  @param luaStatePointer The Lua state to push to.
+		  @param statistics The statistics to push.
+		 */
+		static void PushStatisticsTo(lua_State* luaStatePointer, const PeerStatistics& statistics);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		PeerTelemetry(const PeerTelemetry&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const PeerTelemetry&) = delete;
+
+		/** The runtime context providing the P2P layer. */
+		RuntimeContext& fContext;
+
+		/** Number of seconds between "peerStats" events. Zero if disabled. */
+		double fIntervalInSeconds;
+
+		/** Time the last "peerStats" event was queued, or events were enabled. */
+		std::chrono::steady_clock::time_point fLastDispatchTime;
+
+		/** Number of packets exchanged with each peer as of the last event, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, uint64_t> fLastPacketCountMap;
+};
@@ -0,0 +1,104 @@
+// --------------------------------------------------------------------------------
+//
+// PersonaNameCache.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "PersonaNameCache.h"
+#include "RuntimeContext.h"
+
+extern "C"
+{
+#	include "lua.h"
+#	include "lauxlib.h"
+}
+
+
+PersonaNameCache::PersonaNameCache(lua_State* luaStatePointer)
+:	fLuaStatePointer(luaStatePointer)
+{
+}
+
+PersonaNameCache::~PersonaNameCache()
+{
+	if (fLuaStatePointer)
+	{
+		for (auto&& pair : fLuaReferenceIdMap)
+		{
+			luaL_unref(fLuaStatePointer, LUA_REGISTRYINDEX, pair.second);
+		}
+	}
+	fLuaReferenceIdMap.clear();
+}
+
+bool PersonaNameCache::PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId)
+{
+	// Validate.
+	if (!luaStatePointer || !userId.IsValid())
+	{
+		return false;
+	}
+
+	// Push the interned string if we have one.
+	auto iterator = fLuaReferenceIdMap.find(userId.ToUint64());
+	if (iterator != fLuaReferenceIdMap.end())
+	{
+		lua_rawgeti(luaStatePointer, LUA_REGISTRYINDEX, iterator->second);
+		return true;
+	}
+
+	// Do not intern anything until GOG has the user's information. Its name would be empty until then.
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer || !friendsPointer->IsUserInformationAvailable(userId))
+	{
+		return false;
+	}
+
+	// Copy the name out of the SDK, push it, and intern it via the Lua registry.
+	char personaName[256] = { 0 };
+	friendsPointer->GetFriendPersonaNameCopy(userId, personaName, sizeof(personaName));
+	lua_pushstring(luaStatePointer, personaName);
+	lua_pushvalue(luaStatePointer, -1);
+	int referenceId = luaL_ref(luaStatePointer, LUA_REGISTRYINDEX);
+	if ((referenceId != LUA_REFNIL) && (referenceId != LUA_NOREF))
+	{
+		fLuaReferenceIdMap[userId.ToUint64()] = referenceId;
+	}
+	return true;
+}
+
+bool PersonaNameCache::PushPersonaNameTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId)
+{
+	auto contextPointer = RuntimeContext::GetInstanceBy(luaStatePointer);
+	if (!contextPointer || !contextPointer->GetPersonaNameCache())
+	{
+		return false;
+	}
+	return contextPointer->GetPersonaNameCache()->PushTo(luaStatePointer, userId);
+}
+
+void PersonaNameCache::Invalidate(const galaxy::api::GalaxyID& userId)
+{
+	auto iterator = fLuaReferenceIdMap.find(userId.ToUint64());
+	if (iterator == fLuaReferenceIdMap.end())
+	{
+		return;
+	}
+	if (fLuaStatePointer)
+	{
+		luaL_unref(fLuaStatePointer, LUA_REGISTRYINDEX, iterator->second);
+	}
+	fLuaReferenceIdMap.erase(iterator);
+}
+
+void PersonaNameCache::OnPersonaDataChanged(galaxy::api::GalaxyID userID, uint32_t personaStateChange)
+{
+	// Only name changes affect us. Avatar changes are far more frequent and are ignored.
+	if (personaStateChange & galaxy::api::IPersonaDataChangedListener::PERSONA_CHANGE_NAME)
+	{
+		Invalidate(userID);
+	}
+}
@@ -0,0 +1,85 @@
+// ----------------------------------------------------------------------------
+//
+// PersonaNameCache.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <unordered_map>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Interns user persona names as Lua strings.
+
+  The first time a user's name is pushed to Lua, it is copied out of the GOG SDK into a Lua string which is
+  then referenced by the Lua registry. All later pushes of the same user's name reuse that Lua string instead
+  of making an SDK call and allocating a new string. A user's entry is released when GOG reports that the
+  user's persona name has changed.
+
+  All plugin events and getters which provide a user's persona name are expected to push it via this class.
+ */
+class PersonaNameCache : public galaxy::api::GlobalPersonaDataChangedListener
+{
+	public:
+		/**
+		  Creates a new cache.
+		  @param luaStatePointer The main Lua state that the interned strings will be referenced in.
+		 */
+		PersonaNameCache(lua_State* luaStatePointer);
+
+		/** Releases all interned strings from the Lua registry. */
+		virtual ~PersonaNameCache();
+
+		/**
+		  Pushes the given user's persona name to the top of the Lua stack.
+		  @param luaStatePointer The Lua state to push to. Must be the cache's Lua state or one of its coroutines.
+		  @param userId The user whose persona name should be pushed.
+		  @return Returns true if the name was pushed to Lua.
+
+		          Returns false if GOG does not have the user's information yet, in which case nothing is pushed.
+		          The information can be fetched via the UserInformationScheduler.
+		 */
+		bool PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId);
+
+		/**
+		  Pushes the given user's persona name to Lua via the cache of the runtime context that owns the Lua state.
+		  Intended to be used by event tasks which only have access to a Lua state.
+		  @param luaStatePointer The Lua state to push to.
+		  @param userId The user whose persona name should be pushed.
+		  @return Returns true if the name was pushed to Lua. Returns false if nothing was pushed.
+		 */
+		static bool PushPersonaNameTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId);
+
+		/**
+		  Releases the given user's interned name, if any.
+		  @param userId The user whose name has changed.
+		 */
+		void Invalidate(const galaxy::api::GalaxyID& userId);
+
+		virtual void OnPersonaDataChanged(galaxy::api::GalaxyID userID, uint32_t personaStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		PersonaNameCache(const PersonaNameCache&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const PersonaNameCache&) = delete;
+
+		/** The Lua state whose registry holds the interned strings. */
+		lua_State* fLuaStatePointer;
+
+		/** Lua registry references to interned persona name strings, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, int> fLuaReferenceIdMap;
+};
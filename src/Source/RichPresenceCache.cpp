@@ -0,0 +1,257 @@
+// --------------------------------------------------------------------------------
+//
+// RichPresenceCache.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "RichPresenceCache.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include <memory>
+
+extern "C"
+{
+#	include "lua.h"
+}
+
+
+const int RichPresenceCache::kTimeToLiveInSeconds = 60;
+const int RichPresenceCache::kMaxConcurrentRequests = 8;
+const int RichPresenceCache::kRequestTimeoutInSeconds = 30;
+
+RichPresenceCache::Entry::Entry()
+:	HasValues(false),
+	IsQueued(false),
+	IsInFlight(false)
+{
+}
+
+RichPresenceCache::RichPresenceCache(RuntimeContext& context)
+:	fContext(context),
+	fInFlightCount(0)
+{
+}
+
+RichPresenceCache::~RichPresenceCache()
+{
+}
+
+bool RichPresenceCache::Request(const galaxy::api::GalaxyID& userId, int maxAgeInSeconds)
+{
+	// Validate.
+	if (!userId.IsValid() || (userId.GetIDType() != galaxy::api::GalaxyID::ID_TYPE_USER))
+	{
+		return false;
+	}
+	if (maxAgeInSeconds < 0)
+	{
+		maxAgeInSeconds = kTimeToLiveInSeconds;
+	}
+
+	// Do not fetch the user again if already queued, in-flight, or if the cached values are fresh enough.
+	auto& entry = fEntryMap[userId.ToUint64()];
+	if (entry.IsQueued || entry.IsInFlight)
+	{
+		return true;
+	}
+	if (entry.HasValues &&
+	    ((std::chrono::steady_clock::now() - entry.FetchTime) < std::chrono::seconds(maxAgeInSeconds)))
+	{
+		return false;
+	}
+
+	// Queue the user to be fetched by the Process() method.
+	entry.IsQueued = true;
+	fFetchQueue.push_back(userId.ToUint64());
+	return true;
+}
+
+bool RichPresenceCache::PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId) const
+{
+	// Validate.
+	if (!luaStatePointer)
+	{
+		return false;
+	}
+
+	// Fetch the user's cache entry.
+	auto iterator = fEntryMap.find(userId.ToUint64());
+	if ((iterator == fEntryMap.end()) || !iterator->second.HasValues)
+	{
+		return false;
+	}
+
+	// Push the cached key/value pairs to Lua.
+	auto& values = iterator->second.Values;
+	lua_createtable(luaStatePointer, 0, (int)values.size());
+	for (auto&& pair : values)
+	{
+		lua_pushlstring(luaStatePointer, pair.second.c_str(), pair.second.size());
+		lua_setfield(luaStatePointer, -2, pair.first.c_str());
+	}
+	return true;
+}
+
+bool RichPresenceCache::IsFresh(const galaxy::api::GalaxyID& userId) const
+{
+	auto iterator = fEntryMap.find(userId.ToUint64());
+	if ((iterator == fEntryMap.end()) || !iterator->second.HasValues)
+	{
+		return false;
+	}
+	auto age = std::chrono::steady_clock::now() - iterator->second.FetchTime;
+	return (age < std::chrono::seconds(kTimeToLiveInSeconds));
+}
+
+void RichPresenceCache::Process()
+{
+	auto currentTime = std::chrono::steady_clock::now();
+
+	// Give up on requests that the backend never responded to so that they stop taking up a slot.
+	// Evict entries which have gone stale, unless they are about to be fetched again.
+	// Note: Entries without values are evicted too, such as those of failed fetches, since they have nothing to read.
+	for (auto iterator = fEntryMap.begin(); iterator != fEntryMap.end();)
+	{
+		auto& entry = iterator->second;
+		if (entry.IsInFlight && ((currentTime - entry.RequestTime) >= std::chrono::seconds(kRequestTimeoutInSeconds)))
+		{
+			EndRequestFor(entry);
+		}
+		bool isStale = !entry.HasValues ||
+				((currentTime - entry.FetchTime) >= std::chrono::seconds(kTimeToLiveInSeconds));
+		if (isStale && !entry.IsQueued && !entry.IsInFlight)
+		{
+			iterator = fEntryMap.erase(iterator);
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+
+	// Send queued fetches while under the concurrency limit.
+	if (fFetchQueue.empty())
+	{
+		return;
+	}
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer)
+	{
+		return;
+	}
+	while ((fInFlightCount < kMaxConcurrentRequests) && !fFetchQueue.empty())
+	{
+		auto id = fFetchQueue.front();
+		fFetchQueue.pop_front();
+		auto iterator = fEntryMap.find(id);
+		if ((iterator == fEntryMap.end()) || !iterator->second.IsQueued)
+		{
+			continue;
+		}
+		auto& entry = iterator->second;
+		entry.IsQueued = false;
+		entry.IsInFlight = true;
+		entry.RequestTime = currentTime;
+		fInFlightCount++;
+		friendsPointer->RequestRichPresence(galaxy::api::GalaxyID(id));
+	}
+}
+
+void RichPresenceCache::OnRichPresenceRetrieveSuccess(galaxy::api::GalaxyID userID)
+{
+	// Only free up the request's slot here.
+	// Note: GOG also sends RequestRichPresence() responses to OnRichPresenceUpdated(), which copies the values
+	//       and notifies Lua. Doing so here too would copy them twice and dispatch a duplicate event.
+	auto iterator = fEntryMap.find(userID.ToUint64());
+	if (iterator != fEntryMap.end())
+	{
+		EndRequestFor(iterator->second);
+	}
+}
+
+void RichPresenceCache::OnRichPresenceRetrieveFailure(
+	galaxy::api::GalaxyID userID, galaxy::api::IRichPresenceRetrieveListener::FailureReason failureReason)
+{
+	// Only handle failures of requests that we've sent.
+	auto iterator = fEntryMap.find(userID.ToUint64());
+	if ((iterator == fEntryMap.end()) || !iterator->second.IsInFlight)
+	{
+		return;
+	}
+	EndRequestFor(iterator->second);
+
+	// Notify Lua about the failure. Previously cached values, if any, are left as is.
+	const char* failureReasonName = "undefined";
+	if (galaxy::api::IRichPresenceRetrieveListener::FAILURE_REASON_CONNECTION_FAILURE == failureReason)
+	{
+		failureReasonName = "connectionFailure";
+	}
+	auto taskPointer = std::make_shared<DispatchRichPresenceEventTask>();
+	taskPointer->AcquireEventDataFrom(userID, nullptr, failureReasonName);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void RichPresenceCache::OnRichPresenceUpdated(galaxy::api::GalaxyID userID)
+{
+	UpdateEntryFor(userID);
+}
+
+void RichPresenceCache::UpdateEntryFor(const galaxy::api::GalaxyID& userId)
+{
+	// Validate.
+	if (!userId.IsValid())
+	{
+		return;
+	}
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer)
+	{
+		return;
+	}
+
+	// Only update users that Lua has requested, so that the cache does not grow with every friend's update.
+	auto iterator = fEntryMap.find(userId.ToUint64());
+	if (iterator == fEntryMap.end())
+	{
+		return;
+	}
+	auto& entry = iterator->second;
+
+	// Copy the user's rich presence into the cache.
+	// Note: This is the only place the SDK's rich presence getters are called, off of Lua's read path.
+	entry.Values.clear();
+	uint32_t count = friendsPointer->GetRichPresenceCount(userId);
+	for (uint32_t index = 0; index < count; index++)
+	{
+		char key[1024] = { 0 };
+		char value[4096] = { 0 };
+		friendsPointer->GetRichPresenceByIndex(index, key, sizeof(key), value, sizeof(value), userId);
+		if (key[0] != '\0')
+		{
+			entry.Values[key] = value;
+		}
+	}
+	entry.HasValues = true;
+	entry.FetchTime = std::chrono::steady_clock::now();
+	if (entry.IsInFlight)
+	{
+		EndRequestFor(entry);
+	}
+
+	// Notify Lua.
+	auto taskPointer = std::make_shared<DispatchRichPresenceEventTask>();
+	taskPointer->AcquireEventDataFrom(userId, &entry.Values, nullptr);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void RichPresenceCache::EndRequestFor(Entry& entry)
+{
+	if (entry.IsInFlight)
+	{
+		entry.IsInFlight = false;
+		fInFlightCount--;
+	}
+}
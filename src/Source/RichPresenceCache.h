@@ -0,0 +1,153 @@
+// ----------------------------------------------------------------------------
+//
+// RichPresenceCache.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+extern "C"
+{
+	struct lua_State;
+}
+
+
+/**
+  Caches the rich presence key/value sets of other users.
+
+  An entry is created when Lua requests a user's rich presence, and is then filled in natively whenever GOG
+  reports an updated rich presence for that user, including the responses to our own fetches, so that Lua can
+  read a user's whole rich presence table without making any SDK calls. Updates for users who were never
+  requested are ignored. Entries older than the cache's time-to-live are re-fetched when requested, with a
+  limited number of IFriends::RequestRichPresence() calls in-flight at a time, and are evicted by Process()
+  unless a fetch is pending.
+
+  A "richPresence" event is dispatched to Lua whenever a user's cached rich presence has been updated.
+ */
+class RichPresenceCache
+:	public galaxy::api::GlobalRichPresenceRetrieveListener,
+	public galaxy::api::GlobalRichPresenceListener
+{
+	public:
+		/** Number of seconds a cached entry is considered fresh after having been retrieved. */
+		static const int kTimeToLiveInSeconds;
+
+		/** Maximum number of RequestRichPresence() calls allowed to be awaiting a response. */
+		static const int kMaxConcurrentRequests;
+
+		/** Number of seconds to wait for a response before freeing up the request's slot. */
+		static const int kRequestTimeoutInSeconds;
+
+		/**
+		  Creates a new cache.
+		  @param context The runtime context that will dispatch this cache's events to Lua.
+		 */
+		RichPresenceCache(RuntimeContext& context);
+
+		virtual ~RichPresenceCache();
+
+		/**
+		  Queues a fetch of the given user's rich presence if it isn't cached or if its cache entry is stale.
+		  @param userId The user to fetch rich presence for.
+		  @param maxAgeInSeconds Cached entries older than this are re-fetched. Set to a negative value to use
+		                         the cache's default time-to-live.
+		  @return Returns true if a fetch was queued or is already in-flight.
+
+		          Returns false if the cached entry is fresh or if given an invalid ID.
+		 */
+		bool Request(const galaxy::api::GalaxyID& userId, int maxAgeInSeconds);
+
+		/**
+		  Pushes the given user's cached rich presence to Lua as a table of key/value string pairs.
+		  @param luaStatePointer The Lua state to push the table to.
+		  @param userId The user to fetch the cached rich presence of.
+		  @return Returns true if the user has a cache entry and a table was pushed to Lua.
+
+		          Returns false if the user has never been fetched. Nothing is pushed to Lua in this case.
+		 */
+		bool PushTo(lua_State* luaStatePointer, const galaxy::api::GalaxyID& userId) const;
+
+		/**
+		  Determines if the given user's cache entry exists and is younger than the cache's time-to-live.
+		  @param userId The user to check.
+		  @return Returns true if the user's cached rich presence is fresh.
+		 */
+		bool IsFresh(const galaxy::api::GalaxyID& userId) const;
+
+		/**
+		  Sends queued fetches while under the concurrency limit, expires stale in-flight requests and evicts
+		  entries older than the time-to-live which have no fetch pending.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnRichPresenceRetrieveSuccess(galaxy::api::GalaxyID userID);
+		virtual void OnRichPresenceRetrieveFailure(
+				galaxy::api::GalaxyID userID, galaxy::api::IRichPresenceRetrieveListener::FailureReason failureReason);
+		virtual void OnRichPresenceUpdated(galaxy::api::GalaxyID userID);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		RichPresenceCache(const RichPresenceCache&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const RichPresenceCache&) = delete;
+
+		struct Entry
+		{
+			Entry();
+
+			/** The user's rich presence key/value pairs. */
+			std::map<std::string, std::string> Values;
+
+			/** Set true once "Values" has been retrieved from GOG at least once. */
+			bool HasValues;
+
+			/** Time "Values" was last retrieved from GOG. */
+			std::chrono::steady_clock::time_point FetchTime;
+
+			/** Set true if queued to be fetched but not sent yet. */
+			bool IsQueued;
+
+			/** Set true if a RequestRichPresence() for this user is awaiting a response. */
+			bool IsInFlight;
+
+			/** Time the in-flight request was sent. */
+			std::chrono::steady_clock::time_point RequestTime;
+		};
+
+		/**
+		  Copies the given user's rich presence from the GOG SDK into the cache and dispatches an event to Lua.
+		  Does nothing if the user has no cache entry, ie: if Lua has not requested the user or it was evicted.
+		  @param userId The user whose rich presence has been updated.
+		 */
+		void UpdateEntryFor(const galaxy::api::GalaxyID& userId);
+
+		/** Marks the given entry's request as no longer in-flight. */
+		void EndRequestFor(Entry& entry);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Cache entries keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, Entry> fEntryMap;
+
+		/** Users waiting to be fetched, in request order. */
+		std::deque<uint64_t> fFetchQueue;
+
+		/** Number of entries flagged as in-flight. */
+		int fInFlightCount;
+};
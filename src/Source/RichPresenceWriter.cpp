@@ -0,0 +1,231 @@
+// --------------------------------------------------------------------------------
+//
+// RichPresenceWriter.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "RichPresenceWriter.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <memory>
+
+
+const int RichPresenceWriter::kDebounceInMilliseconds = 500;
+const int RichPresenceWriter::kMaxDelayInMilliseconds = 2000;
+const int RichPresenceWriter::kMinRetryDelayInMilliseconds = 2000;
+const int RichPresenceWriter::kMaxRetryDelayInMilliseconds = 60000;
+
+RichPresenceWriter::RichPresenceWriter(RuntimeContext& context)
+:	fContext(context),
+	fIsWriteInFlight(false),
+	fIsInFlightDelete(false),
+	fIsFlushing(false),
+	fHasPendingChanges(false),
+	fRetryDelay(0)
+{
+}
+
+RichPresenceWriter::~RichPresenceWriter()
+{
+}
+
+void RichPresenceWriter::Set(const char* key, const char* value)
+{
+	// Validate.
+	if (!key || ('\0' == key[0]))
+	{
+		return;
+	}
+
+	// Update the desired set. Do nothing if the value hasn't changed.
+	auto iterator = fDesiredMap.find(key);
+	if (value)
+	{
+		if ((iterator != fDesiredMap.end()) && (iterator->second == value))
+		{
+			return;
+		}
+		fDesiredMap[key] = value;
+	}
+	else
+	{
+		if (iterator == fDesiredMap.end())
+		{
+			return;
+		}
+		fDesiredMap.erase(iterator);
+	}
+	OnDesiredSetChanged();
+}
+
+void RichPresenceWriter::Clear()
+{
+	// Do nothing if there is nothing to clear.
+	// Note: Keys acknowledged by the backend but no longer desired will be deleted on the next flush.
+	if (fDesiredMap.empty())
+	{
+		return;
+	}
+	fDesiredMap.clear();
+	OnDesiredSetChanged();
+}
+
+void RichPresenceWriter::Process()
+{
+	// Only allow one write at a time.
+	if (fIsWriteInFlight)
+	{
+		return;
+	}
+
+	// Do not continue if we're backing off after a failed write.
+	auto currentTime = std::chrono::steady_clock::now();
+	if (currentTime < fRetryTime)
+	{
+		return;
+	}
+
+	// Wait for the desired set to settle, unless it has been changing for too long.
+	if (fHasPendingChanges)
+	{
+		if (((currentTime - fLastChangeTime) < std::chrono::milliseconds(kDebounceInMilliseconds)) &&
+		    ((currentTime - fFirstChangeTime) < std::chrono::milliseconds(kMaxDelayInMilliseconds)))
+		{
+			return;
+		}
+		fHasPendingChanges = false;
+	}
+
+	// Find the next key to write. If there are none, then the flush is complete.
+	std::string key;
+	std::string value;
+	bool isDelete = false;
+	if (!FindNextChange(key, value, isDelete))
+	{
+		if (fIsFlushing)
+		{
+			fIsFlushing = false;
+			auto taskPointer = std::make_shared<DispatchRichPresenceChangeEventTask>();
+			taskPointer->AcquireEventDataFrom(nullptr);
+			fContext.QueueDispatchEventTask(taskPointer);
+		}
+		return;
+	}
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer)
+	{
+		return;
+	}
+
+	// Send the change.
+	fIsFlushing = true;
+	fIsWriteInFlight = true;
+	fInFlightKey = key;
+	fInFlightValue = value;
+	fIsInFlightDelete = isDelete;
+	if (isDelete)
+	{
+		friendsPointer->DeleteRichPresence(key.c_str());
+	}
+	else
+	{
+		friendsPointer->SetRichPresence(key.c_str(), value.c_str());
+	}
+}
+
+void RichPresenceWriter::OnRichPresenceChangeSuccess()
+{
+	// Ignore responses to writes that we didn't make.
+	if (!fIsWriteInFlight)
+	{
+		return;
+	}
+
+	// Commit the write to the acknowledged set. Process() will send the next change, if any.
+	if (fIsInFlightDelete)
+	{
+		fAcknowledgedMap.erase(fInFlightKey);
+	}
+	else
+	{
+		fAcknowledgedMap[fInFlightKey] = fInFlightValue;
+	}
+	fIsWriteInFlight = false;
+	fRetryDelay = std::chrono::milliseconds(0);
+}
+
+void RichPresenceWriter::OnRichPresenceChangeFailure(FailureReason failureReason)
+{
+	// Ignore responses to writes that we didn't make.
+	if (!fIsWriteInFlight)
+	{
+		return;
+	}
+	fIsWriteInFlight = false;
+
+	// Back off before trying again. The key is still out of sync, so Process() will retry it.
+	if (fRetryDelay.count() <= 0)
+	{
+		fRetryDelay = std::chrono::milliseconds(kMinRetryDelayInMilliseconds);
+	}
+	else
+	{
+		fRetryDelay = std::min(fRetryDelay * 2, std::chrono::milliseconds(kMaxRetryDelayInMilliseconds));
+	}
+	fRetryTime = std::chrono::steady_clock::now() + fRetryDelay;
+
+	// Notify Lua about the failure.
+	const char* failureReasonName = "undefined";
+	if (galaxy::api::IRichPresenceChangeListener::FAILURE_REASON_CONNECTION_FAILURE == failureReason)
+	{
+		failureReasonName = "connectionFailure";
+	}
+	auto taskPointer = std::make_shared<DispatchRichPresenceChangeEventTask>();
+	taskPointer->AcquireEventDataFrom(failureReasonName);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
+
+void RichPresenceWriter::OnDesiredSetChanged()
+{
+	// Restart the debounce timer.
+	auto currentTime = std::chrono::steady_clock::now();
+	if (!fHasPendingChanges)
+	{
+		fHasPendingChanges = true;
+		fFirstChangeTime = currentTime;
+	}
+	fLastChangeTime = currentTime;
+}
+
+bool RichPresenceWriter::FindNextChange(std::string& outKey, std::string& outValue, bool& outIsDelete) const
+{
+	// Look for added or modified keys.
+	for (auto&& pair : fDesiredMap)
+	{
+		auto iterator = fAcknowledgedMap.find(pair.first);
+		if ((iterator == fAcknowledgedMap.end()) || (iterator->second != pair.second))
+		{
+			outKey = pair.first;
+			outValue = pair.second;
+			outIsDelete = false;
+			return true;
+		}
+	}
+
+	// Look for removed keys.
+	for (auto&& pair : fAcknowledgedMap)
+	{
+		if (fDesiredMap.find(pair.first) == fDesiredMap.end())
+		{
+			outKey = pair.first;
+			outValue.clear();
+			outIsDelete = true;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,131 @@
+// ----------------------------------------------------------------------------
+//
+// RichPresenceWriter.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <string>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Keeps the logged in user's desired rich presence key/value set and lazily synchronizes it with GOG.
+
+  Lua may update rich presence as often as it likes. This writer waits for the desired set to settle
+  (debounce), diffs it against the last set acknowledged by the backend, and then only sends the changed
+  keys via IFriends::SetRichPresence() and IFriends::DeleteRichPresence(), one request at a time.
+  Failed writes are retried with an exponential back-off.
+
+  A "richPresenceChange" event is dispatched to Lua once all pending changes have been written or
+  when a write fails.
+ */
+class RichPresenceWriter : public galaxy::api::GlobalRichPresenceChangeListener
+{
+	public:
+		/** Number of milliseconds the desired set has to remain unchanged before it is written. */
+		static const int kDebounceInMilliseconds;
+
+		/** Longest time in milliseconds a change may be delayed by continuous updates before being written. */
+		static const int kMaxDelayInMilliseconds;
+
+		/** Number of milliseconds to wait before retrying after the 1st failure. Doubles per failure. */
+		static const int kMinRetryDelayInMilliseconds;
+
+		/** Upper limit of the retry delay in milliseconds. */
+		static const int kMaxRetryDelayInMilliseconds;
+
+		/**
+		  Creates a new writer.
+		  @param context The runtime context that will dispatch this writer's events to Lua.
+		 */
+		RichPresenceWriter(RuntimeContext& context);
+
+		virtual ~RichPresenceWriter();
+
+		/**
+		  Sets the desired value of the given rich presence key.
+		  @param key The rich presence key. Cannot be null or empty.
+		  @param value The value to assign. Set to null to delete the key.
+		 */
+		void Set(const char* key, const char* value);
+
+		/** Flags all of the user's rich presence keys to be deleted. */
+		void Clear();
+
+		/**
+		  Sends the next changed key to the backend if debounce time has elapsed and no write is in-flight.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnRichPresenceChangeSuccess();
+		virtual void OnRichPresenceChangeFailure(FailureReason failureReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		RichPresenceWriter(const RichPresenceWriter&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const RichPresenceWriter&) = delete;
+
+		/** Restarts the debounce timer after the desired set has been modified. */
+		void OnDesiredSetChanged();
+
+		/**
+		  Finds the next key whose desired value differs from the acknowledged one.
+		  @param outKey Assigned the changed key if found.
+		  @param outValue Assigned the key's desired value if found.
+		  @param outIsDelete Set true if the key needs to be deleted instead.
+		  @return Returns true if a changed key was found. Returns false if the desired and acknowledged sets match.
+		 */
+		bool FindNextChange(std::string& outKey, std::string& outValue, bool& outIsDelete) const;
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** The rich presence set that Lua wants the user to have. */
+		std::map<std::string, std::string> fDesiredMap;
+
+		/** The rich presence set that the backend has confirmed. */
+		std::map<std::string, std::string> fAcknowledgedMap;
+
+		/** Set true while a SetRichPresence() or DeleteRichPresence() call is awaiting a response. */
+		bool fIsWriteInFlight;
+
+		/** Key being written by the in-flight request. */
+		std::string fInFlightKey;
+
+		/** Value being written by the in-flight request. Ignored if "fIsInFlightDelete" is true. */
+		std::string fInFlightValue;
+
+		/** Set true if the in-flight request is deleting key "fInFlightKey". */
+		bool fIsInFlightDelete;
+
+		/** Set true between the first write of a flush and the moment all changes have been acknowledged. */
+		bool fIsFlushing;
+
+		/** Set true if the desired set was modified since the last flush started. */
+		bool fHasPendingChanges;
+
+		/** Time the desired set was first modified after the last flush. */
+		std::chrono::steady_clock::time_point fFirstChangeTime;
+
+		/** Time the desired set was last modified. */
+		std::chrono::steady_clock::time_point fLastChangeTime;
+
+		/** Writes will not be attempted until this time after a failure. */
+		std::chrono::steady_clock::time_point fRetryTime;
+
+		/** Current retry delay. Zero if the last write succeeded. */
+		std::chrono::milliseconds fRetryDelay;
+};
@@ -10,6 +10,23 @@
 #include "RuntimeContext.h"
 #include "CoronaLua.h"
 #include "DispatchEventTask.h"
+#include "HostElection.h"
+#include "LobbyBrowser.h"
+#include "LobbyDataMirror.h"
+#include "LobbyDataWriter.h"
+#include "LobbyMembership.h"
+#include "LobbyMessenger.h"
+#include "LobbyRoster.h"
+#include "P2PNetworking.h"
+#include "P2PReliability.h"
+#include "PayloadCodec.h"
+#include "PeerTelemetry.h"
+#include "PersonaNameCache.h"
+#include "RichPresenceCache.h"
+#include "RichPresenceWriter.h"
+#include "SnapshotReplicator.h"
+#include "UserFinder.h"
+#include "UserInformationScheduler.h"
 #include <exception>
 #include <memory>
 #include <unordered_set>
@@ -44,6 +61,25 @@ RuntimeContext::RuntimeContext(lua_State* luaStatePointer)
 	// Used to dispatch global events to listeners
 	fLuaEventDispatcherPointer = std::make_shared<LuaEventDispatcher>(luaStatePointer);
 
+	// Create the native subsystems which sit between Lua and the GOG SDK.
+	fPayloadCodecPointer.reset(new PayloadCodec());
+	fPersonaNameCachePointer.reset(new PersonaNameCache(luaStatePointer));
+	fUserInformationSchedulerPointer.reset(new UserInformationScheduler(*this));
+	fRichPresenceWriterPointer.reset(new RichPresenceWriter(*this));
+	fRichPresenceCachePointer.reset(new RichPresenceCache(*this));
+	fUserFinderPointer.reset(new UserFinder(*this));
+	fLobbyBrowserPointer.reset(new LobbyBrowser(*this));
+	fLobbyMembershipPointer.reset(new LobbyMembership(*this));
+	fLobbyDataMirrorPointer.reset(new LobbyDataMirror(*this));
+	fLobbyDataWriterPointer.reset(new LobbyDataWriter(*this));
+	fLobbyMessengerPointer.reset(new LobbyMessenger(*this));
+	fLobbyRosterPointer.reset(new LobbyRoster(*this));
+	fHostElectionPointer.reset(new HostElection(*this));
+	fP2PNetworkingPointer.reset(new P2PNetworking(*this));
+	fP2PReliabilityPointer.reset(new P2PReliability(*this));
+	fSnapshotReplicatorPointer.reset(new SnapshotReplicator(*this));
+	fPeerTelemetryPointer.reset(new PeerTelemetry(*this));
+
 	// Add Corona runtime event listeners.
 	fLuaEnterFrameCallback.AddToRuntimeEventListeners("enterFrame");
 
@@ -74,6 +110,105 @@ std::shared_ptr<LuaEventDispatcher> RuntimeContext::GetLuaEventDispatcher() cons
 	return fLuaEventDispatcherPointer;
 }
 
+PersonaNameCache* RuntimeContext::GetPersonaNameCache() const
+{
+	return fPersonaNameCachePointer.get();
+}
+
+UserInformationScheduler* RuntimeContext::GetUserInformationScheduler() const
+{
+	return fUserInformationSchedulerPointer.get();
+}
+
+RichPresenceWriter* RuntimeContext::GetRichPresenceWriter() const
+{
+	return fRichPresenceWriterPointer.get();
+}
+
+RichPresenceCache* RuntimeContext::GetRichPresenceCache() const
+{
+	return fRichPresenceCachePointer.get();
+}
+
+UserFinder* RuntimeContext::GetUserFinder() const
+{
+	return fUserFinderPointer.get();
+}
+
+LobbyBrowser* RuntimeContext::GetLobbyBrowser() const
+{
+	return fLobbyBrowserPointer.get();
+}
+
+LobbyMembership* RuntimeContext::GetLobbyMembership() const
+{
+	return fLobbyMembershipPointer.get();
+}
+
+LobbyDataMirror* RuntimeContext::GetLobbyDataMirror() const
+{
+	return fLobbyDataMirrorPointer.get();
+}
+
+LobbyDataWriter* RuntimeContext::GetLobbyDataWriter() const
+{
+	return fLobbyDataWriterPointer.get();
+}
+
+LobbyMessenger* RuntimeContext::GetLobbyMessenger() const
+{
+	return fLobbyMessengerPointer.get();
+}
+
+PayloadCodec* RuntimeContext::GetPayloadCodec() const
+{
+	return fPayloadCodecPointer.get();
+}
+
+LobbyRoster* RuntimeContext::GetLobbyRoster() const
+{
+	return fLobbyRosterPointer.get();
+}
+
+HostElection* RuntimeContext::GetHostElection() const
+{
+	return fHostElectionPointer.get();
+}
+
+P2PNetworking* RuntimeContext::GetP2PNetworking() const
+{
+	return fP2PNetworkingPointer.get();
+}
+
+P2PReliability* RuntimeContext::GetP2PReliability() const
+{
+	return fP2PReliabilityPointer.get();
+}
+
+SnapshotReplicator* RuntimeContext::GetSnapshotReplicator() const
+{
+	return fSnapshotReplicatorPointer.get();
+}
+
+PeerTelemetry* RuntimeContext::GetPeerTelemetry() const
+{
+	return fPeerTelemetryPointer.get();
+}
+
+void RuntimeContext::QueueDispatchEventTask(const std::shared_ptr<BaseDispatchEventTask>& taskPointer)
+{
+	// Validate.
+	if (!taskPointer)
+	{
+		return;
+	}
+
+	// Queue the task to be dispatched to Lua later.
+	// This ensures that Lua events are only dispatched while Corona is running (ie: not suspended).
+	taskPointer->SetLuaEventDispatcher(fLuaEventDispatcherPointer);
+	fDispatchEventTaskQueue.push(taskPointer);
+}
+
 RuntimeContext* RuntimeContext::GetInstanceBy(lua_State* luaStatePointer)
 {
 	// Validate.
@@ -115,8 +250,24 @@ int RuntimeContext::OnCoronaEnterFrame(lua_State* luaStatePointer)
 		return 0;
 	}
 
+	// Send the P2P datagrams packed during the last frame along with the below ProcessData() call.
+	fP2PNetworkingPointer->Flush();
     galaxy::api::ProcessData();
 
+	// Let our native subsystems act on the callbacks received from the above ProcessData() call.
+	fUserInformationSchedulerPointer->Process();
+	fRichPresenceWriterPointer->Process();
+	fRichPresenceCachePointer->Process();
+	fUserFinderPointer->Process();
+	fLobbyBrowserPointer->Process();
+	fLobbyDataMirrorPointer->Process();
+	fLobbyDataWriterPointer->Process();
+	fLobbyMessengerPointer->Process();
+	fHostElectionPointer->Process();
+	fP2PNetworkingPointer->Process();
+	fP2PReliabilityPointer->Process();
+	fPeerTelemetryPointer->Process();
+
 	// Dispatch all queued events received from the above ProcessData() call to Lua.
 	while (fDispatchEventTaskQueue.size() > 0)
 	{
@@ -25,6 +25,24 @@
 #include "GalaxyApi.h"
 
 // Forward declarations.
+class HostElection;
+class LobbyBrowser;
+class LobbyDataMirror;
+class LobbyDataWriter;
+class LobbyMembership;
+class LobbyMessenger;
+class LobbyRoster;
+class P2PNetworking;
+class P2PReliability;
+class PayloadCodec;
+class PeerTelemetry;
+class PersonaNameCache;
+class RichPresenceCache;
+class RichPresenceWriter;
+class SnapshotReplicator;
+class UserFinder;
+class UserInformationScheduler;
+
 extern "C"
 {
 	struct lua_State;
@@ -101,6 +119,118 @@ class RuntimeContext
 		 */
 		static int GetInstanceCount();
 
+		/**
+		  Gets the cache of interned persona name Lua strings.
+		  @return Returns a pointer to the context's persona name cache.
+		 */
+		PersonaNameCache* GetPersonaNameCache() const;
+
+		/**
+		  Gets the scheduler that all of this plugin's user information requests are expected to go through.
+		  @return Returns a pointer to the context's user information scheduler.
+		 */
+		UserInformationScheduler* GetUserInformationScheduler() const;
+
+		/**
+		  Gets the writer that debounces and diffs the logged in user's rich presence updates.
+		  @return Returns a pointer to the context's rich presence writer.
+		 */
+		RichPresenceWriter* GetRichPresenceWriter() const;
+
+		/**
+		  Gets the cache holding the rich presence of other users.
+		  @return Returns a pointer to the context's rich presence cache.
+		 */
+		RichPresenceCache* GetRichPresenceCache() const;
+
+		/**
+		  Gets the front-end to IFriends::FindUser() which caches and merges user specifier lookups.
+		  @return Returns a pointer to the context's user finder.
+		 */
+		UserFinder* GetUserFinder() const;
+
+		/**
+		  Gets the lobby query engine which caches and merges lobby list requests.
+		  @return Returns a pointer to the context's lobby browser.
+		 */
+		LobbyBrowser* GetLobbyBrowser() const;
+
+		/**
+		  Gets the object used to create, join and leave lobbies.
+		  @return Returns a pointer to the context's lobby membership tracker.
+		 */
+		LobbyMembership* GetLobbyMembership() const;
+
+		/**
+		  Gets the native copy of lobby and lobby member data that Lua reads from.
+		  @return Returns a pointer to the context's lobby data mirror.
+		 */
+		LobbyDataMirror* GetLobbyDataMirror() const;
+
+		/**
+		  Gets the writer that buffers and debounces lobby data and lobby member data writes.
+		  @return Returns a pointer to the context's lobby data writer.
+		 */
+		LobbyDataWriter* GetLobbyDataWriter() const;
+
+		/**
+		  Gets the object used to send lobby messages and to deliver received lobby messages to Lua.
+		  @return Returns a pointer to the context's lobby messenger.
+		 */
+		LobbyMessenger* GetLobbyMessenger() const;
+
+		/**
+		  Gets the framing layer that compresses lobby messages and lobby data values when enabled.
+		  @return Returns a pointer to the context's payload codec.
+		 */
+		PayloadCodec* GetPayloadCodec() const;
+
+		/**
+		  Gets the native member list and owner of every lobby the user is in.
+		  @return Returns a pointer to the context's lobby roster cache.
+		 */
+		LobbyRoster* GetLobbyRoster() const;
+
+		/**
+		  Gets the opt-in service electing the best connected member of each lobby as the P2P session's host.
+		  @return Returns a pointer to the context's host election service.
+		 */
+		HostElection* GetHostElection() const;
+
+		/**
+		  Gets the object sending P2P packets and pumping received P2P packets to Lua once per frame.
+		  @return Returns a pointer to the context's P2P packet pump.
+		 */
+		P2PNetworking* GetP2PNetworking() const;
+
+		/**
+		  Gets the layer providing reliable and ordered P2P message streams over unreliable packets.
+		  @return Returns a pointer to the context's P2P reliability layer.
+		 */
+		P2PReliability* GetP2PReliability() const;
+
+		/**
+		  Gets the object replicating snapshots to P2P peers as deltas against their last acknowledged snapshot.
+		  @return Returns a pointer to the context's snapshot replicator.
+		 */
+		SnapshotReplicator* GetSnapshotReplicator() const;
+
+		/**
+		  Gets the object gathering per-peer connection statistics from the P2P layer.
+		  @return Returns a pointer to the context's peer telemetry.
+		 */
+		PeerTelemetry* GetPeerTelemetry() const;
+
+		/**
+		  Queues the given task to be dispatched to Lua during the next "enterFrame" event, after all pending
+		  GOG callbacks have been processed. Assigns the context's Lua event dispatcher to the task.
+
+		  Intended to be called by the context's native subsystems so that all of their events are only dispatched
+		  while the Corona runtime is running (ie: not suspended) and in the order they were queued.
+		  @param taskPointer The task to be dispatched. Null pointers are ignored.
+		 */
+		void QueueDispatchEventTask(const std::shared_ptr<BaseDispatchEventTask>& taskPointer);
+
 		/** Set up global GOG event handlers via their macros. */
 		void OnAuthResponse(bool success);
 
@@ -147,4 +277,55 @@ class RuntimeContext
 		  by this context later and only while the Corona runtime is running (ie: not suspended).
 		 */
 		std::queue<std::shared_ptr<BaseDispatchEventTask>> fDispatchEventTaskQueue;
+
+		/** Compresses lobby messages and lobby data values for the subsystems below. */
+		std::unique_ptr<PayloadCodec> fPayloadCodecPointer;
+
+		/** Interns persona names as Lua strings for all events and getters that provide them. */
+		std::unique_ptr<PersonaNameCache> fPersonaNameCachePointer;
+
+		/** Merges, prioritizes and rate limits IFriends::RequestUserInformation() calls. */
+		std::unique_ptr<UserInformationScheduler> fUserInformationSchedulerPointer;
+
+		/** Writes the logged in user's rich presence changes to GOG one debounced key at a time. */
+		std::unique_ptr<RichPresenceWriter> fRichPresenceWriterPointer;
+
+		/** Caches other users' rich presence so that Lua can read it without calling the GOG SDK. */
+		std::unique_ptr<RichPresenceCache> fRichPresenceCachePointer;
+
+		/** Caches IFriends::FindUser() results so that repeated lookups of a user specifier are free. */
+		std::unique_ptr<UserFinder> fUserFinderPointer;
+
+		/** Serializes, merges and caches IMatchmaking::RequestLobbyList() queries. */
+		std::unique_ptr<LobbyBrowser> fLobbyBrowserPointer;
+
+		/** Creates, joins and leaves lobbies and tracks which lobbies the user is in. */
+		std::unique_ptr<LobbyMembership> fLobbyMembershipPointer;
+
+		/** Mirrors lobby data and dispatches per-key changes to Lua. */
+		std::unique_ptr<LobbyDataMirror> fLobbyDataMirrorPointer;
+
+		/** Collapses lobby data writes and flushes them one SDK call at a time per lobby. */
+		std::unique_ptr<LobbyDataWriter> fLobbyDataWriterPointer;
+
+		/** Batches received lobby messages into one Lua event per frame. */
+		std::unique_ptr<LobbyMessenger> fLobbyMessengerPointer;
+
+		/** Keeps the member list and owner of each lobby the user is in up to date. */
+		std::unique_ptr<LobbyRoster> fLobbyRosterPointer;
+
+		/** Elects each lobby's P2P host from the ping reports exchanged by its members. */
+		std::unique_ptr<HostElection> fHostElectionPointer;
+
+		/** Sends P2P packets and dispatches received ones to Lua in per-frame batches. */
+		std::unique_ptr<P2PNetworking> fP2PNetworkingPointer;
+
+		/** Provides reliable ordered streams on top of the P2PNetworking's unreliable packets. */
+		std::unique_ptr<P2PReliability> fP2PReliabilityPointer;
+
+		/** Sends snapshots as deltas over P2P and reconstructs received ones. */
+		std::unique_ptr<SnapshotReplicator> fSnapshotReplicatorPointer;
+
+		/** Provides per-peer connection statistics and dispatches them periodically to Lua. */
+		std::unique_ptr<PeerTelemetry> fPeerTelemetryPointer;
 };
\ No newline at end of file
@@ -0,0 +1,553 @@
+// --------------------------------------------------------------------------------
+//
+// SnapshotReplicator.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "SnapshotReplicator.h"
+#include "LobbyMembership.h"
+#include "LobbyRoster.h"
+#include "RuntimeContext.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string.h>
+
+
+const size_t SnapshotReplicator::kHistoryCount = 32;
+const size_t SnapshotReplicator::kMaxSnapshotByteCount = 65536;
+
+/**
+  Packet type of a snapshot encoded in full.
+  Followed by the sender's 32-bit session nonce, the 16-bit snapshot ID and its delta against an empty snapshot.
+ */
+static const uint8_t kFullPacketType = 0x00;
+
+/**
+  Packet type of a snapshot encoded as a delta.
+  Followed by the sender's 32-bit session nonce, the 16-bit snapshot ID, its base's 16-bit ID and the delta.
+ */
+static const uint8_t kDeltaPacketType = 0x01;
+
+/**
+  Packet type of an acknowledgement.
+  Followed by the 32-bit session nonce of the snapshot received, and its 16-bit ID.
+ */
+static const uint8_t kAckPacketType = 0x02;
+
+/** Number of bytes preceding the delta in a full snapshot or acknowledgement packet. */
+static const size_t kHeaderByteCount = 7;
+
+/** Number of bytes preceding the delta in a delta packet, including its base's ID. */
+static const size_t kDeltaHeaderByteCount = 9;
+
+
+//---------------------------------------------------------------------------------
+// Private Static Functions
+//---------------------------------------------------------------------------------
+
+/** Determines if the given snapshot ID is more recent than the other, allowing for wrap around. */
+static bool IsSnapshotIdNewer(uint16_t snapshotId, uint16_t otherSnapshotId)
+{
+	return (snapshotId != otherSnapshotId) && ((uint16_t)(snapshotId - otherSnapshotId) < 0x8000);
+}
+
+/** Picks a random nonzero session nonce. */
+static uint32_t GenerateSession()
+{
+	static std::random_device sRandomDevice;
+	static std::mt19937 sRandomEngine(
+			sRandomDevice() ^ (uint32_t)std::chrono::steady_clock::now().time_since_epoch().count());
+	uint32_t session;
+	do
+	{
+		session = (uint32_t)sRandomEngine();
+	} while (0 == session);
+	return session;
+}
+
+static uint16_t Read16(const uint8_t* bytesPointer)
+{
+	return (uint16_t)(bytesPointer[0] | (bytesPointer[1] << 8));
+}
+
+static void Write16(std::vector<char>& bytes, uint16_t value)
+{
+	bytes.push_back((char)(value & 0xFF));
+	bytes.push_back((char)(value >> 8));
+}
+
+static uint32_t Read32(const uint8_t* bytesPointer)
+{
+	return (uint32_t)Read16(bytesPointer) | ((uint32_t)Read16(bytesPointer + 2) << 16);
+}
+
+static void Write32(std::vector<char>& bytes, uint32_t value)
+{
+	Write16(bytes, (uint16_t)(value & 0xFFFF));
+	Write16(bytes, (uint16_t)(value >> 16));
+}
+
+static void WriteVarint(std::vector<char>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back((char)value);
+}
+
+static bool ReadVarint(const uint8_t* bytesPointer, size_t byteCount, size_t* offsetPointer, uint64_t* valuePointer)
+{
+	uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (*offsetPointer >= byteCount)
+		{
+			return false;
+		}
+		auto nextByte = bytesPointer[(*offsetPointer)++];
+		value |= (uint64_t)(nextByte & 0x7F) << shift;
+		if (!(nextByte & 0x80))
+		{
+			*valuePointer = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+//---------------------------------------------------------------------------------
+// SnapshotReplicator Class Members
+//---------------------------------------------------------------------------------
+
+SnapshotReplicator::Statistics::Statistics()
+:	SentCount(0),
+	FullSentCount(0),
+	SnapshotByteCount(0),
+	EncodedByteCount(0),
+	DeliveredCount(0),
+	DecodeDropCount(0)
+{
+}
+
+SnapshotReplicator::Peer::Peer()
+:	HasAcked(false),
+	AckedSnapshotId(0),
+	HasDelivered(false),
+	DeliveredSnapshotId(0),
+	RemoteSession(0),
+	RetiredRemoteSession(0)
+{
+}
+
+SnapshotReplicator::SnapshotReplicator(RuntimeContext& context)
+:	fContext(context),
+	fChannel(-1),
+	fSession(GenerateSession()),
+	fNextSnapshotId(0)
+{
+}
+
+SnapshotReplicator::~SnapshotReplicator()
+{
+}
+
+int SnapshotReplicator::GetChannel() const
+{
+	return fChannel;
+}
+
+void SnapshotReplicator::SetChannel(int channel)
+{
+	if ((channel < -1) || (channel > 255))
+	{
+		return;
+	}
+	if (channel != fChannel)
+	{
+		fChannel = channel;
+		fSession = GenerateSession();
+		fSentSnapshots.clear();
+		fPeerMap.clear();
+		fContext.GetP2PNetworking()->UpdateSubscribedChannels();
+	}
+}
+
+bool SnapshotReplicator::Send(
+	const std::vector<galaxy::api::GalaxyID>& userIds, const char* bytesPointer, size_t byteCount)
+{
+	// Validate.
+	if ((fChannel < 0) || (!bytesPointer && (byteCount > 0)) || (byteCount > kMaxSnapshotByteCount))
+	{
+		return false;
+	}
+	for (auto&& userId : userIds)
+	{
+		if (!userId.IsValid())
+		{
+			return false;
+		}
+	}
+
+	// Send the snapshot to every peer, encoded against the last snapshot it has acknowledged if still kept.
+	auto snapshotId = fNextSnapshotId++;
+	auto networkingPointer = fContext.GetP2PNetworking();
+	bool wereAllSent = true;
+	for (auto&& userId : userIds)
+	{
+		const Snapshot* baseSnapshotPointer = nullptr;
+		auto peerIterator = fPeerMap.find(userId.ToUint64());
+		if ((peerIterator != fPeerMap.end()) && peerIterator->second.HasAcked)
+		{
+			for (auto&& snapshot : fSentSnapshots)
+			{
+				if (snapshot.Id == peerIterator->second.AckedSnapshotId)
+				{
+					baseSnapshotPointer = &snapshot;
+					break;
+				}
+			}
+		}
+		fPacketBytes.clear();
+		fPacketBytes.push_back((char)(baseSnapshotPointer ? kDeltaPacketType : kFullPacketType));
+		Write32(fPacketBytes, fSession);
+		Write16(fPacketBytes, snapshotId);
+		if (baseSnapshotPointer)
+		{
+			Write16(fPacketBytes, baseSnapshotPointer->Id);
+		}
+		auto headerByteCount = fPacketBytes.size();
+		EncodeDelta(bytesPointer, byteCount, baseSnapshotPointer ? &baseSnapshotPointer->Bytes : nullptr);
+
+		// Send the packet unreliably. A lost snapshot is superseded by the next one.
+		bool wasSent = networkingPointer->Send(
+				userId, fPacketBytes.data(), fPacketBytes.size(), galaxy::api::P2P_SEND_UNRELIABLE, (uint8_t)fChannel);
+		if (wasSent)
+		{
+			fStatistics.SentCount++;
+			if (!baseSnapshotPointer)
+			{
+				fStatistics.FullSentCount++;
+			}
+			fStatistics.SnapshotByteCount += byteCount;
+			fStatistics.EncodedByteCount += fPacketBytes.size() - headerByteCount;
+		}
+		else
+		{
+			wereAllSent = false;
+		}
+	}
+
+	// Keep the snapshot to encode against once acknowledged, reusing the oldest snapshot's memory if at capacity.
+	Snapshot snapshot;
+	if (fSentSnapshots.size() >= kHistoryCount)
+	{
+		snapshot.Bytes.swap(fSentSnapshots.front().Bytes);
+		fSentSnapshots.pop_front();
+	}
+	snapshot.Id = snapshotId;
+	snapshot.Bytes.assign(bytesPointer, bytesPointer + byteCount);
+	fSentSnapshots.push_back(std::move(snapshot));
+	return wereAllSent;
+}
+
+void SnapshotReplicator::Receive(P2PNetworking::Batch& batch)
+{
+	// Do not continue if disabled.
+	if (fChannel < 0)
+	{
+		return;
+	}
+
+	// Move the snapshot channel's packets out of the batch, keeping the other packets in order.
+	auto& packets = batch.Packets;
+	fReceivedPackets.clear();
+	size_t keptCount = 0;
+	for (size_t index = 0; index < packets.size(); index++)
+	{
+		if ((packets[index].Channel == (uint8_t)fChannel) && (packets[index].Stream < 0))
+		{
+			fReceivedPackets.push_back(packets[index]);
+		}
+		else
+		{
+			packets[keptCount++] = packets[index];
+		}
+	}
+	packets.resize(keptCount);
+
+	// Handle the packets, appending the reconstructed snapshots to the batch.
+	for (auto&& packet : fReceivedPackets)
+	{
+		ReceivePacket(packet.SenderId, packet.ByteOffset, packet.ByteCount, batch);
+	}
+}
+
+const SnapshotReplicator::Statistics& SnapshotReplicator::GetStatistics() const
+{
+	return fStatistics;
+}
+
+void SnapshotReplicator::OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason /*leaveReason*/)
+{
+	// Forget every peer we no longer share a lobby with.
+	// Note: The roster of the lobby left may already be gone, so peers are kept by the lobbies we're still in.
+	std::unordered_map<uint64_t, Peer> keptPeerMap;
+	auto rosterPointer = fContext.GetLobbyRoster();
+	for (auto&& lobbyIdValue : fContext.GetLobbyMembership()->GetLobbyIds())
+	{
+		galaxy::api::GalaxyID lobbyId(lobbyIdValue);
+		auto memberIdsPointer = (lobbyId != lobbyID) ? rosterPointer->GetMembersOf(lobbyId) : nullptr;
+		if (!memberIdsPointer)
+		{
+			continue;
+		}
+		for (auto&& memberId : *memberIdsPointer)
+		{
+			auto peerIterator = fPeerMap.find(memberId.ToUint64());
+			if (peerIterator != fPeerMap.end())
+			{
+				keptPeerMap[peerIterator->first] = std::move(peerIterator->second);
+				fPeerMap.erase(peerIterator);
+			}
+		}
+	}
+	fPeerMap.swap(keptPeerMap);
+}
+
+void SnapshotReplicator::OnLobbyMemberStateChanged(
+	const galaxy::api::GalaxyID& /*lobbyID*/, const galaxy::api::GalaxyID& memberID,
+	galaxy::api::LobbyMemberStateChange memberStateChange)
+{
+	// Forget a departed member's snapshots. Should it come back, both sides start over from a full snapshot.
+	if (memberStateChange != galaxy::api::LOBBY_MEMBER_STATE_CHANGED_ENTERED)
+	{
+		fPeerMap.erase(memberID.ToUint64());
+	}
+}
+
+void SnapshotReplicator::EncodeDelta(const char* bytesPointer, size_t byteCount, const std::vector<char>* basePointer)
+{
+	// Write the snapshot's size, since it may differ from its base's.
+	WriteVarint(fPacketBytes, byteCount);
+
+	// Write the XOR of the snapshot and its base as runs of zero bytes, each followed by a run of literal bytes.
+	// Note: A lone zero byte is kept within its literal run since splitting the run would cost more than the byte.
+	auto baseByteCount = basePointer ? basePointer->size() : 0;
+	auto baseBytesPointer = basePointer ? basePointer->data() : nullptr;
+	auto xorAt = [=](size_t index) -> char
+	{
+		return (index < baseByteCount) ? (char)(bytesPointer[index] ^ baseBytesPointer[index]) : bytesPointer[index];
+	};
+	size_t index = 0;
+	while (index < byteCount)
+	{
+		auto zeroStartIndex = index;
+		while ((index < byteCount) && ('\0' == xorAt(index)))
+		{
+			index++;
+		}
+		if (index >= byteCount)
+		{
+			// Trailing unchanged bytes are implied by the snapshot's size.
+			break;
+		}
+		auto literalStartIndex = index;
+		while (index < byteCount)
+		{
+			if (('\0' == xorAt(index)) && (((index + 1) >= byteCount) || ('\0' == xorAt(index + 1))))
+			{
+				break;
+			}
+			index++;
+		}
+		WriteVarint(fPacketBytes, literalStartIndex - zeroStartIndex);
+		WriteVarint(fPacketBytes, index - literalStartIndex);
+		for (auto literalIndex = literalStartIndex; literalIndex < index; literalIndex++)
+		{
+			fPacketBytes.push_back(xorAt(literalIndex));
+		}
+	}
+}
+
+bool SnapshotReplicator::DecodeDelta(
+	const uint8_t* deltaPointer, size_t deltaByteCount,
+	const std::vector<char>* basePointer, std::vector<char>& bytes)
+{
+	// Start from the base, truncated or zero padded to the snapshot's size.
+	size_t offset = 0;
+	uint64_t byteCount = 0;
+	if (!ReadVarint(deltaPointer, deltaByteCount, &offset, &byteCount) || (byteCount > kMaxSnapshotByteCount))
+	{
+		return false;
+	}
+	bytes.clear();
+	if (basePointer)
+	{
+		bytes.assign(basePointer->begin(), basePointer->begin() + (std::min)(basePointer->size(), (size_t)byteCount));
+	}
+	bytes.resize((size_t)byteCount, '\0');
+
+	// Apply the runs of changed bytes.
+	size_t index = 0;
+	while (offset < deltaByteCount)
+	{
+		uint64_t zeroCount = 0;
+		uint64_t literalCount = 0;
+		if (!ReadVarint(deltaPointer, deltaByteCount, &offset, &zeroCount) ||
+		    !ReadVarint(deltaPointer, deltaByteCount, &offset, &literalCount))
+		{
+			return false;
+		}
+		if ((zeroCount > (byteCount - index)) || (literalCount > (byteCount - index - zeroCount)) ||
+		    (literalCount > (deltaByteCount - offset)))
+		{
+			return false;
+		}
+		index += (size_t)zeroCount;
+		for (uint64_t literalIndex = 0; literalIndex < literalCount; literalIndex++)
+		{
+			bytes[index++] ^= (char)deltaPointer[offset++];
+		}
+	}
+	return true;
+}
+
+void SnapshotReplicator::ReceivePacket(
+	const galaxy::api::GalaxyID& userId, size_t byteOffset, size_t byteCount, P2PNetworking::Batch& batch)
+{
+	// Fetch the packet's type, session and snapshot ID.
+	// Note: The bytes are read before any snapshot is appended, which may move the arena.
+	auto bytesPointer = (const uint8_t*)batch.Bytes.data() + byteOffset;
+	if (byteCount < kHeaderByteCount)
+	{
+		fStatistics.DecodeDropCount++;
+		return;
+	}
+	auto packetType = bytesPointer[0];
+	auto session = Read32(bytesPointer + 1);
+	auto snapshotId = Read16(bytesPointer + 5);
+	auto& peer = fPeerMap[userId.ToUint64()];
+
+	// Move the peer's base forward if this acknowledges a newer snapshot than the last.
+	// Acknowledgements of a previous session's snapshots are ignored, since their IDs may be reused.
+	if (kAckPacketType == packetType)
+	{
+		if (session != fSession)
+		{
+			return;
+		}
+		if (!peer.HasAcked || IsSnapshotIdNewer(snapshotId, peer.AckedSnapshotId))
+		{
+			peer.HasAcked = true;
+			peer.AckedSnapshotId = snapshotId;
+		}
+		return;
+	}
+
+	// Forget the peer's received snapshots if it has started a new session, since its IDs start over.
+	// Late packets from the session it replaced are dropped so that they cannot switch it back.
+	if ((0 == session) || (session == peer.RetiredRemoteSession))
+	{
+		fStatistics.DecodeDropCount++;
+		return;
+	}
+	if (session != peer.RemoteSession)
+	{
+		peer.RetiredRemoteSession = peer.RemoteSession;
+		peer.RemoteSession = session;
+		peer.HasDelivered = false;
+		peer.ReceivedSnapshots.clear();
+	}
+
+	// Find the base the snapshot was encoded against. It has to be one we have acknowledged and still keep.
+	const std::vector<char>* basePointer = nullptr;
+	size_t headerByteCount = kHeaderByteCount;
+	if (kDeltaPacketType == packetType)
+	{
+		if (byteCount < kDeltaHeaderByteCount)
+		{
+			fStatistics.DecodeDropCount++;
+			return;
+		}
+		auto baseSnapshotId = Read16(bytesPointer + 7);
+		headerByteCount = kDeltaHeaderByteCount;
+		for (auto&& snapshot : peer.ReceivedSnapshots)
+		{
+			if (snapshot.Id == baseSnapshotId)
+			{
+				basePointer = &snapshot.Bytes;
+				break;
+			}
+		}
+		if (!basePointer)
+		{
+			fStatistics.DecodeDropCount++;
+			return;
+		}
+	}
+	else if (packetType != kFullPacketType)
+	{
+		fStatistics.DecodeDropCount++;
+		return;
+	}
+
+	// Reconstruct the snapshot.
+	if (!DecodeDelta(bytesPointer + headerByteCount, byteCount - headerByteCount, basePointer, fSnapshotBytes))
+	{
+		fStatistics.DecodeDropCount++;
+		return;
+	}
+
+	// Keep the snapshot as a base for the sender's next deltas.
+	// A kept snapshot with the same ID is replaced, since the sender encodes against the snapshot it last sent
+	// with that ID, which differs from the kept one if the ID has wrapped around.
+	auto keptIterator = std::find_if(
+			peer.ReceivedSnapshots.begin(), peer.ReceivedSnapshots.end(),
+			[snapshotId](const Snapshot& snapshot) { return snapshot.Id == snapshotId; });
+	Snapshot snapshot;
+	if (keptIterator != peer.ReceivedSnapshots.end())
+	{
+		snapshot.Bytes.swap(keptIterator->Bytes);
+		peer.ReceivedSnapshots.erase(keptIterator);
+	}
+	else if (peer.ReceivedSnapshots.size() >= kHistoryCount)
+	{
+		snapshot.Bytes.swap(peer.ReceivedSnapshots.front().Bytes);
+		peer.ReceivedSnapshots.pop_front();
+	}
+	snapshot.Id = snapshotId;
+	snapshot.Bytes.assign(fSnapshotBytes.begin(), fSnapshotBytes.end());
+	peer.ReceivedSnapshots.push_back(std::move(snapshot));
+
+	// Acknowledge the snapshot right away, so that the sender's next delta can be encoded against it.
+	fPacketBytes.clear();
+	fPacketBytes.push_back((char)kAckPacketType);
+	Write32(fPacketBytes, session);
+	Write16(fPacketBytes, snapshotId);
+	fContext.GetP2PNetworking()->Send(
+			userId, fPacketBytes.data(), fPacketBytes.size(), galaxy::api::P2P_SEND_UNRELIABLE, (uint8_t)fChannel);
+
+	// Deliver the snapshot, unless a newer one has already been delivered.
+	if (peer.HasDelivered && !IsSnapshotIdNewer(snapshotId, peer.DeliveredSnapshotId))
+	{
+		return;
+	}
+	peer.HasDelivered = true;
+	peer.DeliveredSnapshotId = snapshotId;
+	P2PNetworking::Packet packet;
+	packet.SenderId = userId;
+	packet.Channel = (uint8_t)fChannel;
+	packet.Stream = -1;
+	packet.ByteOffset = batch.Bytes.size();
+	packet.ByteCount = fSnapshotBytes.size();
+	batch.Bytes.insert(batch.Bytes.end(), fSnapshotBytes.begin(), fSnapshotBytes.end());
+	batch.Packets.push_back(packet);
+	fStatistics.DeliveredCount++;
+}
@@ -0,0 +1,221 @@
+// ----------------------------------------------------------------------------
+//
+// SnapshotReplicator.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <deque>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "GalaxyApi.h"
+#include "P2PNetworking.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Replicates game state snapshots to peers as deltas against the last snapshot each peer has acknowledged.
+
+  A snapshot is XORed against the peer's acknowledged snapshot, padded with zeros to the same size, and the
+  result is sent as alternating varint run lengths of unchanged (zero) bytes and literal changed bytes. A peer
+  which has not acknowledged any of the last kHistoryCount snapshots is sent a full snapshot, encoded the same
+  way against an empty one. Snapshots are sent as unreliable P2P packets on a dedicated SDK channel.
+
+  Receivers reconstruct every snapshot against the base it was encoded with, acknowledge it right away and
+  deliver it to Lua by the P2PNetworking's "p2pPackets" event, on the snapshot channel. Snapshots received
+  out of order, older than the last one delivered from their sender, are acknowledged but not delivered.
+
+  Every packet carries the sender's random session nonce, picked anew whenever the replicator is (re)enabled, and
+  acknowledgements echo the nonce of the snapshot they acknowledge. A peer restarting its session therefore has its
+  received snapshots forgotten instead of being taken as bases for its new IDs, and stale acknowledgements from a
+  previous session are ignored. A peer's state is also forgotten when it leaves the lobby, or when the user does.
+ */
+class SnapshotReplicator
+:	public galaxy::api::GlobalLobbyLeftListener,
+	public galaxy::api::GlobalLobbyMemberStateListener
+{
+	public:
+		/** Number of sent and received snapshots kept to encode and decode deltas against. */
+		static const size_t kHistoryCount;
+
+		/** Largest snapshot which can be sent. */
+		static const size_t kMaxSnapshotByteCount;
+
+		/** Running totals of the replicator's traffic. */
+		struct Statistics
+		{
+			Statistics();
+
+			/** Number of snapshots sent to a peer. */
+			uint64_t SentCount;
+
+			/** Number of snapshots sent in full since the peer had no acknowledged snapshot to encode against. */
+			uint64_t FullSentCount;
+
+			/** Number of snapshot bytes given to Send(), once per peer sent to. */
+			uint64_t SnapshotByteCount;
+
+			/** Number of encoded bytes sent, excluding packet headers. */
+			uint64_t EncodedByteCount;
+
+			/** Number of snapshots received and delivered to Lua. */
+			uint64_t DeliveredCount;
+
+			/** Number of received snapshots dropped for being malformed or encoded against an unknown base. */
+			uint64_t DecodeDropCount;
+		};
+
+		/**
+		  Creates a new replicator, disabled until given a channel.
+		  @param context The runtime context providing the P2PNetworking to send and receive with.
+		 */
+		SnapshotReplicator(RuntimeContext& context);
+
+		virtual ~SnapshotReplicator();
+
+		/**
+		  Gets the SDK channel snapshots are sent on.
+		  @return Returns the channel. Returns -1 if the replicator is disabled.
+		 */
+		int GetChannel() const;
+
+		/**
+		  Sets the SDK channel to send snapshots on. Changing it forgets all snapshots and peers and starts a new session.
+		  The P2PNetworking is told to subscribe to the new channel, and to drop the old one.
+		  @param channel The channel between 0 and 255. Set to -1 to disable the replicator.
+		 */
+		void SetChannel(int channel);
+
+		/**
+		  Sends a snapshot to the given peers, each as a delta against the last snapshot it has acknowledged.
+		  @param userIds The peers to send to.
+		  @param bytesPointer The snapshot's bytes.
+		  @param byteCount Number of bytes in the snapshot. Cannot exceed kMaxSnapshotByteCount.
+		  @return Returns true if the snapshot was sent to all peers.
+		          Returns false if disabled, if given invalid arguments or if rejected by GOG for any peer.
+		 */
+		bool Send(const std::vector<galaxy::api::GalaxyID>& userIds, const char* bytesPointer, size_t byteCount);
+
+		/**
+		  To be called by the P2PNetworking before dispatching a batch. Removes the snapshot channel's packets from
+		  the batch, handles acknowledgements and appends the reconstructed snapshots to deliver.
+		  @param batch The batch about to be dispatched to Lua.
+		 */
+		void Receive(P2PNetworking::Batch& batch);
+
+		/** Gets the replicator's running totals. */
+		const Statistics& GetStatistics() const;
+
+		virtual void OnLobbyLeft(const galaxy::api::GalaxyID& lobbyID, LobbyLeaveReason leaveReason);
+		virtual void OnLobbyMemberStateChanged(
+				const galaxy::api::GalaxyID& lobbyID, const galaxy::api::GalaxyID& memberID,
+				galaxy::api::LobbyMemberStateChange memberStateChange);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		SnapshotReplicator(const SnapshotReplicator&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const SnapshotReplicator&) = delete;
+
+		/** A sent or received snapshot, kept to encode or decode deltas against. */
+		struct Snapshot
+		{
+			uint16_t Id;
+			std::vector<char> Bytes;
+		};
+
+		/** Replication state of one peer. */
+		struct Peer
+		{
+			Peer();
+
+			/** Set true once the peer has acknowledged a snapshot. */
+			bool HasAcked;
+
+			/** ID of the latest snapshot the peer has acknowledged. */
+			uint16_t AckedSnapshotId;
+
+			/** Set true once a snapshot has been delivered from the peer. */
+			bool HasDelivered;
+
+			/** ID of the latest snapshot delivered from the peer. */
+			uint16_t DeliveredSnapshotId;
+
+			/** Session nonce of the peer's received snapshots. Zero until a snapshot has been received. */
+			uint32_t RemoteSession;
+
+			/** The peer's previous session nonce, whose late packets are ignored. Zero if none. */
+			uint32_t RetiredRemoteSession;
+
+			/** The latest snapshots received from the peer, oldest first. */
+			std::deque<Snapshot> ReceivedSnapshots;
+		};
+
+		/**
+		  Writes the given snapshot's delta against the given base to "fPacketBytes".
+		  @param bytesPointer The snapshot's bytes.
+		  @param byteCount Number of bytes in the snapshot.
+		  @param basePointer The base snapshot to encode against. Set to null to encode the full snapshot.
+		 */
+		void EncodeDelta(const char* bytesPointer, size_t byteCount, const std::vector<char>* basePointer);
+
+		/**
+		  Reconstructs a snapshot from its delta against the given base.
+		  @param deltaPointer The encoded delta.
+		  @param deltaByteCount Number of bytes in the delta.
+		  @param basePointer The base snapshot the delta was encoded against. Set to null if encoded in full.
+		  @param bytes Set to the reconstructed snapshot.
+		  @return Returns true if reconstructed. Returns false if the delta is malformed.
+		 */
+		static bool DecodeDelta(
+				const uint8_t* deltaPointer, size_t deltaByteCount,
+				const std::vector<char>* basePointer, std::vector<char>& bytes);
+
+		/**
+		  Handles one packet received on the snapshot channel.
+		  @param userId The peer who sent the packet.
+		  @param byteOffset Offset of the packet's first byte within the batch's arena.
+		  @param byteCount Number of bytes in the packet.
+		  @param batch The batch holding the packet, to append the reconstructed snapshot to.
+		 */
+		void ReceivePacket(
+				const galaxy::api::GalaxyID& userId, size_t byteOffset, size_t byteCount, P2PNetworking::Batch& batch);
+
+		/** The runtime context providing the P2PNetworking. */
+		RuntimeContext& fContext;
+
+		/** The SDK channel snapshots are sent on. -1 if disabled. */
+		int fChannel;
+
+		/** Random nonzero nonce written to every packet sent, picked anew whenever the channel changes. */
+		uint32_t fSession;
+
+		/** ID of the next snapshot sent. */
+		uint16_t fNextSnapshotId;
+
+		/** The latest snapshots sent, oldest first. */
+		std::deque<Snapshot> fSentSnapshots;
+
+		/** State of every peer snapshots were exchanged with, keyed by GalaxyID::ToUint64(). */
+		std::unordered_map<uint64_t, Peer> fPeerMap;
+
+		/** Reusable buffer which outgoing packets are written to. */
+		std::vector<char> fPacketBytes;
+
+		/** Reusable buffer which the snapshot channel's packets are moved to while a batch is being filtered. */
+		std::vector<P2PNetworking::Packet> fReceivedPackets;
+
+		/** Reusable buffer which received snapshots are reconstructed into. */
+		std::vector<char> fSnapshotBytes;
+
+		/** The replicator's running totals. */
+		Statistics fStatistics;
+};
@@ -0,0 +1,113 @@
+// ----------------------------------------------------------------------------
+//
+// SpscQueue.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+
+
+/**
+  Bounded lock-free queue passing items from exactly one producer thread to exactly one consumer thread.
+
+  Items are filled and read in place within a ring of preallocated slots, which are never destroyed, so that
+  items such as byte vectors keep their capacity when their slot is reused.
+ */
+template<typename TItem>
+class SpscQueue
+{
+	public:
+		/**
+		  Creates a new queue.
+		  @param capacity Maximum number of items the queue can hold.
+		 */
+		SpscQueue(size_t capacity)
+		:	fSlots(capacity + 1),
+			fReadIndex(0),
+			fWriteIndex(0)
+		{
+		}
+
+		/**
+		  Fetches the next free slot for the producer to fill. The slot holds whatever item it held last.
+		  The filled item is only made available to the consumer by calling EndPush().
+		  @return Returns a pointer to the slot. Returns null if the queue is full.
+		 */
+		TItem* BeginPush()
+		{
+			auto writeIndex = fWriteIndex.load(std::memory_order_relaxed);
+			if (NextIndexOf(writeIndex) == fReadIndex.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+			return &fSlots[writeIndex];
+		}
+
+		/** Makes the slot fetched by the last BeginPush() call available to the consumer. */
+		void EndPush()
+		{
+			auto writeIndex = fWriteIndex.load(std::memory_order_relaxed);
+			fWriteIndex.store(NextIndexOf(writeIndex), std::memory_order_release);
+		}
+
+		/**
+		  Fetches the oldest item for the consumer to read. The item is only released by calling Pop().
+		  @return Returns a pointer to the item. Returns null if the queue is empty.
+		 */
+		TItem* GetFront()
+		{
+			auto readIndex = fReadIndex.load(std::memory_order_relaxed);
+			if (readIndex == fWriteIndex.load(std::memory_order_acquire))
+			{
+				return nullptr;
+			}
+			return &fSlots[readIndex];
+		}
+
+		/** Releases the item fetched by the last GetFront() call, allowing the producer to reuse its slot. */
+		void Pop()
+		{
+			auto readIndex = fReadIndex.load(std::memory_order_relaxed);
+			fReadIndex.store(NextIndexOf(readIndex), std::memory_order_release);
+		}
+
+		/**
+		  Gets the number of items in the queue. Can be called from any thread, in which case the count is
+		  only a snapshot which the producer and consumer may change right away.
+		 */
+		size_t GetCount() const
+		{
+			auto readIndex = fReadIndex.load(std::memory_order_acquire);
+			auto writeIndex = fWriteIndex.load(std::memory_order_acquire);
+			return (writeIndex >= readIndex) ? (writeIndex - readIndex) : (fSlots.size() - readIndex + writeIndex);
+		}
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		SpscQueue(const SpscQueue&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const SpscQueue&) = delete;
+
+		/** Gets the index of the slot following the given one in the ring. */
+		size_t NextIndexOf(size_t index) const
+		{
+			return ((index + 1) < fSlots.size()) ? (index + 1) : 0;
+		}
+
+		/** Ring of slots. One slot is always left unused to tell a full queue from an empty one. */
+		std::vector<TItem> fSlots;
+
+		/** Index of the next slot to be read. Only written to by the consumer. */
+		std::atomic<size_t> fReadIndex;
+
+		/** Index of the next slot to be filled. Only written to by the producer. */
+		std::atomic<size_t> fWriteIndex;
+};
@@ -0,0 +1,173 @@
+// --------------------------------------------------------------------------------
+//
+// UserFinder.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "UserFinder.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include <memory>
+#include <vector>
+
+
+const int UserFinder::kFoundTimeToLiveInSeconds = 600;
+const int UserFinder::kNotFoundTimeToLiveInSeconds = 60;
+const int UserFinder::kErrorTimeToLiveInSeconds = 5;
+const int UserFinder::kRequestTimeoutInSeconds = 30;
+
+UserFinder::UserFinder(RuntimeContext& context)
+:	fContext(context),
+	fLastPruneTime(std::chrono::steady_clock::now())
+{
+}
+
+UserFinder::~UserFinder()
+{
+}
+
+bool UserFinder::Find(const char* userSpecifier)
+{
+	// Validate.
+	if (!userSpecifier || ('\0' == userSpecifier[0]))
+	{
+		return false;
+	}
+
+	// Answer from the cache if possible, or merge with an in-flight request for the same specifier.
+	auto currentTime = std::chrono::steady_clock::now();
+	auto iterator = fEntryMap.find(userSpecifier);
+	if (iterator != fEntryMap.end())
+	{
+		auto& entry = iterator->second;
+		if (entry.IsPending)
+		{
+			return true;
+		}
+		if (currentTime < entry.Time)
+		{
+			auto taskPointer = std::make_shared<DispatchUserFindEventTask>();
+			taskPointer->AcquireEventDataFrom(
+					userSpecifier, entry.UserId,
+					entry.FailureReasonName.empty() ? nullptr : entry.FailureReasonName.c_str(), true);
+			fContext.QueueDispatchEventTask(taskPointer);
+			return true;
+		}
+	}
+
+	// Send the request.
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer)
+	{
+		return false;
+	}
+	auto& entry = fEntryMap[userSpecifier];
+	entry.IsPending = true;
+	entry.UserId = galaxy::api::GalaxyID();
+	entry.FailureReasonName.clear();
+	entry.Time = currentTime;
+	friendsPointer->FindUser(userSpecifier);
+	return true;
+}
+
+void UserFinder::Process()
+{
+	// Only scan the cache once per second.
+	auto currentTime = std::chrono::steady_clock::now();
+	if ((currentTime - fLastPruneTime) < std::chrono::seconds(1))
+	{
+		return;
+	}
+	fLastPruneTime = currentTime;
+
+	// Fail timed out lookups and discard expired results.
+	std::vector<std::string> timedOutSpecifiers;
+	for (auto iterator = fEntryMap.begin(); iterator != fEntryMap.end();)
+	{
+		auto& entry = iterator->second;
+		if (entry.IsPending)
+		{
+			if ((currentTime - entry.Time) >= std::chrono::seconds(kRequestTimeoutInSeconds))
+			{
+				timedOutSpecifiers.push_back(iterator->first);
+			}
+			++iterator;
+		}
+		else if (currentTime >= entry.Time)
+		{
+			iterator = fEntryMap.erase(iterator);
+		}
+		else
+		{
+			++iterator;
+		}
+	}
+	for (auto&& userSpecifier : timedOutSpecifiers)
+	{
+		CompleteLookup(userSpecifier, galaxy::api::GalaxyID(), "timeout");
+	}
+}
+
+void UserFinder::OnUserFindSuccess(const char* userSpecifier, galaxy::api::GalaxyID userID)
+{
+	if (userSpecifier)
+	{
+		CompleteLookup(userSpecifier, userID, nullptr);
+	}
+}
+
+void UserFinder::OnUserFindFailure(const char* userSpecifier, FailureReason failureReason)
+{
+	// Validate.
+	if (!userSpecifier)
+	{
+		return;
+	}
+
+	// Fetch the failure's name.
+	const char* failureReasonName = "undefined";
+	switch (failureReason)
+	{
+		case galaxy::api::IUserFindListener::FAILURE_REASON_USER_NOT_FOUND:
+			failureReasonName = "userNotFound";
+			break;
+		case galaxy::api::IUserFindListener::FAILURE_REASON_CONNECTION_FAILURE:
+			failureReasonName = "connectionFailure";
+			break;
+		default:
+			break;
+	}
+	CompleteLookup(userSpecifier, galaxy::api::GalaxyID(), failureReasonName);
+}
+
+void UserFinder::CompleteLookup(
+	const std::string& userSpecifier, const galaxy::api::GalaxyID& userId, const char* failureReasonName)
+{
+	// Ignore responses to lookups that we didn't make.
+	auto iterator = fEntryMap.find(userSpecifier);
+	if ((iterator == fEntryMap.end()) || !iterator->second.IsPending)
+	{
+		return;
+	}
+
+	// Cache the result. "User not found" is a definitive answer and is kept longer than transient errors.
+	int timeToLiveInSeconds = kFoundTimeToLiveInSeconds;
+	if (failureReasonName)
+	{
+		bool isNotFound = (std::string("userNotFound") == failureReasonName);
+		timeToLiveInSeconds = isNotFound ? kNotFoundTimeToLiveInSeconds : kErrorTimeToLiveInSeconds;
+	}
+	auto& entry = iterator->second;
+	entry.IsPending = false;
+	entry.UserId = userId;
+	entry.FailureReasonName = failureReasonName ? failureReasonName : "";
+	entry.Time = std::chrono::steady_clock::now() + std::chrono::seconds(timeToLiveInSeconds);
+
+	// Notify Lua.
+	auto taskPointer = std::make_shared<DispatchUserFindEventTask>();
+	taskPointer->AcquireEventDataFrom(userSpecifier.c_str(), userId, failureReasonName, false);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
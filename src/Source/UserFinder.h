@@ -0,0 +1,109 @@
+// ----------------------------------------------------------------------------
+//
+// UserFinder.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Front-end to IFriends::FindUser() which remembers results.
+
+  Successful lookups and failures are cached per user specifier with separate time-to-live durations.
+  Lookups of a cached specifier are answered without contacting the backend, and identical lookups made
+  while a FindUser() request is in-flight are merged into that request.
+
+  A "userFind" event is dispatched to Lua for every answered lookup.
+ */
+class UserFinder : public galaxy::api::GlobalUserFindListener
+{
+	public:
+		/** Number of seconds a found user is cached for. */
+		static const int kFoundTimeToLiveInSeconds;
+
+		/** Number of seconds a "user not found" result is cached for. */
+		static const int kNotFoundTimeToLiveInSeconds;
+
+		/** Number of seconds other failures, such as connection failures, are cached for. */
+		static const int kErrorTimeToLiveInSeconds;
+
+		/** Number of seconds to wait for a FindUser() response before failing the lookup. */
+		static const int kRequestTimeoutInSeconds;
+
+		/**
+		  Creates a new user finder.
+		  @param context The runtime context that will dispatch this finder's events to Lua.
+		 */
+		UserFinder(RuntimeContext& context);
+
+		virtual ~UserFinder();
+
+		/**
+		  Looks up the user matching the given specifier, such as a user name.
+		  @param userSpecifier The specifier to search by. Cannot be null or empty.
+		  @return Returns true if the lookup was answered from the cache, merged, or sent to the backend.
+
+		          Returns false if given an invalid specifier or if the GOG SDK is not initialized.
+		 */
+		bool Find(const char* userSpecifier);
+
+		/**
+		  Fails timed out lookups and discards expired cache entries.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		virtual void OnUserFindSuccess(const char* userSpecifier, galaxy::api::GalaxyID userID);
+		virtual void OnUserFindFailure(const char* userSpecifier, FailureReason failureReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		UserFinder(const UserFinder&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const UserFinder&) = delete;
+
+		struct Entry
+		{
+			/** Set true while a FindUser() request for this entry is awaiting a response. */
+			bool IsPending;
+
+			/** The found user. Invalid if the lookup failed. */
+			galaxy::api::GalaxyID UserId;
+
+			/** Name of the failure reason. Empty if the user was found. */
+			std::string FailureReasonName;
+
+			/** Time the request was sent while pending, or the time the result expires once answered. */
+			std::chrono::steady_clock::time_point Time;
+		};
+
+		/**
+		  Stores the given result in the cache and dispatches a "userFind" event to Lua.
+		  @param userSpecifier The specifier that was searched for.
+		  @param userId The found user. Set to an invalid ID on failure.
+		  @param failureReasonName Set to null on success or to a failure description for errors.
+		 */
+		void CompleteLookup(const std::string& userSpecifier, const galaxy::api::GalaxyID& userId, const char* failureReasonName);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/** Pending lookups and cached results keyed by user specifier. */
+		std::unordered_map<std::string, Entry> fEntryMap;
+
+		/** Time Process() last pruned expired entries from the cache. */
+		std::chrono::steady_clock::time_point fLastPruneTime;
+};
@@ -0,0 +1,208 @@
+// --------------------------------------------------------------------------------
+//
+// UserInformationScheduler.cpp
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// --------------------------------------------------------------------------------
+
+#include "UserInformationScheduler.h"
+#include "DispatchEventTask.h"
+#include "RuntimeContext.h"
+#include <memory>
+#include <vector>
+
+
+const int UserInformationScheduler::kMaxConcurrentRequests = 8;
+const int UserInformationScheduler::kMaxRequestsPerFrame = 4;
+const int UserInformationScheduler::kRequestTimeoutInSeconds = 30;
+
+UserInformationScheduler::UserInformationScheduler(RuntimeContext& context)
+:	fContext(context),
+	fInFlightCount(0)
+{
+}
+
+UserInformationScheduler::~UserInformationScheduler()
+{
+}
+
+bool UserInformationScheduler::Request(const galaxy::api::GalaxyID& userId, bool isVisible)
+{
+	// Validate.
+	if (!userId.IsValid() || (userId.GetIDType() != galaxy::api::GalaxyID::ID_TYPE_USER))
+	{
+		return false;
+	}
+
+	// Merge with an existing request for the same user, promoting it if it is now visible on screen.
+	auto iterator = fRequestMap.find(userId.ToUint64());
+	if (iterator != fRequestMap.end())
+	{
+		if (isVisible && (RequestState::kQueued == iterator->second.State))
+		{
+			iterator->second.State = RequestState::kQueuedVisible;
+			fVisibleQueue.push_back(userId.ToUint64());
+		}
+		return true;
+	}
+
+	// Respond immediately if GOG already has this user's information cached.
+	auto friendsPointer = galaxy::api::Friends();
+	if (friendsPointer && friendsPointer->IsUserInformationAvailable(userId))
+	{
+		CompleteRequest(userId, nullptr);
+		return true;
+	}
+
+	// Queue the request to be sent by the Process() method.
+	RequestInfo requestInfo;
+	requestInfo.State = isVisible ? RequestState::kQueuedVisible : RequestState::kQueued;
+	fRequestMap[userId.ToUint64()] = requestInfo;
+	if (isVisible)
+	{
+		fVisibleQueue.push_back(userId.ToUint64());
+	}
+	else
+	{
+		fNormalQueue.push_back(userId.ToUint64());
+	}
+	return true;
+}
+
+void UserInformationScheduler::Process()
+{
+	auto currentTime = std::chrono::steady_clock::now();
+
+	// Give up on requests that the backend never responded to so that they stop taking up a slot.
+	if (fInFlightCount > 0)
+	{
+		std::vector<uint64_t> expiredIds;
+		for (auto&& pair : fRequestMap)
+		{
+			if ((RequestState::kInFlight == pair.second.State) &&
+			    ((currentTime - pair.second.SentTime) >= std::chrono::seconds(kRequestTimeoutInSeconds)))
+			{
+				expiredIds.push_back(pair.first);
+			}
+		}
+		for (auto&& id : expiredIds)
+		{
+			CompleteRequest(galaxy::api::GalaxyID(id), "timeout");
+		}
+	}
+
+	// Do not continue if there is nothing to send.
+	if (fVisibleQueue.empty() && fNormalQueue.empty())
+	{
+		return;
+	}
+	auto friendsPointer = galaxy::api::Friends();
+	if (!friendsPointer)
+	{
+		return;
+	}
+
+	// Send queued requests, visible users first, while under the concurrency limit.
+	int requestsSent = 0;
+	while ((fInFlightCount < kMaxConcurrentRequests) && (requestsSent < kMaxRequestsPerFrame))
+	{
+		// Pop the next user, skipping entries which were promoted or completed since they were queued.
+		uint64_t id;
+		RequestState expectedState;
+		if (!fVisibleQueue.empty())
+		{
+			id = fVisibleQueue.front();
+			fVisibleQueue.pop_front();
+			expectedState = RequestState::kQueuedVisible;
+		}
+		else if (!fNormalQueue.empty())
+		{
+			id = fNormalQueue.front();
+			fNormalQueue.pop_front();
+			expectedState = RequestState::kQueued;
+		}
+		else
+		{
+			break;
+		}
+		auto iterator = fRequestMap.find(id);
+		if ((iterator == fRequestMap.end()) || (iterator->second.State != expectedState))
+		{
+			continue;
+		}
+
+		// Skip the backend if the information has arrived by other means while this request was queued,
+		// such as GOG automatically fetching it for friends and lobby members.
+		galaxy::api::GalaxyID userId(id);
+		if (friendsPointer->IsUserInformationAvailable(userId))
+		{
+			CompleteRequest(userId, nullptr);
+			continue;
+		}
+
+		// Send the request.
+		iterator->second.State = RequestState::kInFlight;
+		iterator->second.SentTime = currentTime;
+		fInFlightCount++;
+		requestsSent++;
+		friendsPointer->RequestUserInformation(userId);
+	}
+}
+
+int UserInformationScheduler::GetQueuedCount() const
+{
+	return (int)fRequestMap.size() - fInFlightCount;
+}
+
+int UserInformationScheduler::GetInFlightCount() const
+{
+	return fInFlightCount;
+}
+
+void UserInformationScheduler::OnUserInformationRetrieveSuccess(galaxy::api::GalaxyID userID)
+{
+	// Complete the request whether it was sent by us or not. This also covers queued users whose
+	// information was fetched by someone else before we got around to sending their request.
+	if (fRequestMap.find(userID.ToUint64()) != fRequestMap.end())
+	{
+		CompleteRequest(userID, nullptr);
+	}
+}
+
+void UserInformationScheduler::OnUserInformationRetrieveFailure(
+	galaxy::api::GalaxyID userID, FailureReason failureReason)
+{
+	// Only fail requests that we've sent. A queued user may still succeed once we send its request.
+	auto iterator = fRequestMap.find(userID.ToUint64());
+	if ((iterator == fRequestMap.end()) || (iterator->second.State != RequestState::kInFlight))
+	{
+		return;
+	}
+	const char* failureReasonName = "undefined";
+	if (galaxy::api::IUserInformationRetrieveListener::FAILURE_REASON_CONNECTION_FAILURE == failureReason)
+	{
+		failureReasonName = "connectionFailure";
+	}
+	CompleteRequest(userID, failureReasonName);
+}
+
+void UserInformationScheduler::CompleteRequest(const galaxy::api::GalaxyID& userId, const char* failureReasonName)
+{
+	// Remove the request from the scheduler.
+	auto iterator = fRequestMap.find(userId.ToUint64());
+	if (iterator != fRequestMap.end())
+	{
+		if (RequestState::kInFlight == iterator->second.State)
+		{
+			fInFlightCount--;
+		}
+		fRequestMap.erase(iterator);
+	}
+
+	// Queue the result to be dispatched to Lua.
+	auto taskPointer = std::make_shared<DispatchUserInformationEventTask>();
+	taskPointer->AcquireEventDataFrom(userId, failureReasonName);
+	fContext.QueueDispatchEventTask(taskPointer);
+}
@@ -0,0 +1,127 @@
+// ----------------------------------------------------------------------------
+//
+// UserInformationScheduler.h
+// Copyright (c) 2016 Corona Labs Inc. All rights reserved.
+// This software may be modified and distributed under the terms
+// of the MIT license.  See the LICENSE file for details.
+//
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <stdint.h>
+#include <unordered_map>
+#include "GalaxyApi.h"
+
+// Forward declarations.
+class RuntimeContext;
+
+
+/**
+  Funnels all of the plugin's IFriends::RequestUserInformation() calls through one queue.
+
+  Requests for the same user are merged while queued or in-flight, users whose information is already
+  available are answered immediately without a backend request, and only a limited number of requests
+  are allowed to be in-flight at a time to avoid being throttled by the GOG backend.
+  Users flagged as "visible" (ie: currently shown on screen) are sent before all other queued users.
+
+  Exactly one "userInformation" event is dispatched to Lua per requested user once the request completes.
+ */
+class UserInformationScheduler : public galaxy::api::GlobalUserInformationRetrieveListener
+{
+	public:
+		/** Maximum number of RequestUserInformation() calls allowed to be awaiting a response. */
+		static const int kMaxConcurrentRequests;
+
+		/** Maximum number of new RequestUserInformation() calls issued per frame. */
+		static const int kMaxRequestsPerFrame;
+
+		/** Number of seconds to wait for a response before freeing up the request's slot. */
+		static const int kRequestTimeoutInSeconds;
+
+		/**
+		  Creates a new scheduler.
+		  @param context The runtime context that will dispatch this scheduler's events to Lua.
+		 */
+		UserInformationScheduler(RuntimeContext& context);
+
+		virtual ~UserInformationScheduler();
+
+		/**
+		  Queues a request for the given user's information.
+		  @param userId The user to fetch information for.
+		  @param isVisible Set true if the user is currently displayed on screen, in which case the request
+		                   will be sent before all users not flagged as visible.
+		  @return Returns true if the request was accepted. Returns false if given an invalid user ID.
+		 */
+		bool Request(const galaxy::api::GalaxyID& userId, bool isVisible);
+
+		/**
+		  Issues queued requests while under the concurrency limit and expires stale in-flight requests.
+		  Expected to be called once per frame after galaxy::api::ProcessData().
+		 */
+		void Process();
+
+		/** Gets the number of users currently waiting to be sent to the backend. */
+		int GetQueuedCount() const;
+
+		/** Gets the number of requests sent to the backend which have not been responded to yet. */
+		int GetInFlightCount() const;
+
+		virtual void OnUserInformationRetrieveSuccess(galaxy::api::GalaxyID userID);
+		virtual void OnUserInformationRetrieveFailure(galaxy::api::GalaxyID userID, FailureReason failureReason);
+
+	private:
+		/** Copy constructor deleted to prevent it from being called. */
+		UserInformationScheduler(const UserInformationScheduler&) = delete;
+
+		/** Method deleted to prevent the copy operator from being used. */
+		void operator=(const UserInformationScheduler&) = delete;
+
+		/** Indicates where a requested user currently is in the scheduler's pipeline. */
+		enum class RequestState
+		{
+			kQueued,
+			kQueuedVisible,
+			kInFlight
+		};
+
+		struct RequestInfo
+		{
+			RequestState State;
+			std::chrono::steady_clock::time_point SentTime;
+		};
+
+		/**
+		  Removes the given user from the scheduler and dispatches its "userInformation" event to Lua.
+		  @param userId The user whose request has completed.
+		  @param failureReasonName Set to null for success or to a failure description for errors.
+		 */
+		void CompleteRequest(const galaxy::api::GalaxyID& userId, const char* failureReasonName);
+
+		/** The runtime context used to dispatch events to Lua. */
+		RuntimeContext& fContext;
+
+		/**
+		  Stores the state of every queued and in-flight request, keyed by GalaxyID::ToUint64().
+		  Used to merge duplicate requests for the same user.
+		 */
+		std::unordered_map<uint64_t, RequestInfo> fRequestMap;
+
+		/**
+		  Users flagged as visible. Entries are lazily discarded if their state in "fRequestMap" is no longer
+		  kQueuedVisible when popped.
+		 */
+		std::deque<uint64_t> fVisibleQueue;
+
+		/**
+		  All other users. Entries are lazily discarded if their state in "fRequestMap" is no longer
+		  kQueued when popped, such as after having been promoted to the visible queue.
+		 */
+		std::deque<uint64_t> fNormalQueue;
+
+		/** Number of entries in "fRequestMap" flagged as kInFlight. */
+		int fInFlightCount;
+};